@@ -11,7 +11,6 @@
 
 #include <string.h>
 #include <math.h>
-#include <pthread.h>
 
 #include "filter.h"
 #include "frame.h"
@@ -36,26 +35,10 @@ static const mmx_t mm_cpool[] = { { 0x0000000000000000LL }, };
 #define mmx_t int
 #endif
 
-struct DeintThread
-{
-    int       ready;
-    pthread_t id;
-    int       exists;
-};
-
 typedef struct ThisFilter
 {
     VideoFilter vf;
 
-    struct DeintThread *threads;
-    VideoFrame *frame;
-    int         field;
-    int         ready;
-    int         kill_threads;
-    int         actual_threads;
-    int         requested_threads;
-    pthread_mutex_t mutex;
-
     int       skipchroma;
     int       mm_flags;
     int       width;
@@ -208,6 +191,92 @@ static void line_filter_mmx(uint8_t *dst, int width, int start_width,
 }
 #endif
 
+#if HAVE_SSE2_INTRINSICS
+/* The kernel on 16 pixels, in 16 bits so negative sums clamp to 0 like the
+ * C version rather than saturating part way through as the MMX one does. */
+static inline __m128i sse2_kernel(__m128i src1, __m128i src2, __m128i src3,
+                                  __m128i src4, __m128i src5)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i out[2];
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        __m128i s1 = i ? _mm_unpackhi_epi8(src1, zero) :
+                         _mm_unpacklo_epi8(src1, zero);
+        __m128i s2 = i ? _mm_unpackhi_epi8(src2, zero) :
+                         _mm_unpacklo_epi8(src2, zero);
+        __m128i s3 = i ? _mm_unpackhi_epi8(src3, zero) :
+                         _mm_unpacklo_epi8(src3, zero);
+        __m128i s4 = i ? _mm_unpackhi_epi8(src4, zero) :
+                         _mm_unpacklo_epi8(src4, zero);
+        __m128i s5 = i ? _mm_unpackhi_epi8(src5, zero) :
+                         _mm_unpacklo_epi8(src5, zero);
+        __m128i v  = _mm_slli_epi16(_mm_add_epi16(s2, s4), 2);
+        v = _mm_add_epi16(v, _mm_slli_epi16(s3, 1));
+        v = _mm_sub_epi16(v, _mm_add_epi16(s1, s5));
+        out[i] = _mm_srli_epi16(_mm_max_epi16(v, zero), 3);
+    }
+
+    return _mm_packus_epi16(out[0], out[1]);
+}
+
+/* 0xff where |src3 - src2| <= 11, i.e. where the line is left alone */
+static inline __m128i sse2_keep(__m128i src2, __m128i src3)
+{
+    __m128i diff = _mm_or_si128(_mm_subs_epu8(src3, src2),
+                                _mm_subs_epu8(src2, src3));
+    return _mm_cmpeq_epi8(_mm_subs_epu8(diff, _mm_set1_epi8(11)),
+                          _mm_setzero_si128());
+}
+
+#define LOAD16(mem) _mm_loadu_si128((const __m128i*)(mem))
+
+static void line_filter_sse2_fast(uint8_t *dst, int width, int start_width,
+                                  uint8_t *buf, uint8_t *src2, uint8_t *src3,
+                                  uint8_t *src4, uint8_t *src5)
+{
+    int X;
+    for (X = start_width; X < width - 15; X += 16)
+    {
+        __m128i s1   = LOAD16(&buf[X]);
+        __m128i s2   = LOAD16(&src2[X]);
+        __m128i s3   = LOAD16(&src3[X]);
+        __m128i keep = sse2_keep(s2, s3);
+        __m128i out  = sse2_kernel(s1, s2, s3, LOAD16(&src4[X]),
+                                   LOAD16(&src5[X]));
+        _mm_storeu_si128((__m128i*)&buf[X], s3);
+        out = _mm_or_si128(_mm_and_si128(keep, LOAD16(&dst[X])),
+                           _mm_andnot_si128(keep, out));
+        _mm_storeu_si128((__m128i*)&dst[X], out);
+    }
+
+    line_filter_c_fast(dst, width, X, buf, src2, src3, src4, src5);
+}
+
+static void line_filter_sse2(uint8_t *dst, int width, int start_width,
+                             uint8_t *src1, uint8_t *src2, uint8_t *src3,
+                             uint8_t *src4, uint8_t *src5)
+{
+    int X;
+    for (X = start_width; X < width - 15; X += 16)
+    {
+        __m128i s2   = LOAD16(&src2[X]);
+        __m128i s3   = LOAD16(&src3[X]);
+        __m128i keep = sse2_keep(s2, s3);
+        __m128i out  = sse2_kernel(LOAD16(&src1[X]), s2, s3,
+                                   LOAD16(&src4[X]), LOAD16(&src5[X]));
+        out = _mm_or_si128(_mm_and_si128(keep, s3),
+                           _mm_andnot_si128(keep, out));
+        _mm_storeu_si128((__m128i*)&dst[X], out);
+    }
+
+    line_filter_c(dst, width, X, src1, src2, src3, src4, src5);
+}
+#undef LOAD16
+#endif /* HAVE_SSE2_INTRINSICS */
+
 static void store_ref(struct ThisFilter *p, uint8_t *src, int src_offsets[3],
                       int src_stride[3], int width, int height)
 {
@@ -417,52 +486,17 @@ static void filter_func(struct ThisFilter *p, uint8_t *dst, int dst_offsets[3],
 #endif
 }
 
-static void *KernelThread(void *args)
-{
-    ThisFilter *filter = (ThisFilter*)args;
-
-    pthread_mutex_lock(&(filter->mutex));
-    int num = filter->actual_threads;
-    filter->actual_threads = num + 1;
-    pthread_mutex_unlock(&(filter->mutex));
-
-    while (!filter->kill_threads)
-    {
-        usleep(1000);
-        if (filter->ready &&
-            filter->frame != NULL &&
-            filter->threads[num].ready)
-        {
-            filter_func(
-                filter, filter->frame->buf, filter->frame->offsets,
-                filter->frame->pitches, filter->frame->width,
-                filter->frame->height, filter->field,
-                filter->frame->top_field_first, filter->double_rate,
-                filter->dirty_frame, num, filter->actual_threads);
-
-            pthread_mutex_lock(&(filter->mutex));
-            filter->ready = filter->ready - 1;
-            filter->threads[num].ready = 0;
-            pthread_mutex_unlock(&(filter->mutex));
-        }
-    }
-    pthread_exit(NULL);
-    return NULL;
-}
-
-static int KernelDeint(VideoFilter *f, VideoFrame *frame, int field)
+static int KernelPrepare(VideoFilter *f, VideoFrame *frame, int field)
 {
     ThisFilter *filter = (ThisFilter *) f;
-    TF_VARS;
+    (void) field;
 
     if (!AllocFilter(filter, frame->width, frame->height))
     {
         LOG(VB_GENERAL, LOG_ERR, "KernelDeint: failed to allocate buffers.");
-        return -1;
+        return 0;
     }
 
-    TF_START;
-
     filter->dirty_frame = 1;
     if (filter->last_framenr == frame->frameNumber)
     {
@@ -480,32 +514,39 @@ static int KernelDeint(VideoFilter *f, VideoFrame *frame, int field)
         }
     }
 
-    if (filter->actual_threads > 1 && filter->double_rate)
-    {
-        int i;
-        for (i = 0; i < filter->actual_threads; i++)
-            filter->threads[i].ready = 1;
-        filter->frame = frame;
-        filter->field = field;
-        filter->ready = filter->actual_threads;
-        i = 0;
-        while (filter->ready > 0 && i < 1000)
-        {
-            usleep(1000);
-            i++;
-        }
-    }
-    else
-    {
-        filter_func(
-            filter, frame->buf, frame->offsets, frame->pitches,
-            frame->width, frame->height, field, frame->top_field_first,
-            filter->double_rate, filter->dirty_frame, 0, 1);
-    }
-
     filter->last_framenr = frame->frameNumber;
 
-    TF_END(filter, "KernelDeint: ");
+    /* single rate filtering works in place, so it can't be split up */
+    if (!filter->double_rate)
+        return 1;
+
+    /* every band needs a few lines to be worth a thread */
+    return (frame->height / 32 > 1) ? frame->height / 32 : 1;
+}
+
+static void KernelSlice(VideoFilter *f, VideoFrame *frame, int field,
+                        int this_slice, int total_slices)
+{
+    ThisFilter *filter = (ThisFilter *) f;
+
+    filter_func(
+        filter, frame->buf, frame->offsets, frame->pitches,
+        frame->width, frame->height, field, frame->top_field_first,
+        filter->double_rate, filter->dirty_frame, this_slice, total_slices);
+}
+
+static int KernelDeint(VideoFilter *f, VideoFrame *frame, int field)
+{
+    TF_VARS;
+
+    TF_START;
+
+    if (KernelPrepare(f, frame, field) < 1)
+        return -1;
+
+    KernelSlice(f, frame, field, 0, 1);
+
+    TF_END((ThisFilter *) f, "KernelDeint: ");
 
     return 0;
 }
@@ -522,15 +563,6 @@ static void CleanupKernelDeintFilter(VideoFilter *f)
             free(*p);
         *p= NULL;
     }
-
-    if (filter->threads != NULL)
-    {
-        filter->kill_threads = 1;
-        for (i = 0; i < filter->requested_threads; i++)
-            if (filter->threads[i].exists)
-                pthread_join(filter->threads[i].id, NULL);
-        free(filter->threads);
-    }
 }
 
 static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
@@ -568,6 +600,13 @@ static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
         filter->line_filter_fast = &line_filter_mmx_fast;
     }
 #endif
+#if HAVE_SSE2_INTRINSICS
+    if (filter->mm_flags & AV_CPU_FLAG_SSE2)
+    {
+        filter->line_filter = &line_filter_sse2;
+        filter->line_filter_fast = &line_filter_sse2_fast;
+    }
+#endif
 
     filter->skipchroma   = 0;
     filter->width        = 0;
@@ -588,70 +627,6 @@ static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
     filter->vf.filter  = &KernelDeint;
     filter->vf.cleanup = &CleanupKernelDeintFilter;
 
-    filter->frame = NULL;
-    filter->field = 0;
-    filter->ready = 0;
-    filter->kill_threads = 0;
-    filter->actual_threads  = 0;
-    filter->requested_threads  = threads;
-    filter->threads = NULL; 
-
-    if (filter->requested_threads > 1)
-    {
-        filter->threads = (struct DeintThread *) calloc(threads,
-                          sizeof(struct DeintThread));
-        if (filter->threads == NULL)
-        {
-            LOG(VB_GENERAL, LOG_ERR, "KernelDeint: failed to allocate memory "
-                    "for threads - falling back to existing, single thread.");
-            filter->requested_threads = 1;
-        }
-    }
-
-    if (filter->requested_threads > 1)
-    {
-        pthread_mutex_init(&(filter->mutex), NULL);
-        int success = 0;
-        for (int i = 0; i < filter->requested_threads; i++)
-        {
-            if (pthread_create(&(filter->threads[i].id), NULL,
-                               KernelThread, (void*)filter) != 0)
-                filter->threads[i].exists = 0;
-            else
-            {
-                success++;
-                filter->threads[i].exists = 1;
-            }
-        }
-
-        if (success < filter->requested_threads)
-        {
-            LOG(VB_GENERAL, LOG_NOTICE,
-                "KernelDeint: failed to create all threads - "
-                "falling back to existing, single thread.");
-        }
-        else
-        {
-            int timeout = 0;
-            while (filter->actual_threads != filter->requested_threads)
-            {
-                timeout++;
-                if (timeout > 5000)
-                {
-                    LOG(VB_GENERAL, LOG_NOTICE,
-                        "KernelDeint: waited too long for "
-                        "threads to start.- continuing.");
-                    break;
-                }
-                usleep(1000);
-            }
-            LOG(VB_PLAYBACK, LOG_INFO, "KernelDeint: Created threads.");
-        }
-    }
-
-    if (filter->actual_threads < 1 )
-        LOG(VB_PLAYBACK, LOG_INFO, "KernelDeint: Using existing thread.");
-
     return (VideoFilter *) filter;
 }
 
@@ -669,7 +644,9 @@ const FilterInfo filter_table[] =
         descript:   (char*)"combines data from several fields to deinterlace "
                     "with less motion blur",
         formats:    FmtList,
-        libname:    NULL
+        libname:    NULL,
+        filter_prepare: &KernelPrepare,
+        filter_slice:   &KernelSlice
     },
     {
         filter_init: &NewKernelDeintFilter,
@@ -677,7 +654,9 @@ const FilterInfo filter_table[] =
         descript:   (char*)"combines data from several fields to deinterlace "
                     "with less motion blur",
         formats:    FmtList,
-        libname:    NULL
+        libname:    NULL,
+        filter_prepare: &KernelPrepare,
+        filter_slice:   &KernelSlice
     },
     FILT_NULL
 };
@@ -29,6 +29,7 @@ typedef struct LBFilter
 
     /* functions and variables below here considered "private" */
     int mm_flags;
+    int use_sse2;
     void (*subfilter)(unsigned char *, int);
     TF_STRUCT;
 } LBFilter;
@@ -284,6 +285,46 @@ void linearBlend(unsigned char *src, int stride)
     }
 }
 
+#if HAVE_SSE2_INTRINSICS
+/* linearBlend on 16 columns. pavgb rounds up, which matches the second
+ * average of the C version; the first one rounds down. */
+static void linearBlendSSE2(unsigned char *src, int stride)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i l[10];
+    int i;
+
+    for (i = 0; i < 10; i++)
+        l[i] = _mm_loadu_si128((const __m128i*)&src[stride * i]);
+
+    for (i = 0; i < 8; i++)
+    {
+        __m128i a = l[i], c = l[i + 2];
+        __m128i ac = _mm_sub_epi8(_mm_avg_epu8(a, c),
+                                  _mm_and_si128(_mm_xor_si128(a, c), one));
+        _mm_storeu_si128((__m128i*)&src[stride * i],
+                         _mm_avg_epu8(ac, l[i + 1]));
+    }
+}
+#endif /* HAVE_SSE2_INTRINSICS */
+
+/* Blends the 8 lines starting at src, across the whole width */
+static void blendLines(LBFilter *vf, unsigned char *src, int stride)
+{
+    int x = 0;
+
+#if HAVE_SSE2_INTRINSICS
+    if (vf->use_sse2)
+    {
+        for (; x + 16 <= stride; x += 16)
+            linearBlendSSE2(src + x, stride);
+    }
+#endif
+
+    for (; x < stride; x += 8)
+        (vf->subfilter)(src + x, stride);
+}
+
 static int linearBlendFilter(VideoFilter *f, VideoFrame *frame, int  field)
 {
     (void)field;
@@ -291,8 +332,7 @@ static int linearBlendFilter(VideoFilter *f, VideoFrame *frame, int  field)
     unsigned char *yptr = frame->buf + frame->offsets[0];
     int stride = frame->pitches[0];
     int ymax = height - 8;
-    int x,y;
-    unsigned char *src;
+    int y;
     unsigned char *uoff = frame->buf + frame->offsets[1];
     unsigned char *voff = frame->buf + frame->offsets[2];
     LBFilter *vf = (LBFilter *)f;
@@ -301,27 +341,15 @@ static int linearBlendFilter(VideoFilter *f, VideoFrame *frame, int  field)
     TF_START;
 
     for (y = 0; y < ymax; y+=8)
-    {  
-        for (x = 0; x < stride; x+=8)
-        {
-            src = yptr + x + y * stride;
-            (vf->subfilter)(src, stride);  
-        }
-    }
+        blendLines(vf, yptr + y * stride, stride);
  
     stride = frame->pitches[1];
     ymax = height / 2 - 8;
   
     for (y = 0; y < ymax; y += 8)
     {
-        for (x = 0; x < stride; x += 8)
-        {
-            src = uoff + x + y * stride;
-            (vf->subfilter)(src, stride);
-       
-            src = voff + x + y * stride;
-            (vf->subfilter)(src, stride);
-        }
+        blendLines(vf, uoff + y * stride, stride);
+        blendLines(vf, voff + y * stride, stride);
     }
 
 #if HAVE_MMX || HAVE_AMD3DNOW
@@ -364,6 +392,16 @@ static VideoFilter *new_filter(VideoFrameType inpixfmt,
     else if (HAVE_ALTIVEC && filter->mm_flags & AV_CPU_FLAG_ALTIVEC)
         filter->vf.filter = &linearBlendFilterAltivec;
 
+    /* Exactly matches the C version, unlike the MMX and 3DNow! ones */
+    filter->use_sse2 = 0;
+#if HAVE_SSE2_INTRINSICS
+    if (filter->mm_flags & AV_CPU_FLAG_SSE2)
+    {
+        filter->subfilter = &linearBlend;
+        filter->use_sse2 = 1;
+    }
+#endif
+
     filter->vf.cleanup = NULL;
     TF_INIT(filter);
     return (VideoFilter *)filter;
@@ -1,5 +1,6 @@
 /* mm_arch.h - Multi-media CPU acceleration for several architectures */
 
+#include "libavutil/cpu.h"
 #include "libavutil/mem.h"
 #include "libavcodec/dsputil.h"
 
@@ -14,3 +15,12 @@
 #else 
   #define emms()    ; 
 #endif
+
+/* SSE2 line functions are written with intrinsics.  Every x86-64 compiler
+ * supports those, 32 bit ones only when told to build for an SSE2 CPU. */
+#if HAVE_SSE && (ARCH_X86_64 || defined(__SSE2__))
+  #define HAVE_SSE2_INTRINSICS 1
+  #include <emmintrin.h>
+#else
+  #define HAVE_SSE2_INTRINSICS 0
+#endif
@@ -29,6 +29,8 @@
 #include "ffmpeg-mmx.h"
 #endif
 
+#include "../mm_arch.h"
+
 //Regular filter
 #define LUMA_THRESHOLD_DEFAULT 15
 #define CHROMA_THRESHOLD_DEFAULT 25
@@ -441,6 +443,113 @@ static int quickdnr2MMX(VideoFilter *f, VideoFrame *frame, int field)
 }
 #endif /* MMX */
 
+#if HAVE_SSE2_INTRINSICS
+/* One plane, 16 bytes at a time. Unlike the MMX versions these give exactly
+ * the output of quickdnr and quickdnr2; without double_threshold every
+ * difference below thr1 is averaged, as in quickdnr. */
+static void quickdnr_plane_sse2(uint8_t *avg, uint8_t *buf, int sz,
+                                int thr1, int thr2, int double_threshold)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i one   = _mm_set1_epi8(1);
+    const __m128i ones  = _mm_cmpeq_epi8(zero, zero);
+    const __m128i vthr1 = _mm_set1_epi8(thr1);
+    const __m128i vthr2 = _mm_set1_epi8(thr2);
+    int y;
+
+    for (y = 0; y < sz - 15; y += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)&avg[y]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&buf[y]);
+        __m128i t = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        /* (a + b) >> 1, pavgb rounds up */
+        __m128i mean = _mm_sub_epi8(_mm_avg_epu8(a, b),
+                                    _mm_and_si128(_mm_xor_si128(a, b), one));
+        /* 0xff where t < thr1 and where t > thr2 */
+        __m128i below = _mm_andnot_si128(
+            _mm_cmpeq_epi8(_mm_subs_epu8(vthr1, t), zero), ones);
+        __m128i above = double_threshold ? _mm_andnot_si128(
+            _mm_cmpeq_epi8(_mm_subs_epu8(t, vthr2), zero), ones) : ones;
+        __m128i out;
+
+        out = _mm_or_si128(_mm_and_si128(above, mean),
+                           _mm_andnot_si128(above, a));
+        out = _mm_or_si128(_mm_and_si128(below, out),
+                           _mm_andnot_si128(below, b));
+
+        _mm_storeu_si128((__m128i*)&avg[y], out);
+        _mm_storeu_si128((__m128i*)&buf[y], out);
+    }
+
+    for (; y < sz; y++)
+    {
+        int t = abs(avg[y] - buf[y]);
+        if (t < thr1)
+        {
+            if (!double_threshold || t > thr2)
+                avg[y] = (avg[y] + buf[y]) >> 1;
+            buf[y] = avg[y];
+        }
+        else
+        {
+            avg[y] = buf[y];
+        }
+    }
+}
+
+static int quickdnrSSE2(VideoFilter *f, VideoFrame *frame, int field)
+{
+    (void)field;
+    ThisFilter *tf = (ThisFilter *)f;
+    int thr1[3], thr2[3], height[3];
+    uint8_t *avg[3], *buf[3];
+    int i;
+
+    TF_VARS;
+
+    TF_START;
+
+    if (!init_avg(tf, frame))
+        return 0;
+
+    init_vars(tf, frame, thr1, thr2, height, avg, buf);
+
+    for (i = 0; i < 3; i++)
+        quickdnr_plane_sse2(avg[i], buf[i], height[i] * frame->pitches[i],
+                            thr1[i], thr2[i], 0);
+
+    TF_END(tf, "QuickDNRsse2: ");
+
+    return 0;
+}
+
+static int quickdnr2SSE2(VideoFilter *f, VideoFrame *frame, int field)
+{
+    (void)field;
+    ThisFilter *tf = (ThisFilter *)f;
+    int thr1[3], thr2[3], height[3];
+    uint8_t *avg[3], *buf[3];
+    int i;
+
+    TF_VARS;
+
+    TF_START;
+
+    if (!init_avg(tf, frame))
+        return 0;
+
+    init_vars(tf, frame, thr1, thr2, height, avg, buf);
+
+    for (i = 0; i < 3; i++)
+        quickdnr_plane_sse2(avg[i], buf[i], height[i] * frame->pitches[i],
+                            thr1[i], thr2[i], 1);
+
+    TF_END(tf, "QuickDNR2sse2: ");
+
+    return 0;
+}
+#endif /* HAVE_SSE2_INTRINSICS */
+
 static void cleanup(VideoFilter *vf)
 {
     ThisFilter *tf = (ThisFilter*) vf;
@@ -554,6 +663,10 @@ static VideoFilter *new_filter(VideoFrameType inpixfmt,
         }
     }
 #endif
+#if HAVE_SSE2_INTRINSICS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_SSE2)
+        filter->vf.filter = (double_threshold) ? &quickdnr2SSE2 : &quickdnrSSE2;
+#endif
 
     TF_INIT(filter);
 
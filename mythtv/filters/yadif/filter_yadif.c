@@ -31,7 +31,6 @@
 
 #include <string.h>
 #include <math.h>
-#include <pthread.h>
 
 #include "filter.h"
 #include "frame.h"
@@ -52,26 +51,10 @@
 
 static void* (*fast_memcpy)(void * to, const void * from, size_t len);
 
-struct DeintThread
-{
-    int       ready;
-    pthread_t id;
-    int       exists;
-};
-
 typedef struct ThisFilter
 {
     VideoFilter vf;
 
-    struct DeintThread *threads;
-    VideoFrame *frame;
-    int         field;
-    int         ready;
-    int         kill_threads;
-    int         actual_threads;
-    int         requested_threads;
-    pthread_mutex_t mutex;
-
     long long last_framenr;
 
     uint8_t *ref[4][3];
@@ -444,6 +427,101 @@ static void filter_line_c(struct ThisFilter *p, uint8_t *dst,
     }
 }
 
+#if HAVE_SSE2_INTRINSICS
+#define LOAD8(mem) _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(mem)), zero)
+#define ABSDIFF(a,b) _mm_max_epi16(_mm_sub_epi16(a, b), _mm_sub_epi16(b, a))
+#define AVG(a,b) _mm_srli_epi16(_mm_add_epi16(a, b), 1)
+#define BLEND(mask,a,b) _mm_or_si128(_mm_and_si128(mask, a), \
+                                     _mm_andnot_si128(mask, b))
+
+/* Same arithmetic as filter_line_c on 8 pixels at a time, widened to 16 bits
+ * so the result is identical. The nested CHECKs become masks: the second
+ * direction is only tried where the first one improved the score. */
+static void filter_line_sse2(struct ThisFilter *p, uint8_t *dst,
+                             uint8_t *prev, uint8_t *cur, uint8_t *next,
+                             int w, int refs, int parity)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi16(1);
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    int x;
+
+    for (x = 0; x + 8 <= w; x += 8)
+    {
+        __m128i c  = LOAD8(&cur[-refs]);
+        __m128i e  = LOAD8(&cur[+refs]);
+        __m128i p2 = LOAD8(&prev2[0]);
+        __m128i n2 = LOAD8(&next2[0]);
+        __m128i d  = AVG(p2, n2);
+        __m128i temporal_diff0 = ABSDIFF(p2, n2);
+        __m128i temporal_diff1 = _mm_srli_epi16(_mm_add_epi16(
+            ABSDIFF(LOAD8(&prev[-refs]), c), ABSDIFF(LOAD8(&prev[+refs]), e)), 1);
+        __m128i temporal_diff2 = _mm_srli_epi16(_mm_add_epi16(
+            ABSDIFF(LOAD8(&next[-refs]), c), ABSDIFF(LOAD8(&next[+refs]), e)), 1);
+        __m128i diff = _mm_max_epi16(_mm_max_epi16(
+            _mm_srli_epi16(temporal_diff0, 1), temporal_diff1), temporal_diff2);
+        __m128i spatial_pred  = AVG(c, e);
+        __m128i spatial_score = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(
+            ABSDIFF(LOAD8(&cur[-refs-1]), LOAD8(&cur[+refs-1])),
+            ABSDIFF(c, e)),
+            ABSDIFF(LOAD8(&cur[-refs+1]), LOAD8(&cur[+refs+1]))), one);
+        __m128i score, mask, b, f, dc, de, max, min;
+
+#define SCORE(j) \
+        _mm_add_epi16(_mm_add_epi16( \
+            ABSDIFF(LOAD8(&cur[-refs-1+j]), LOAD8(&cur[+refs-1-j])), \
+            ABSDIFF(LOAD8(&cur[-refs  +j]), LOAD8(&cur[+refs  -j]))), \
+            ABSDIFF(LOAD8(&cur[-refs+1+j]), LOAD8(&cur[+refs+1-j])))
+#undef CHECK
+#define CHECK(j, outer) \
+        score = SCORE(j); \
+        mask  = _mm_and_si128(outer, _mm_cmplt_epi16(score, spatial_score)); \
+        spatial_score = BLEND(mask, score, spatial_score); \
+        spatial_pred  = BLEND(mask, AVG(LOAD8(&cur[-refs+j]), \
+                                        LOAD8(&cur[+refs-j])), spatial_pred);
+
+        CHECK(-1, _mm_cmpeq_epi16(zero, zero)) CHECK(-2, mask)
+        CHECK( 1, _mm_cmpeq_epi16(zero, zero)) CHECK( 2, mask)
+#undef CHECK
+#undef SCORE
+
+        b   = AVG(LOAD8(&prev2[-2*refs]), LOAD8(&next2[-2*refs]));
+        f   = AVG(LOAD8(&prev2[+2*refs]), LOAD8(&next2[+2*refs]));
+        dc  = _mm_sub_epi16(d, c);
+        de  = _mm_sub_epi16(d, e);
+        max = _mm_max_epi16(_mm_max_epi16(de, dc),
+                            _mm_min_epi16(_mm_sub_epi16(b, c),
+                                          _mm_sub_epi16(f, e)));
+        min = _mm_min_epi16(_mm_min_epi16(de, dc),
+                            _mm_max_epi16(_mm_sub_epi16(b, c),
+                                          _mm_sub_epi16(f, e)));
+        diff = _mm_max_epi16(_mm_max_epi16(diff, min),
+                             _mm_sub_epi16(zero, max));
+
+        /* diff is never negative, so clamping both ways matches the C */
+        spatial_pred = _mm_min_epi16(spatial_pred, _mm_add_epi16(d, diff));
+        spatial_pred = _mm_max_epi16(spatial_pred, _mm_sub_epi16(d, diff));
+
+        _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(spatial_pred, zero));
+
+        dst   += 8;
+        cur   += 8;
+        prev  += 8;
+        next  += 8;
+        prev2 += 8;
+        next2 += 8;
+    }
+
+    if (x < w)
+        filter_line_c(p, dst, prev, cur, next, w - x, refs, parity);
+}
+#undef LOAD8
+#undef ABSDIFF
+#undef AVG
+#undef BLEND
+#endif /* HAVE_SSE2_INTRINSICS */
+
 static void filter_func(struct ThisFilter *p, uint8_t *dst, int dst_offsets[3],
                         int dst_stride[3], int width, int height, int parity,
                         int tff, int this_slice, int total_slices)
@@ -493,10 +571,10 @@ static void filter_func(struct ThisFilter *p, uint8_t *dst, int dst_offsets[3],
 #endif
 }
 
-static int YadifDeint (VideoFilter * f, VideoFrame * frame, int field)
+static int YadifPrepare(VideoFilter *f, VideoFrame *frame, int field)
 {
     ThisFilter *filter = (ThisFilter *) f;
-    TF_VARS;
+    (void) field;
 
     AllocFilter(filter, frame->width, frame->height);
 
@@ -508,31 +586,34 @@ static int YadifDeint (VideoFilter * f, VideoFrame * frame, int field)
                   frame->pitches, frame->width, frame->height);
     }
 
-    if (filter->actual_threads < 1)
-    {
-        filter_func(
-            filter, frame->buf, frame->offsets, frame->pitches,
-            frame->width, frame->height, field, frame->top_field_first,
-            0, 1);
-    }
-    else
-    {
-        int i;
-        for (i = 0; i < filter->actual_threads; i++)
-            filter->threads[i].ready = 1;
-        filter->field = field;
-        filter->frame = frame;
-        filter->ready = filter->actual_threads;
-        i = 0;
-        while (filter->ready > 0 && i < 1000)
-        {
-            usleep(1000);
-            i++;
-        }
-    }
-
     filter->last_framenr = frame->frameNumber;
 
+    /* every band needs a few lines to be worth a thread */
+    return (frame->height / 32 > 1) ? frame->height / 32 : 1;
+}
+
+static void YadifSlice(VideoFilter *f, VideoFrame *frame, int field,
+                       int this_slice, int total_slices)
+{
+    filter_func(
+        (ThisFilter *) f, frame->buf, frame->offsets, frame->pitches,
+        frame->width, frame->height, field, frame->top_field_first,
+        this_slice, total_slices);
+}
+
+static int YadifDeint (VideoFilter * f, VideoFrame * frame, int field)
+{
+    TF_VARS;
+
+    TF_START;
+
+    if (YadifPrepare(f, frame, field) < 1)
+        return -1;
+
+    YadifSlice(f, frame, field, 0, 1);
+
+    TF_END((ThisFilter *) f, "YadifDeint: ");
+
     return 0;
 }
 
@@ -542,15 +623,6 @@ static void CleanupYadifDeintFilter (VideoFilter * filter)
     int i;
     ThisFilter* f = (ThisFilter*)filter;
 
-    if (f->threads != NULL)
-    {
-        f->kill_threads = 1;
-        for (i = 0; i < f->requested_threads; i++)
-            if (f->threads[i].exists)
-                pthread_join(f->threads[i].id, NULL);
-        free(f->threads);
-    }
-
     for (i = 0; i < 3*3; i++)
     {
         uint8_t **p= &f->ref[i%3][i/3];
@@ -559,38 +631,6 @@ static void CleanupYadifDeintFilter (VideoFilter * filter)
     }
 }
 
-static void *YadifThread(void *args)
-{
-    ThisFilter *filter = (ThisFilter*)args;
-
-    pthread_mutex_lock(&(filter->mutex));
-    int num = filter->actual_threads;
-    filter->actual_threads = num + 1;
-    pthread_mutex_unlock(&(filter->mutex));
-
-    while (!filter->kill_threads)
-    {
-        usleep(1000);
-        if (filter->ready &&
-            filter->frame != NULL &&
-            filter->threads[num].ready)
-        {
-            filter_func(
-                filter, filter->frame->buf, filter->frame->offsets,
-                filter->frame->pitches, filter->frame->width,
-                filter->frame->height, filter->field,
-                filter->frame->top_field_first, num, filter->actual_threads);
-
-            pthread_mutex_lock(&(filter->mutex));
-            filter->ready = filter->ready - 1;
-            filter->threads[num].ready = 0;
-            pthread_mutex_unlock(&(filter->mutex));
-        }
-    }
-    pthread_exit(NULL);
-    return NULL;
-}
-
 static VideoFilter * YadifDeintFilter(VideoFrameType inpixfmt,
                                       VideoFrameType outpixfmt,
                                       int *width, int *height, char *options,
@@ -599,6 +639,7 @@ static VideoFilter * YadifDeintFilter(VideoFrameType inpixfmt,
     ThisFilter *filter;
     (void) height;
     (void) options;
+    (void) threads;
 
     fprintf(stderr, "YadifDeint: In-Pixformat = %d Out-Pixformat=%d\n",
             inpixfmt, outpixfmt);
@@ -618,10 +659,10 @@ static VideoFilter * YadifDeintFilter(VideoFrameType inpixfmt,
 
 #if HAVE_MMX
     filter->mm_flags = av_get_cpu_flags();
-    TF_INIT(filter);
 #else
     filter->mm_flags = 0;
 #endif
+    TF_INIT(filter);
 
     filter->filter_line = filter_line_c;
 #if HAVE_MMX
@@ -629,7 +670,12 @@ static VideoFilter * YadifDeintFilter(VideoFrameType inpixfmt,
     {
         filter->filter_line = filter_line_mmx2;
     }
-
+#endif
+#if HAVE_SSE2_INTRINSICS
+    if (filter->mm_flags & AV_CPU_FLAG_SSE2)
+        filter->filter_line = filter_line_sse2;
+#endif
+#if HAVE_MMX
     if (filter->mm_flags & AV_CPU_FLAG_SSE2)
         fast_memcpy=fast_memcpy_SSE;
     else if (filter->mm_flags & AV_CPU_FLAG_MMX2)
@@ -645,72 +691,6 @@ static VideoFilter * YadifDeintFilter(VideoFrameType inpixfmt,
     filter->vf.filter = &YadifDeint;
     filter->vf.cleanup = &CleanupYadifDeintFilter;
 
-    filter->frame = NULL;
-    filter->field = 0;
-    filter->ready = 0;
-    filter->kill_threads = 0;
-    filter->actual_threads  = 0;
-    filter->requested_threads  = threads;
-    filter->threads = NULL;
-
-    if (filter->requested_threads > 1)
-    {
-        filter->threads = (struct DeintThread *) calloc(threads,
-                          sizeof(struct DeintThread));
-        if (filter->threads == NULL)
-        {
-            printf("YadifDeint: failed to allocate memory for threads - "
-                   "falling back to existing, single thread.\n");
-            filter->requested_threads = 1;
-        }
-    }
-
-    if (filter->requested_threads > 1)
-    {
-        pthread_mutex_init(&(filter->mutex), NULL);
-        int success = 0;
-        for (int i = 0; i < filter->requested_threads; i++)
-        {
-            if (pthread_create(&(filter->threads[i].id), NULL,
-                               YadifThread, (void*)filter) != 0)
-                filter->threads[i].exists = 0;
-            else
-            {
-                success++;
-                filter->threads[i].exists = 1;
-            }
-        }
-
-        if (success < filter->requested_threads)
-        {
-            printf("YadifDeint: only created %d of %d threads - "
-                   "falling back to existing, single thread.\n"
-                   , success, filter->requested_threads);
-        }
-        else
-        {
-            int timeout = 0;
-            while (filter->actual_threads != filter->requested_threads)
-            {
-                timeout++;
-                if (timeout > 5000)
-                {
-                    printf("YadifDeint: waited too long for threads to start."
-                           "- continuing.\n");
-                    break;
-                }
-                usleep(1000);
-            }
-            printf("yadifdeint: Created %d threads (%d requested)\n",
-                   filter->actual_threads, filter->requested_threads);
-        }
-    }
-
-    if (filter->actual_threads < 1 )
-    {
-        printf("YadifDeint: Using existing thread.\n");
-    }
-
     return (VideoFilter *) filter;
 }
 
@@ -729,7 +709,9 @@ const FilterInfo filter_table[] =
             "combines data from several fields to "
             "deinterlace with less motion blur",
             formats:    FmtList,
-            libname:    NULL
+            libname:    NULL,
+            filter_prepare: &YadifPrepare,
+            filter_slice:   &YadifSlice
     },
     {
             filter_init: &YadifDeintFilter,
@@ -738,7 +720,9 @@ const FilterInfo filter_table[] =
             "combines data from several fields to "
             "deinterlace with less motion blur",
             formats:    FmtList,
-            libname:    NULL
+            libname:    NULL,
+            filter_prepare: &YadifPrepare,
+            filter_slice:   &YadifSlice
     },
     FILT_NULL
 };
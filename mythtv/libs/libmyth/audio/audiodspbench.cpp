@@ -0,0 +1,140 @@
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include "mythlogging.h"
+#include "mythtimer.h"
+#include "samplerate.h"
+#include "SoundTouch.h"
+#include "freesurround.h"
+#include "audiodspbench.h"
+
+#define LOC QString("AudioDSPBench: ")
+
+/// Frames handed to each stage per call
+static const int kBlockFrames = 1024;
+
+/// Returns interleaved stereo noise at about -6dBFS
+static vector<float> noise(int frames)
+{
+    vector<float> buf(frames * 2);
+    for (uint i = 0; i < buf.size(); i++)
+        buf[i] = (float)rand() / RAND_MAX - 0.5f;
+    return buf;
+}
+
+static double rate(int frames, int elapsed)
+{
+    return frames * 1000.0 / max(elapsed, 1);
+}
+
+/** \fn AudioDSPBench::Upmix(int, int, bool)
+ *  \brief Upmixes stereo to 5.1 with FreeSurround in the active simple or
+ *         active linear mode.
+ */
+double AudioDSPBench::Upmix(int samplerate, int frames, bool linear)
+{
+    FreeSurround upmixer(samplerate, true,
+                         linear ? FreeSurround::SurroundModeActiveLinear :
+                                  FreeSurround::SurroundModeActiveSimple);
+    vector<float> in = noise(kBlockFrames);
+    vector<float> out(upmixer.framesPerBlock() * 6);
+    int done = 0;
+
+    MythTimer timer;
+    timer.start();
+
+    while (done < frames)
+    {
+        uint used = 0;
+        while (used < (uint)kBlockFrames)
+        {
+            used += upmixer.putFrames(&in[used * 2], kBlockFrames - used, 2);
+            while (upmixer.numFrames())
+                upmixer.receiveFrames(&out[0], upmixer.framesPerBlock());
+        }
+        done += kBlockFrames;
+    }
+
+    return rate(done, timer.elapsed());
+}
+
+/** \fn AudioDSPBench::Resample(int, int, int, int)
+ *  \brief Resamples stereo audio with libsamplerate, using the same
+ *         converter AudioOutputBase picks for the given SRCQuality.
+ */
+double AudioDSPBench::Resample(int samplerate, int outrate, int frames,
+                               int quality)
+{
+    int error;
+    SRC_STATE *src_ctx = src_new(2 - quality, 2, &error);
+    if (!src_ctx)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Error creating resampler: %1")
+            .arg(src_strerror(error)));
+        return -1;
+    }
+
+    double ratio = (double)outrate / samplerate;
+    vector<float> in = noise(kBlockFrames);
+    vector<float> out(((int)(kBlockFrames * ratio) + 16) * 2);
+    int done = 0;
+
+    SRC_DATA src_data;
+    src_data.src_ratio     = ratio;
+    src_data.end_of_input  = 0;
+    src_data.data_out      = &out[0];
+    src_data.output_frames = out.size() / 2;
+
+    MythTimer timer;
+    timer.start();
+
+    while (done < frames)
+    {
+        src_data.data_in      = &in[0];
+        src_data.input_frames = kBlockFrames;
+        if ((error = src_process(src_ctx, &src_data)))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + QString("Error resampling: %1")
+                .arg(src_strerror(error)));
+            break;
+        }
+        done += kBlockFrames;
+    }
+
+    int elapsed = timer.elapsed();
+    src_delete(src_ctx);
+
+    return error ? -1 : rate(done, elapsed);
+}
+
+/** \fn AudioDSPBench::Timestretch(int, float, int)
+ *  \brief Changes the tempo of stereo audio with SoundTouch, set up the
+ *         way AudioOutputBase sets it up.
+ */
+double AudioDSPBench::Timestretch(int samplerate, float tempo, int frames)
+{
+    soundtouch::SoundTouch stretch;
+    stretch.setSampleRate(samplerate);
+    stretch.setChannels(2);
+    stretch.setTempo(tempo);
+    stretch.setSetting(SETTING_SEQUENCE_MS, 35);
+
+    vector<float> in = noise(kBlockFrames);
+    vector<float> out(kBlockFrames * 2);
+    int done = 0;
+
+    MythTimer timer;
+    timer.start();
+
+    while (done < frames)
+    {
+        stretch.putSamples(&in[0], kBlockFrames);
+        while (stretch.receiveSamples(&out[0], kBlockFrames))
+            ;
+        done += kBlockFrames;
+    }
+
+    return rate(done, timer.elapsed());
+}
@@ -0,0 +1,24 @@
+#ifndef AUDIODSPBENCH_H_
+#define AUDIODSPBENCH_H_
+
+#include "mythexp.h"
+
+/** \class AudioDSPBench
+ *  \brief Measures the speed of the processing AudioOutputBase may do on
+ *         the audio thread: upmixing, resampling and timestretching.
+ *
+ *   Each method pushes the given number of frames of generated stereo
+ *   audio through a single stage, in blocks of the size the audio thread
+ *   uses, and returns the number of input frames processed per second,
+ *   or a negative value if the stage could not be set up.
+ */
+class MPUBLIC AudioDSPBench
+{
+  public:
+    static double Upmix(int samplerate, int frames, bool linear);
+    static double Resample(int samplerate, int outrate, int frames,
+                           int quality);
+    static double Timestretch(int samplerate, float tempo, int frames);
+};
+
+#endif
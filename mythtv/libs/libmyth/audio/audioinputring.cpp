@@ -0,0 +1,98 @@
+#include <cstring>
+
+#include "audioinputring.h"
+
+AudioInputRing::AudioInputRing(uint size) :
+    m_alloc(new uchar[size + 16]), m_buffer(NULL), m_size(size & ~15),
+    m_read(0), m_write(0), m_pending(0)
+{
+    m_buffer = (uchar *)(((quintptr)m_alloc + 15) & ~(quintptr)15);
+}
+
+AudioInputRing::~AudioInputRing()
+{
+    delete[] m_alloc;
+}
+
+/**
+ * Append a block of audio, called from the producer thread only
+ *
+ * Returns false, leaving the ring unchanged, if there is no room for it
+ */
+bool AudioInputRing::Push(const void *data, int len, int64_t timecode,
+                          bool music)
+{
+    int need = (kHeaderSize + len + 15) & ~15;
+    int w    = m_write.fetchAndAddOrdered(0);
+    int r    = m_read.fetchAndAddOrdered(0);
+    int pos  = w;
+
+    // read == write means empty, so the ring may never be filled up to read
+    if (w >= r)
+    {
+        if (m_size - w < need || (w + need == m_size && r == 0))
+        {
+            if (need >= r)
+                return false;
+            if (m_size - w >= kHeaderSize)
+                At(w)->size = 0;
+            pos = 0;
+        }
+    }
+    else if (r - w <= need)
+        return false;
+
+    Block *block    = At(pos);
+    block->timecode = timecode;
+    block->len      = len;
+    block->size     = need;
+    block->music    = music;
+    memcpy(block->data(), data, len);
+
+    m_pending.fetchAndAddOrdered(len);
+    m_write.fetchAndStoreRelease((pos + need) % m_size);
+    return true;
+}
+
+/**
+ * Return the oldest block, or NULL if the ring is empty
+ *
+ * Called from the consumer thread only, the block stays valid until Pop()
+ */
+AudioInputRing::Block *AudioInputRing::Front(void)
+{
+    int r = m_read.fetchAndAddOrdered(0);
+    if (r == m_write.fetchAndAddOrdered(0))
+        return NULL;
+
+    if (m_size - r < kHeaderSize || At(r)->size == 0)
+    {
+        r = 0;
+        m_read.fetchAndStoreRelease(0);
+    }
+    return At(r);
+}
+
+/**
+ * Drop the oldest block, called from the consumer thread only
+ */
+void AudioInputRing::Pop(void)
+{
+    Block *block = Front();
+    if (!block)
+        return;
+
+    int r = m_read.fetchAndAddOrdered(0);
+    m_pending.fetchAndAddOrdered(-block->len);
+    m_read.fetchAndStoreRelease((r + block->size) % m_size);
+}
+
+/**
+ * Drop all blocks, called from the consumer thread, or with the consumer
+ * thread known to be stopped or blocked
+ */
+void AudioInputRing::Clear(void)
+{
+    while (Front())
+        Pop();
+}
@@ -0,0 +1,62 @@
+#ifndef AUDIOINPUTRING_H_
+#define AUDIOINPUTRING_H_
+
+#include <stdint.h>
+
+#include <QAtomicInt>
+
+/** \class AudioInputRing
+ *  \brief Single producer, single consumer queue of blocks of audio.
+ *
+ *   AudioOutputBase::AddData() pushes the audio it is given, with its
+ *   timecode, from the decoder thread and the audio processing thread
+ *   pops it, without either of them taking a lock. Every block is stored
+ *   in one piece, a block which does not fit before the end of the buffer
+ *   is started again at the beginning, so the consumer can process it in
+ *   place. Blocks are 16 byte aligned.
+ *
+ *   Only one thread may call Push() and only one other thread may call
+ *   Front(), Pop() and Clear().
+ */
+class AudioInputRing
+{
+  public:
+    class Block
+    {
+      public:
+        int64_t timecode; ///< timecode of the first frame, -1 if none
+        int     len;      ///< bytes of audio following the header
+        int     size;     ///< bytes taken in the ring, 0 marks a wrap
+        bool    music;    ///< timecode was made up by AddData()
+
+        uchar *data(void) { return (uchar *)this + kHeaderSize; }
+    };
+
+    AudioInputRing(uint size);
+    ~AudioInputRing();
+
+    bool   Push(const void *data, int len, int64_t timecode, bool music);
+
+    Block *Front(void);
+    void   Pop(void);
+    void   Clear(void);
+
+    /// Bytes of audio waiting to be processed
+    int    Pending(void) const
+        { return const_cast<QAtomicInt&>(m_pending).fetchAndAddOrdered(0); }
+    uint   Size(void) const { return m_size; }
+
+    static const int kHeaderSize = (sizeof(Block) + 15) & ~15;
+
+  private:
+    Block *At(int pos) const { return (Block *)(m_buffer + pos); }
+
+    uchar      *m_alloc;
+    uchar      *m_buffer;
+    int         m_size;
+    QAtomicInt  m_read;     ///< written by the consumer only
+    QAtomicInt  m_write;    ///< written by the producer only
+    QAtomicInt  m_pending;
+};
+
+#endif
@@ -127,6 +127,12 @@ class MPUBLIC AudioOutput : public VolumeBase, public OutputListeners
     virtual void GetBufferStatus(uint &fill, uint &total)
         { fill = total = 0; }
 
+    /// report milliseconds of audio buffered, buffer underruns since the
+    /// output was configured and milliseconds of processing per period.
+    virtual void GetLatencyStats(int64_t &buffered, uint &underruns,
+                                 float &dsptime)
+        { buffered = 0; underruns = 0; dsptime = 0.0f; }
+
     //  Only really used by the AudioOutputNULL object
     virtual void bufferOutputData(bool y) = 0;
     virtual int readOutputData(unsigned char *read_buffer,
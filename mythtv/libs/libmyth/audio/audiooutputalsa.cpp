@@ -10,6 +10,14 @@ using namespace std;
 #include "mythcorecontext.h"
 #include "audiooutputalsa.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+extern "C" {
+#include "libavutil/cpu.h"
+}
+#endif
+
 #define LOC QString("ALSA: ")
 
 // redefine assert as no-op to quiet some compiler warnings
@@ -535,7 +543,36 @@ static inline void _ReorderSmpteToAlsa(AudioDataType *buf, uint frames,
 static inline void ReorderSmpteToAlsa(void *buf, uint frames,
                                       AudioFormat format, uint extrach)
 {
-    switch(AudioOutputSettings::FormatToBits(format))
+    int bits = AudioOutputSettings::FormatToBits(format);
+
+#ifdef __SSE2__
+    // A 7.1 frame of 16 bit samples is one vector and of 32 bit samples
+    // two, so the C/LFE and surround pairs swap with a single shuffle
+    if (extrach == 2 && (bits == 16 || bits == 32) &&
+        (av_get_cpu_flags() & AV_CPU_FLAG_SSE2))
+    {
+        __m128i *p = (__m128i *)buf;
+        for (uint i = 0; i < frames; i++)
+        {
+            if (bits == 16)
+            {
+                __m128i v = _mm_loadu_si128(p);
+                v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+                _mm_storeu_si128(p++, v);
+            }
+            else
+            {
+                __m128i a = _mm_loadu_si128(p);
+                __m128i b = _mm_loadu_si128(p + 1);
+                _mm_storeu_si128(p++, _mm_unpacklo_epi64(a, b));
+                _mm_storeu_si128(p++, _mm_unpackhi_epi64(a, b));
+            }
+        }
+        return;
+    }
+#endif
+
+    switch(bits)
     {
         case  8: _ReorderSmpteToAlsa((uchar *)buf, frames, extrach); break;
         case 16: _ReorderSmpteToAlsa((short *)buf, frames, extrach); break;
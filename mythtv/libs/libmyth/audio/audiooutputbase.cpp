@@ -91,6 +91,11 @@ AudioOutputBase::AudioOutputBase(const AudioSettings &settings) :
 
     audio_thread_exists(false),
 
+    m_input(new AudioInputRing(kAudioInputRingSize)),
+    m_processThread(NULL),      m_killprocess(false),
+    m_underruns(0),             m_underrun_armed(false),
+    m_dsp_nsecs_per_frame(0),
+
     audiotime(0),
     raud(0),                    waud(0),
     audbuf_timecode(0),
@@ -106,6 +111,7 @@ AudioOutputBase::AudioOutputBase(const AudioSettings &settings) :
     m_configure_succeeded(false),m_length_last_data(0),
     m_spdifenc(NULL),           m_forcedprocessing(false)
 {
+    m_processThread = new AudioProcessThread(this);
     src_in = (float *)AOALIGN(src_in_buf);
     memset(&src_data,          0, sizeof(SRC_DATA));
     memset(src_in_buf,         0, sizeof(src_in_buf));
@@ -146,6 +152,9 @@ AudioOutputBase::~AudioOutputBase()
     if (kAudioSRCOutputSize > 0)
         delete[] src_out;
 
+    delete m_processThread;
+    delete m_input;
+
     assert(memory_corruption_test0 == 0xdeadbeef);
     assert(memory_corruption_test1 == 0xdeadbeef);
     assert(memory_corruption_test2 == 0xdeadbeef);
@@ -612,8 +621,11 @@ void AudioOutputBase::Reconfigure(const AudioSettings &orig_settings)
     QMutexLocker lock(&audio_buflock);
     QMutexLocker lockav(&avsync_lock);
 
+    m_input->Clear();
     waud = raud = 0;
     reset_active.Clear();
+    m_underruns = 0;
+    m_underrun_armed = false;
     actually_paused = processing = m_forcedprocessing = false;
 
     channels               = settings.channels;
@@ -790,7 +802,11 @@ void AudioOutputBase::Reconfigure(const AudioSettings &orig_settings)
         .arg(main_device).arg(channels).arg(source_channels).arg(samplerate)
         .arg(output_settings->FormatToString(output_format)).arg(reenc));
 
-    audbuf_timecode = audiotime = frames_buffered = 0;
+    audbuf_timecode = audiotime = 0;
+    {
+        QMutexLocker lockvis(&visual_lock);
+        frames_buffered = 0;
+    }
     current_seconds = source_bitrate = -1;
     effdsp = samplerate * 100;
 
@@ -839,13 +855,17 @@ void AudioOutputBase::Reconfigure(const AudioSettings &orig_settings)
     SetStretchFactorLocked(old_stretchfactor);
 
     // Setup visualisations, zero the visualisations buffers
-    prepareVisuals();
+    {
+        QMutexLocker lockvis(&visual_lock);
+        prepareVisuals();
+    }
 
     if (unpause_when_ready)
         pauseaudio = actually_paused = true;
 
     m_configure_succeeded = true;
 
+    StartProcessThread();
     StartOutputThread();
 
     VBAUDIO("Ending Reconfigure()");
@@ -872,6 +892,22 @@ void AudioOutputBase::StopOutputThread(void)
     }
 }
 
+void AudioOutputBase::StartProcessThread(void)
+{
+    m_killprocess = false;
+    m_processThread->start();
+}
+
+void AudioOutputBase::StopProcessThread(void)
+{
+    {
+        QMutexLocker locker(&m_processLock);
+        m_killprocess = true;
+        m_processWait.wakeAll();
+    }
+    m_processThread->wait();
+}
+
 /**
  * Kill the output thread and cleanup
  */
@@ -881,6 +917,7 @@ void AudioOutputBase::KillAudio()
 
     VBAUDIO("Killing AudioOutputDSP");
     killaudio = true;
+    StopProcessThread();
     StopOutputThread();
     QMutexLocker lock(&audio_buflock);
 
@@ -942,8 +979,11 @@ void AudioOutputBase::Reset()
 {
     QMutexLocker lock(&audio_buflock);
     QMutexLocker lockav(&avsync_lock);
+    QMutexLocker lockvis(&visual_lock);
 
     audbuf_timecode = audiotime = frames_buffered = 0;
+    m_input->Clear();
+    m_underrun_armed = false;
     if (encoder)
     {
         waud = raud = 0;    // empty ring buffer
@@ -977,6 +1017,8 @@ void AudioOutputBase::Reset()
 void AudioOutputBase::SetTimecode(int64_t timecode)
 {
     audbuf_timecode = audiotime = timecode;
+
+    QMutexLocker lockvis(&visual_lock);
     frames_buffered = (timecode * source_samplerate) / 1000;
 }
 
@@ -1151,6 +1193,10 @@ void AudioOutputBase::SetAudiotime(int frames, int64_t timecode)
 int64_t AudioOutputBase::GetAudioBufferedTime(void)
 {
     int64_t ret = audbuf_timecode - GetAudiotime();
+    // Include the audio still waiting to be processed
+    if (source_samplerate > 0 && source_bytes_per_frame > 0)
+        ret += (int64_t)m_input->Pending() * 1000 /
+               (source_samplerate * source_bytes_per_frame);
     // Pulse can give us values that make this -ve
     if (ret < 0)
         return 0;
@@ -1311,7 +1357,7 @@ bool AudioOutputBase::AddFrames(void *in_buffer, int in_frames,
 }
 
 /**
- * Add data to the audiobuffer and perform any required processing
+ * Queue data for the processing thread to add to the audiobuffer
  *
  * Returns false if there's not enough space right now
  */
@@ -1319,11 +1365,8 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                               int64_t timecode, int /*in_frames*/)
 {
     int frames   = in_len / source_bytes_per_frame;
-    void *buffer = in_buffer;
-    int bpf      = bytes_per_frame;
     int len      = in_len;
     bool music   = false;
-    int bdiff;
 
     if (!m_configure_succeeded)
     {
@@ -1333,21 +1376,6 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
         return false;
     }
 
-    /* See if we're waiting for new samples to be buffered before we unpause
-       post channel change, seek, etc. Wait for 4 fragments to be buffered */
-    if (unpause_when_ready && pauseaudio && audioready() > fragment_size << 2)
-    {
-        unpause_when_ready = false;
-        Pause(false);
-    }
-
-    // Don't write new samples if we're resetting the buffer or reconfiguring
-    QMutexLocker lock(&audio_buflock);
-
-    uint org_waud = waud;
-    int  afree    = audiofree();
-    int  used     = kAudioRingBufferSize - afree;
-
     if (passthru && m_spdifenc)
     {
         if (processing)
@@ -1366,7 +1394,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
         len = m_spdifenc->GetProcessedSize();
         if (len > 0)
         {
-            buffer = in_buffer = m_spdifenc->GetProcessedBuffer();
+            in_buffer = m_spdifenc->GetProcessedBuffer();
             m_spdifenc->Reset();
             frames = len / source_bytes_per_frame;
         }
@@ -1376,26 +1404,62 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
     m_length_last_data = (int64_t)
         ((double)(len * 1000) / (source_samplerate * source_bytes_per_frame));
 
-    VBAUDIOTS(QString("AddData frames=%1, bytes=%2, used=%3, free=%4, "
-                      "timecode=%5 needsupmix=%6")
-              .arg(frames).arg(len).arg(used).arg(afree).arg(timecode)
+    VBAUDIOTS(QString("AddData frames=%1, bytes=%2, queued=%3, "
+                      "timecode=%4 needsupmix=%5")
+              .arg(frames).arg(len).arg(m_input->Pending()).arg(timecode)
               .arg(needs_upmix));
 
-    // Mythmusic doesn't give us timestamps
-    if (timecode < 0)
     {
-        timecode = (frames_buffered * 1000) / source_samplerate;
-        frames_buffered += frames;
-        music = true;
+        QMutexLocker lockvis(&visual_lock);
+
+        // Mythmusic doesn't give us timestamps
+        if (timecode < 0)
+        {
+            timecode = (frames_buffered * 1000) / source_samplerate;
+            frames_buffered += frames;
+            music = true;
+        }
+
+        if (hasVisual())
+        {
+            // Send original samples to any attached visualisations
+            dispatchVisual((uchar *)in_buffer, len, timecode,
+                           source_channels,
+                           output_settings->FormatToBits(format));
+        }
     }
 
-    if (hasVisual())
+    if (!m_input->Push(in_buffer, len, timecode, music))
     {
-        // Send original samples to any attached visualisations
-        dispatchVisual((uchar *)in_buffer, len, timecode, source_channels,
-                       output_settings->FormatToBits(format));
+        VBAUDIOTS("Input queue is full, AddData returning false");
+        return false;
     }
 
+    m_processWait.wakeAll();
+    return true;
+}
+
+/**
+ * Add a block of queued data to the audiobuffer and perform any required
+ * processing
+ *
+ * Must be called with the audio_buflock held. Returns false, leaving the
+ * block untouched, if there's not enough space in the audiobuffer right now
+ */
+bool AudioOutputBase::ProcessData(AudioInputRing::Block *block)
+{
+    void *in_buffer = block->data();
+    int64_t timecode = block->timecode;
+    int frames   = block->len / source_bytes_per_frame;
+    void *buffer = in_buffer;
+    int bpf      = bytes_per_frame;
+    int len      = block->len;
+    bool music   = block->music;
+    int bdiff;
+
+    uint org_waud = waud;
+    int  afree    = audiofree();
+
     // Calculate amount of free space required in ringbuffer
     if (processing)
     {
@@ -1426,7 +1490,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
 
     if (len > afree)
     {
-        VBAUDIOTS("Buffer is full, AddData returning false");
+        VBAUDIOTS("Buffer is full, waiting for the output to catch up");
         return false; // would overflow
     }
 
@@ -1593,6 +1657,71 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
     return true;
 }
 
+/**
+ * Run in the processing thread, move the audio queued by AddData() into
+ * the audiobuffer as long as there is room for it
+ */
+void AudioOutputBase::ProcessAudioLoop(void)
+{
+    while (!m_killprocess)
+    {
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+
+        int  frames  = 0;
+        bool blocked = false;
+        while (!m_killprocess)
+        {
+            QMutexLocker lock(&audio_buflock);
+            AudioInputRing::Block *block = m_input->Front();
+            if (!block)
+                break;
+            if (!ProcessData(block))
+            {
+                blocked = true;
+                break;
+            }
+            frames += block->len / source_bytes_per_frame;
+            m_input->Pop();
+        }
+
+        if (frames)
+        {
+            gettimeofday(&end, NULL);
+            int64_t nsecs = ((end.tv_sec - start.tv_sec) * 1000000LL +
+                             (end.tv_usec - start.tv_usec)) * 1000;
+            int avg = m_dsp_nsecs_per_frame.fetchAndAddOrdered(0);
+            m_dsp_nsecs_per_frame.fetchAndStoreRelease(
+                (int)((avg * 9LL + nsecs / frames) / 10));
+        }
+
+        /* See if we're waiting for new samples to be buffered before we
+           unpause post channel change, seek, etc. Wait for 4 fragments to
+           be buffered */
+        if (unpause_when_ready && pauseaudio &&
+            audioready() > fragment_size << 2)
+        {
+            unpause_when_ready = false;
+            Pause(false);
+        }
+
+        // Sleep until AddData() queues more, or the output makes room
+        if (!frames || blocked)
+        {
+            QMutexLocker locker(&m_processLock);
+            if (!m_killprocess)
+                m_processWait.wait(&m_processLock, 10);
+        }
+    }
+}
+
+void AudioProcessThread::run(void)
+{
+    RunProlog();
+    m_parent->ProcessAudioLoop();
+    RunEpilog();
+}
+
 /**
  * Report status via an OutputEvent
  */
@@ -1622,8 +1751,23 @@ void AudioOutputBase::Status()
  */
 void AudioOutputBase::GetBufferStatus(uint &fill, uint &total)
 {
-    fill  = kAudioRingBufferSize - audiofree();
-    total = kAudioRingBufferSize;
+    fill  = kAudioRingBufferSize - audiofree() + m_input->Pending();
+    total = kAudioRingBufferSize + m_input->Size();
+}
+
+/**
+ * Fill in the milliseconds of audio buffered, the number of times the
+ * audiobuffer ran dry while playing and the average time taken to process
+ * the audio played in one period
+ */
+void AudioOutputBase::GetLatencyStats(int64_t &buffered, uint &underruns,
+                                      float &dsptime)
+{
+    buffered  = GetAudioBufferedTime();
+    underruns = m_underruns;
+    dsptime   = output_bytes_per_frame ?
+        m_dsp_nsecs_per_frame.fetchAndAddOrdered(0) * 1e-6f *
+        fragment_size / output_bytes_per_frame : 0.0f;
 }
 
 /**
@@ -1656,6 +1800,7 @@ void AudioOutputBase::OutputAudioLoop(void)
             }
 
             actually_paused = true;
+            m_underrun_armed = false;
             audiotime = 0; // mark 'audiotime' as invalid.
 
             WriteAudio(zeros, zero_fragment_size);
@@ -1678,6 +1823,13 @@ void AudioOutputBase::OutputAudioLoop(void)
         // wait for the buffer to fill with enough to play
         if (fragment_size > ready)
         {
+            if (m_underrun_armed)
+            {
+                VBAUDIO("OutputAudioLoop: audio buffer underrun");
+                m_underruns++;
+                m_underrun_armed = false;
+            }
+
             if (ready > 0)  // only log if we're sending some audio
                 VBAUDIOTS(QString("audio waiting for buffer to fill: "
                                   "have %1 want %2")
@@ -1703,6 +1855,7 @@ void AudioOutputBase::OutputAudioLoop(void)
                 WriteAudio(fragment, fragment_size);
                 if (!reset_active.TestAndDeref())
                     raud = next_raud;
+                m_underrun_armed = true;
             }
         }
 #ifdef AUDIOTSTESTING
@@ -1805,7 +1958,8 @@ int AudioOutputBase::GetAudioData(uchar *buffer, int size, bool full_buffer,
  */
 void AudioOutputBase::Drain()
 {
-    while (audioready() > fragment_size)
+    while ((m_input->Pending() > 0 && !m_killprocess) ||
+           audioready() > fragment_size)
         usleep(1000);
 }
 
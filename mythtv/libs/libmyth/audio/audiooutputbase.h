@@ -11,6 +11,7 @@ using namespace std;
 // Qt headers
 #include <QString>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QWaitCondition>
 
 // MythTV headers
@@ -18,6 +19,7 @@ using namespace std;
 #include "samplerate.h"
 #include "mythlogging.h"
 #include "mthread.h"
+#include "audioinputring.h"
 
 #define VBAUDIO(str)   LOG(VB_AUDIO, LOG_INFO, LOC + str)
 #define VBAUDIOTS(str) LOG(VB_AUDIO | VB_TIMESTAMP, LOG_INFO, LOC + str)
@@ -47,6 +49,18 @@ private:
 
 // Forward declaration of SPDIF encoder
 class SPDIFEncoder;
+class AudioOutputBase;
+
+/// Runs the audio processing of an AudioOutputBase away from the decoder
+class AudioProcessThread : public MThread
+{
+  public:
+    AudioProcessThread(AudioOutputBase *parent) :
+        MThread("AudioProcess"), m_parent(parent) {}
+    virtual void run(void);
+  private:
+    AudioOutputBase *m_parent;
+};
 
 class AudioOutputBase : public AudioOutput, public MThread
 {
@@ -106,6 +120,8 @@ class AudioOutputBase : public AudioOutput, public MThread
     virtual void SetSourceBitrate(int rate);
 
     virtual void GetBufferStatus(uint &fill, uint &total);
+    virtual void GetLatencyStats(int64_t &buffered, uint &underruns,
+                                 float &dsptime);
 
     //  Only really used by the AudioOutputNULL object
     virtual void bufferOutputData(bool y){ buffer_output_data_for_use = y; }
@@ -115,6 +131,8 @@ class AudioOutputBase : public AudioOutput, public MThread
 
     /// Audio Buffer Size -- should be divisible by 32,24,16,12,10,8,6,4,2..
     static const uint kAudioRingBufferSize   = 3072000u;
+    /// Size of the queue of audio waiting to be processed
+    static const uint kAudioInputRingSize    = 1048576u;
 
  protected:
     // Following function must be called from subclass constructor
@@ -143,6 +161,7 @@ class AudioOutputBase : public AudioOutput, public MThread
                      volatile uint *local_raud = NULL);
 
     void OutputAudioLoop(void);
+    void ProcessAudioLoop(void);
 
     virtual void run();
 
@@ -158,6 +177,8 @@ class AudioOutputBase : public AudioOutput, public MThread
     int GetBaseAudBufTimeCode() const { return audbuf_timecode; }
 
   protected:
+    friend class AudioProcessThread;
+
     // Basic details about the audio stream
     int channels;
     int codec;
@@ -202,6 +223,9 @@ class AudioOutputBase : public AudioOutput, public MThread
                           int &samplerate_tmp, int &channels_tmp);
     AudioOutputSettings* OutputSettings(bool digital = true);
     int CopyWithUpmix(char *buffer, int frames, uint &org_waud);
+    bool ProcessData(AudioInputRing::Block *block);
+    void StartProcessThread(void);
+    void StopProcessThread(void);
     void SetAudiotime(int frames, int64_t timecode);
     AudioOutputSettings *output_settingsraw;
     AudioOutputSettings *output_settings;
@@ -230,12 +254,36 @@ class AudioOutputBase : public AudioOutput, public MThread
 
     bool audio_thread_exists;
 
+    /**
+     *  Audio given to AddData(), waiting for the processing thread to
+     *  convert, resample, upmix, stretch or encode it into the audiobuffer
+     */
+    AudioInputRing      *m_input;
+    AudioProcessThread  *m_processThread;
+    volatile bool        m_killprocess;
+    QMutex               m_processLock;
+    QWaitCondition       m_processWait;
+
+    // Statistics for the playback OSD
+    volatile uint        m_underruns;
+    volatile bool        m_underrun_armed;
+    /// Average nanoseconds taken to process one frame, written by the
+    /// processing thread and read by GetLatencyStats()
+    QAtomicInt           m_dsp_nsecs_per_frame;
+
     /**
      *  Writes to the audiobuffer, reconfigures and audiobuffer resets can only
      *  take place while holding this lock
      */
     QMutex audio_buflock;
 
+    /**
+     *  must hold visual_lock to read or write 'frames_buffered' or to pass
+     *  samples to the visualisations, AddData() does both without holding
+     *  audio_buflock
+     */
+    QMutex visual_lock;
+
     /**
      *  must hold avsync_lock to read or write 'audiotime' and
      *  'audiotime_updated'
@@ -21,8 +21,29 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "string.h"
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+extern "C" {
+#include "libavutil/cpu.h"
+}
+
 #define LOC QString("Downmixer: ")
 
+#ifdef __SSE__
+static int has_sse = -1;
+
+// Check the CPU flags libavutil detected for SSE support
+static inline bool sse_check()
+{
+    if (has_sse != -1)
+        return (bool)has_sse;
+    has_sse = (av_get_cpu_flags() & AV_CPU_FLAG_SSE) ? 1 : 0;
+    return (bool)has_sse;
+}
+#endif
+
 /*
  SMPTE channel layout
  DUAL-MONO      L   R
@@ -174,33 +195,98 @@ int AudioOutputDownmix::DownmixFrames(int channels_in, int  channels_out,
     //    .arg(frames).arg(channels_in).arg(channels_out));
     if (channels_out == 2)
     {
-        float tmp;
+        float tmp[6];
         int index = channels_in - 1;
-        for (int n=0; n < frames; n++)
+        int n = 0;
+#ifdef __SSE__
+        // Two frames at a time: {L0 R0 L1 R1} is the sum over the input
+        // channels of {s0 s0 s1 s1} * {l r l r}. Both frames are read before
+        // they are written, so this works in place as well.
+        if (sse_check())
         {
+            __m128 coef[8];
+            for (int j = 0; j < channels_in; j++)
+            {
+                coef[j] = _mm_setr_ps(stereo_matrix[index][j][0],
+                                      stereo_matrix[index][j][1],
+                                      stereo_matrix[index][j][0],
+                                      stereo_matrix[index][j][1]);
+            }
+            for (; n + 2 <= frames; n += 2)
+            {
+                __m128 acc = _mm_setzero_ps();
+                for (int j = 0; j < channels_in; j++)
+                {
+                    __m128 s = _mm_setr_ps(src[j], src[j],
+                                           src[channels_in + j],
+                                           src[channels_in + j]);
+                    acc = _mm_add_ps(acc, _mm_mul_ps(s, coef[j]));
+                }
+                _mm_storeu_ps(dst, acc);
+                dst += 4;
+                src += channels_in * 2;
+            }
+        }
+#endif
+        for (; n < frames; n++)
+        {
+            // Mix the whole frame before writing it, dst may be src
             for (int i=0; i < channels_out; i++)
             {
-                tmp = 0.0f;
+                tmp[i] = 0.0f;
                 for (int j=0; j < channels_in; j++)
-                    tmp += src[j] * stereo_matrix[index][j][i];
-                *dst++ = tmp;
+                    tmp[i] += src[j] * stereo_matrix[index][j][i];
             }
+            for (int i=0; i < channels_out; i++)
+                *dst++ = tmp[i];
             src += channels_in;
         }
     }
     else if (channels_out == 6)
     {
-        float tmp;
+        float tmp[6];
         int index = channels_in - 6;
-        for (int n=0; n < frames; n++)
+        int n = 0;
+#ifdef __SSE__
+        // One frame at a time, each input channel scales its row of the
+        // matrix into the six outputs
+        if (sse_check())
+        {
+            __m128 lo[8], hi[8];
+            for (int j = 0; j < channels_in; j++)
+            {
+                lo[j] = _mm_loadu_ps(s51_matrix[index][j]);
+                hi[j] = _mm_setr_ps(s51_matrix[index][j][4],
+                                    s51_matrix[index][j][5], 0.0f, 0.0f);
+            }
+            for (; n < frames; n++)
+            {
+                __m128 acc0 = _mm_setzero_ps();
+                __m128 acc1 = _mm_setzero_ps();
+                for (int j = 0; j < channels_in; j++)
+                {
+                    __m128 s = _mm_set1_ps(src[j]);
+                    acc0 = _mm_add_ps(acc0, _mm_mul_ps(s, lo[j]));
+                    acc1 = _mm_add_ps(acc1, _mm_mul_ps(s, hi[j]));
+                }
+                _mm_storeu_ps(dst, acc0);
+                _mm_storel_pi((__m64 *)(dst + 4), acc1);
+                dst += 6;
+                src += channels_in;
+            }
+        }
+#endif
+        for (; n < frames; n++)
         {
+            // Mix the whole frame before writing it, dst may be src
             for (int i=0; i < channels_out; i++)
             {
-                tmp = 0.0f;
+                tmp[i] = 0.0f;
                 for (int j=0; j < channels_in; j++)
-                    tmp += src[j] * s51_matrix[index][j][i];
-                *dst++ = tmp;
+                    tmp[i] += src[j] * s51_matrix[index][j][i];
             }
+            for (int i=0; i < channels_out; i++)
+                *dst++ = tmp[i];
             src += channels_in;
         }
     }
@@ -6,35 +6,25 @@
 #include <inttypes.h>
 #include "bswap.h"
 
+extern "C" {
+#include "libavutil/cpu.h"
+}
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define LOC QString("AOUtil: ")
 
 #if ARCH_X86
 static int has_sse2 = -1;
 
-// Check cpuid for SSE2 support on x86 / x86_64
+// Check the CPU flags libavutil detected for SSE2 support on x86 / x86_64
 static inline bool sse_check()
 {
     if (has_sse2 != -1)
         return (bool)has_sse2;
-    __asm__(
-        // -fPIC - we may not clobber ebx/rbx
-#if ARCH_X86_64
-        "push       %%rbx               \n\t"
-#else
-        "push       %%ebx               \n\t"
-#endif
-        "mov        $1, %%eax           \n\t"
-        "cpuid                          \n\t"
-        "and        $0x4000000, %%edx   \n\t"
-        "shr        $26, %%edx          \n\t"
-#if ARCH_X86_64
-        "pop        %%rbx               \n\t"
-#else
-        "pop        %%ebx               \n\t"
-#endif
-        :"=d"(has_sse2)
-        ::"%eax","%ecx"
-    );
+    has_sse2 = (av_get_cpu_flags() & AV_CPU_FLAG_SSE2) ? 1 : 0;
     return (bool)has_sse2;
 }
 #endif //ARCH_x86
@@ -528,7 +518,21 @@ void AudioOutputUtil::MonoToStereo(void *dst, void *src, int samples)
 {
     float *d = (float *)dst;
     float *s = (float *)src;
-    for (int i = 0; i < samples; i++)
+    int i = 0;
+#if ARCH_X86 && defined(__SSE2__)
+    if (sse_check())
+    {
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 m = _mm_loadu_ps(s);
+            _mm_storeu_ps(d,     _mm_unpacklo_ps(m, m));
+            _mm_storeu_ps(d + 4, _mm_unpackhi_ps(m, m));
+            s += 4;
+            d += 8;
+        }
+    }
+#endif
+    for (; i < samples; i++)
     {
         *d++ = *s;
         *d++ = *s++;
@@ -623,6 +627,36 @@ void AudioOutputUtil::MuteChannel(int obits, int channels, int ch,
 {
     int frames = bytes / ((obits >> 3) * channels);
 
+#if ARCH_X86 && defined(__SSE2__)
+    // Stereo is all but universal, copy the other channel four frames at
+    // a time with a shuffle
+    if (sse_check() && channels == 2 && (obits == 16 || obits == 32))
+    {
+        __m128i *p = (__m128i *)buffer;
+        int loops  = (obits == 16) ? frames >> 2 : frames >> 1;
+        int done   = (obits == 16) ? loops << 2 : loops << 1;
+        for (int i = 0; i < loops; i++, p++)
+        {
+            __m128i v = _mm_loadu_si128(p);
+            if (obits == 16 && ch)
+                v = _mm_shufflehi_epi16(
+                    _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 2, 0, 0)),
+                    _MM_SHUFFLE(2, 2, 0, 0));
+            else if (obits == 16)
+                v = _mm_shufflehi_epi16(
+                    _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 1, 1)),
+                    _MM_SHUFFLE(3, 3, 1, 1));
+            else if (ch)
+                v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 0, 0));
+            else
+                v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 1, 1));
+            _mm_storeu_si128(p, v);
+        }
+        buffer = (char *)buffer + done * (obits >> 2);
+        frames -= done;
+    }
+#endif
+
     if (obits == 8)
         _MuteChannel((uchar *)buffer, channels, ch, frames);
     else if (obits == 16)
@@ -17,7 +17,8 @@ HEADERS += audio/audiooutput.h audio/audiooutputbase.h audio/audiooutputnull.h
 HEADERS += audio/audiooutpututil.h audio/audiooutputdownmix.h
 HEADERS += audio/audiooutputdigitalencoder.h audio/spdifencoder.h
 HEADERS += audio/audiosettings.h audio/audiooutputsettings.h audio/pink.h
-HEADERS += audio/volumebase.h audio/eldutils.h
+HEADERS += audio/volumebase.h audio/eldutils.h audio/audiodspbench.h
+HEADERS += audio/audioinputring.h
 HEADERS += backendselect.h dbsettings.h dialogbox.h
 HEADERS += langsettings.h
 HEADERS += mythconfigdialogs.h mythconfiggroups.h
@@ -33,6 +34,7 @@ HEADERS += mythterminal.h
 HEADERS += remoteutil.h
 HEADERS += rawsettingseditor.h
 HEADERS += programinfo.h          programinfoupdater.h
+HEADERS += positionmapfile.h
 HEADERS += programtypes.h         recordingtypes.h
 HEADERS += mythrssmanager.h       netgrabbermanager.h
 HEADERS += rssparse.h             netutils.h
@@ -45,7 +47,8 @@ SOURCES += audio/spdifencoder.cpp audio/audiooutputdigitalencoder.cpp
 SOURCES += audio/audiooutputnull.cpp
 SOURCES += audio/audiooutpututil.cpp audio/audiooutputdownmix.cpp
 SOURCES += audio/audiosettings.cpp audio/audiooutputsettings.cpp audio/pink.c
-SOURCES += audio/volumebase.cpp audio/eldutils.cpp
+SOURCES += audio/volumebase.cpp audio/eldutils.cpp audio/audiodspbench.cpp
+SOURCES += audio/audioinputring.cpp
 
 SOURCES += backendselect.cpp dbsettings.cpp dialogbox.cpp
 SOURCES += langsettings.cpp
@@ -61,6 +64,7 @@ SOURCES += mythterminal.cpp
 SOURCES += remoteutil.cpp
 SOURCES += rawsettingseditor.cpp
 SOURCES += programinfo.cpp        programinfoupdater.cpp
+SOURCES += positionmapfile.cpp
 SOURCES += programtypes.cpp       recordingtypes.cpp
 SOURCES += mythrssmanager.cpp     netgrabbermanager.cpp
 SOURCES += rssparse.cpp           netutils.cpp
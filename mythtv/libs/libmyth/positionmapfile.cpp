@@ -0,0 +1,326 @@
+// POSIX headers
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef USING_MINGW
+#include <sys/file.h>
+#endif
+
+// C headers
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+
+// Qt headers
+#include <QByteArray>
+#include <QtEndian>
+#include <QFile>
+#include <QMutex>
+
+// MythTV headers
+#include "compat.h"
+#include "mythcorecontext.h"
+#include "positionmapfile.h"
+#include "mythlogging.h"
+#include "remotefile.h"
+
+#define LOC QString("PosMapFile: ")
+
+static const char kMagic[] = "MYTHSEEK";
+static const int  kMagicSize = 8;
+// quint32 type, quint64 frame, quint64 offset
+static const int  kRecordSize = 4 + 8 + 8;
+
+/// Serializes changes to seek table files within this process, see
+/// SeekTableLock for other processes.
+static QMutex write_lock;
+
+/** \brief Holds an exclusive flock(2) on a local seek table file.
+ *
+ *   The recorder appends to the seek table while mythcommflag or mythutil
+ *   may rewrite it through a temporary file and rename(2). An Append()
+ *   between the read and the rename would be lost, so both take this
+ *   lock. Since the rename replaces the locked file, the lock is retaken
+ *   until the locked file is the one the name refers to.
+ */
+class SeekTableLock
+{
+  public:
+    SeekTableLock(const QString &filename, bool create) : m_fd(-1)
+    {
+        QByteArray fname = filename.toLocal8Bit();
+        int flags = O_RDWR | O_APPEND | (create ? O_CREAT : 0);
+
+        for (;;)
+        {
+            m_fd = open(fname.constData(), flags, 0664);
+            if (m_fd < 0)
+                return;
+#ifndef USING_MINGW
+            while (flock(m_fd, LOCK_EX) < 0)
+            {
+                if (errno != EINTR)
+                {
+                    LOG(VB_GENERAL, LOG_ERR, LOC +
+                        QString("Failed to lock '%1'").arg(filename) + ENO);
+                    return;
+                }
+            }
+
+            struct stat fd_st, name_st;
+            if (fstat(m_fd, &fd_st) < 0 ||
+                stat(fname.constData(), &name_st) < 0 ||
+                fd_st.st_dev != name_st.st_dev ||
+                fd_st.st_ino != name_st.st_ino)
+            {
+                // replaced or removed while we waited for the lock
+                close(m_fd);
+                m_fd = -1;
+                continue;
+            }
+#endif
+            return;
+        }
+    }
+
+    ~SeekTableLock()
+    {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+
+    /// Returns the locked file descriptor, or -1 if the file is not open.
+    int Handle(void) const { return m_fd; }
+
+  private:
+    int m_fd;
+};
+
+static void append_records(QByteArray &buf, MarkTypes type,
+                           const frm_pos_map_t &posMap)
+{
+    int start = buf.size();
+    buf.resize(start + posMap.size() * kRecordSize);
+    uchar *p = (uchar *)buf.data() + start;
+
+    frm_pos_map_t::const_iterator it = posMap.begin();
+    for (; it != posMap.end(); ++it, p += kRecordSize)
+    {
+        qToLittleEndian((quint32)type,         p);
+        qToLittleEndian((quint64)it.key(),     p + 4);
+        qToLittleEndian((quint64)it.value(),   p + 12);
+    }
+}
+
+/// Returns true if new seek tables should be stored in sidecar files.
+bool PositionMapFile::IsEnabled(void)
+{
+    return gCoreContext->GetNumSetting("PositionMapSidecar", 0);
+}
+
+bool PositionMapFile::Exists(const QString &mediafile)
+{
+    QString filename = GetFilename(mediafile);
+    if (filename.startsWith("myth://"))
+        return RemoteFile::Exists(filename);
+    return QFile::exists(filename);
+}
+
+bool PositionMapFile::ReadAll(const QString &mediafile,
+                              pos_map_by_type_t &maps)
+{
+    QString filename = GetFilename(mediafile);
+    QByteArray data;
+
+    if (filename.startsWith("myth://"))
+    {
+        if (!RemoteFile::Exists(filename))
+            return false;
+        RemoteFile rf(filename, false, false);
+        if (!rf.isOpen() || !rf.SaveAs(data))
+            return false;
+    }
+    else
+    {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        data = file.readAll();
+        if (data.isEmpty())
+            return false;
+    }
+
+    if (data.size() < kMagicSize ||
+        memcmp(data.constData(), kMagic, kMagicSize) != 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("'%1' is not a seek table").arg(filename));
+        return false;
+    }
+
+    // A record may be half written while the recorder is appending.
+    int count = (data.size() - kMagicSize) / kRecordSize;
+    const uchar *p = (const uchar *)data.constData() + kMagicSize;
+    for (int i = 0; i < count; i++, p += kRecordSize)
+    {
+        int type        = qFromLittleEndian<quint32>(p);
+        uint64_t frame  = qFromLittleEndian<quint64>(p + 4);
+        uint64_t offset = qFromLittleEndian<quint64>(p + 12);
+        maps[type][frame] = offset;
+    }
+
+    return true;
+}
+
+bool PositionMapFile::WriteAll(const QString &mediafile,
+                               const pos_map_by_type_t &maps)
+{
+    QString filename = GetFilename(mediafile);
+    QString tmpname  = filename + ".tmp";
+
+    QByteArray buf(kMagic, kMagicSize);
+    pos_map_by_type_t::const_iterator it = maps.begin();
+    for (; it != maps.end(); ++it)
+        append_records(buf, (MarkTypes)it.key(), *it);
+
+    QFile file(tmpname);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(buf) != buf.size() || !file.flush())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to write '%1'").arg(tmpname));
+        file.close();
+        QFile::remove(tmpname);
+        return false;
+    }
+    fsync(file.handle());
+    file.close();
+
+    // rename(2) replaces the old table atomically
+    if (rename(tmpname.toLocal8Bit().constData(),
+               filename.toLocal8Bit().constData()) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to rename '%1'").arg(tmpname) + ENO);
+        QFile::remove(tmpname);
+        return false;
+    }
+
+    return true;
+}
+
+/** \fn PositionMapFile::Load(const QString&, MarkTypes, frm_pos_map_t&)
+ *  \brief Reads the entries of the given type from the seek table of
+ *         mediafile, which may be a local path or a myth:// URL.
+ *  \return true if the seek table file exists and could be read.
+ */
+bool PositionMapFile::Load(const QString &mediafile, MarkTypes type,
+                           frm_pos_map_t &posMap)
+{
+    pos_map_by_type_t maps;
+    if (!ReadAll(mediafile, maps))
+        return false;
+
+    posMap = maps[type];
+    return true;
+}
+
+/** \fn PositionMapFile::Append(const QString&, MarkTypes,
+ *                              const frm_pos_map_t&)
+ *  \brief Appends entries to the seek table of the local file mediafile.
+ *
+ *   This does not sync the file, entries lost in a crash are recreated
+ *   the same way as lost recordedseek rows, by rebuilding the seek table.
+ */
+bool PositionMapFile::Append(const QString &mediafile, MarkTypes type,
+                             const frm_pos_map_t &posMap)
+{
+    QMutexLocker locker(&write_lock);
+
+    QString filename = GetFilename(mediafile);
+    SeekTableLock lock(filename, true);
+    if (lock.Handle() < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to open '%1'").arg(filename) + ENO);
+        return false;
+    }
+
+    QByteArray buf;
+    if (lseek(lock.Handle(), 0, SEEK_END) == 0)
+        buf.append(kMagic, kMagicSize);
+    append_records(buf, type, posMap);
+
+    bool ok = write(lock.Handle(), buf.constData(), buf.size()) == buf.size();
+    if (!ok)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to append to '%1'").arg(filename) + ENO);
+    }
+    return ok;
+}
+
+/** \fn PositionMapFile::Save(const QString&, MarkTypes,
+ *                            const frm_pos_map_t&, int64_t, int64_t)
+ *  \brief Replaces the entries of the given type, optionally only those
+ *         in [min_frame,max_frame], and syncs the seek table to disk.
+ */
+bool PositionMapFile::Save(const QString &mediafile, MarkTypes type,
+                           const frm_pos_map_t &posMap,
+                           int64_t min_frame, int64_t max_frame)
+{
+    QMutexLocker locker(&write_lock);
+
+    SeekTableLock lock(GetFilename(mediafile), true);
+
+    pos_map_by_type_t maps;
+    ReadAll(mediafile, maps);
+
+    frm_pos_map_t &old = maps[type];
+    if (min_frame < 0 && max_frame < 0)
+    {
+        old = posMap;
+    }
+    else
+    {
+        frm_pos_map_t::iterator it = old.begin();
+        while (it != old.end())
+        {
+            if ((min_frame < 0 || it.key() >= (uint64_t)min_frame) &&
+                (max_frame < 0 || it.key() <= (uint64_t)max_frame))
+                it = old.erase(it);
+            else
+                ++it;
+        }
+
+        frm_pos_map_t::const_iterator nit = posMap.begin();
+        for (; nit != posMap.end(); ++nit)
+        {
+            if ((min_frame < 0 || nit.key() >= (uint64_t)min_frame) &&
+                (max_frame < 0 || nit.key() <= (uint64_t)max_frame))
+                old[nit.key()] = *nit;
+        }
+    }
+
+    return WriteAll(mediafile, maps);
+}
+
+/// Removes all entries of the given type from the seek table of mediafile.
+bool PositionMapFile::Clear(const QString &mediafile, MarkTypes type)
+{
+    QMutexLocker locker(&write_lock);
+
+    SeekTableLock lock(GetFilename(mediafile), false);
+    if (lock.Handle() < 0)
+        return true;
+
+    pos_map_by_type_t maps;
+    if (!ReadAll(mediafile, maps))
+        return true;
+
+    maps.remove(type);
+    if (maps.isEmpty())
+        return QFile::remove(GetFilename(mediafile));
+
+    return WriteAll(mediafile, maps);
+}
@@ -0,0 +1,46 @@
+#ifndef _POSITION_MAP_FILE_H_
+#define _POSITION_MAP_FILE_H_
+
+// Qt headers
+#include <QString>
+
+// MythTV headers
+#include "programtypes.h"
+#include "mythexp.h"
+
+/** \class PositionMapFile
+ *  \brief Stores the seek table of a recording in a compact binary file
+ *         next to the media file, instead of one recordedseek row per
+ *         keyframe.
+ *
+ *   The file starts with an 8 byte magic followed by fixed size records
+ *   of (type, frame, offset), all little endian. Records are only ever
+ *   appended while recording, a later record for the same frame and type
+ *   replaces an earlier one when the file is read back.
+ */
+class MPUBLIC PositionMapFile
+{
+  public:
+    static bool IsEnabled(void);
+    static QString GetFilename(const QString &mediafile)
+        { return mediafile + ".seek"; }
+
+    static bool Exists(const QString &mediafile);
+    static bool Load(const QString &mediafile, MarkTypes type,
+                     frm_pos_map_t &posMap);
+    static bool Append(const QString &mediafile, MarkTypes type,
+                       const frm_pos_map_t &posMap);
+    static bool Save(const QString &mediafile, MarkTypes type,
+                     const frm_pos_map_t &posMap,
+                     int64_t min_frame = -1, int64_t max_frame = -1);
+    static bool Clear(const QString &mediafile, MarkTypes type);
+
+  private:
+    typedef QMap<int, frm_pos_map_t> pos_map_by_type_t;
+
+    static bool ReadAll(const QString &mediafile, pos_map_by_type_t &maps);
+    static bool WriteAll(const QString &mediafile,
+                         const pos_map_by_type_t &maps);
+};
+
+#endif // _POSITION_MAP_FILE_H_
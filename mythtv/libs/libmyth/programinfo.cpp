@@ -15,6 +15,7 @@ using namespace std;
 // Qt headers
 #include <QRegExp>
 #include <QMap>
+#include <QHash>
 #include <QUrl>
 #include <QFile>
 #include <QFileInfo>
@@ -27,6 +28,7 @@ using namespace std;
 #include "mythmiscutil.h"
 #include "storagegroup.h"
 #include "mythlogging.h"
+#include "positionmapfile.h"
 #include "programinfo.h"
 #include "remotefile.h"
 #include "remoteutil.h"
@@ -3291,6 +3293,66 @@ void ProgramInfo::SaveMarkupFlag(MarkTypes type) const
     SaveMarkupMap(flagMap, type);
 }
 
+/// Caches the result of use_position_map_file() per recording, since it
+/// is asked on every seek table delta the recorder saves.
+static QMutex position_map_file_lock;
+static QHash<QString, bool> position_map_file_cache;
+
+/** \brief Returns true if the seek table of this local recording is
+ *         stored in a sidecar file.
+ *
+ *   A recording keeps its seek table where it started out, so a sidecar
+ *   is only created for recordings without any recordedseek rows. That
+ *   way enabling the setting never leaves part of a seek table in the
+ *   database and the rest in the file.
+ */
+static bool use_position_map_file(const ProgramInfo &pginfo)
+{
+    if (!pginfo.IsRecording() || !pginfo.IsLocal())
+        return false;
+
+    QString pathname = pginfo.GetPathname();
+
+    QMutexLocker locker(&position_map_file_lock);
+    QHash<QString, bool>::const_iterator it =
+        position_map_file_cache.find(pathname);
+    if (it != position_map_file_cache.end())
+        return *it;
+
+    bool use_file = true;
+    if (!PositionMapFile::Exists(pathname))
+    {
+        if (!PositionMapFile::IsEnabled())
+        {
+            use_file = false;
+        }
+        else
+        {
+            MSqlQuery query(MSqlQuery::InitCon());
+            query.prepare("SELECT type FROM recordedseek"
+                          " WHERE chanid = :CHANID"
+                          " AND starttime = :STARTTIME"
+                          " LIMIT 1");
+            query.bindValue(":CHANID", pginfo.GetChanID());
+            query.bindValue(":STARTTIME", pginfo.GetRecordingStartTime());
+
+            if (!query.exec())
+            {
+                MythDB::DBError("use_position_map_file", query);
+                return false;
+            }
+
+            use_file = !query.next();
+        }
+    }
+
+    if (position_map_file_cache.size() >= 1000)
+        position_map_file_cache.clear();
+    position_map_file_cache[pathname] = use_file;
+
+    return use_file;
+}
+
 void ProgramInfo::QueryPositionMap(
     frm_pos_map_t &posMap, MarkTypes type) const
 {
@@ -3303,6 +3365,17 @@ void ProgramInfo::QueryPositionMap(
     }
 
     posMap.clear();
+
+    // Recordings converted to, or made with, a sidecar seek table.
+    // Only look for one on another host when the setting is enabled,
+    // since that costs a round trip to the backend.
+    if (IsRecording() &&
+        (IsLocal() || (IsMythStream() && PositionMapFile::IsEnabled())) &&
+        PositionMapFile::Load(pathname, type, posMap) && !posMap.empty())
+    {
+        return;
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (IsVideo())
@@ -3346,6 +3419,15 @@ void ProgramInfo::ClearPositionMap(MarkTypes type) const
         return;
     }
 
+    if (IsRecording() && IsLocal())
+    {
+        PositionMapFile::Clear(pathname, type);
+
+        // the seek table may now be rebuilt under the current setting
+        QMutexLocker locker(&position_map_file_lock);
+        position_map_file_cache.remove(pathname);
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (IsVideo())
@@ -3423,6 +3505,12 @@ void ProgramInfo::SavePositionMap(
         return;
     }
 
+    if (use_position_map_file(*this))
+    {
+        PositionMapFile::Save(pathname, type, posMap, min_frame, max_frame);
+        return;
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
     QString comp;
 
@@ -3524,6 +3612,12 @@ void ProgramInfo::SavePositionMapDelta(
         return;
     }
 
+    if (use_position_map_file(*this))
+    {
+        PositionMapFile::Append(pathname, type, posMap);
+        return;
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (IsVideo())
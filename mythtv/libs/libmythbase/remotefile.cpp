@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 using namespace std;
 
@@ -12,6 +13,13 @@ using namespace std;
 #include "mythtimer.h"
 #include "mythdate.h"
 
+// Size limits of the adaptive block request used for streaming reads
+static const int kMinBlockSize = 64 * 1024;
+static const int kMaxBlockSize = 1024 * 1024;
+// Size a block so it takes about this long to transfer, which keeps
+// the request round trip a small fraction of the transfer time.
+static const int kBlockTargetMs = 200;
+
 RemoteFile::RemoteFile(const QString &_path, bool write, bool useRA,
                        int _timeout_ms,
                        const QStringList *possibleAuxiliaryFiles) :
@@ -22,7 +30,9 @@ RemoteFile::RemoteFile(const QString &_path, bool write, bool useRA,
     lock(QMutex::NonRecursive),
     controlSock(NULL),    sock(NULL),
     query("QUERY_FILETRANSFER %1"),
-    writemode(write)
+    writemode(write),
+    prefetchpos(0),       pendingsize(0),
+    blocksize(kMinBlockSize), prefetcheof(false)
 {
     if (writemode)
     {
@@ -217,6 +227,8 @@ bool RemoteFile::ReOpen(QString newFilename)
     if (!controlSock->isOpen() || controlSock->error())
         return false;
 
+    DrainPrefetch();
+
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "REOPEN";
     strlist << newFilename;
@@ -242,6 +254,7 @@ void RemoteFile::Close(void)
     strlist << "DONE";
 
     lock.lock();
+    DrainPrefetch();
     controlSock->writeStringList(strlist);
     if (!controlSock->readStringList(strlist, true))
     {
@@ -386,6 +399,8 @@ void RemoteFile::Reset(void)
         return;
     }
 
+    DrainPrefetch();
+
     while (sock && (sock->bytesAvailable() > 0))
     {
         int avail;
@@ -419,6 +434,8 @@ long long RemoteFile::Seek(long long pos, int whence, long long curpos)
     if (!controlSock->isOpen() || controlSock->error())
         return 0;
 
+    DrainPrefetch();
+
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "SEEK";
     strlist << QString::number(pos);
@@ -529,13 +546,18 @@ int RemoteFile::Write(const void *data, int size)
     return sent;
 }
 
+/** \fn RemoteFile::Read(void*, int)
+ *  \brief Reads size bytes from the backend.
+ *
+ *   When usereadahead is set the reads are assumed to be sequential, so
+ *   after answering a read the next block is requested right away and
+ *   the backend sends it while the caller consumes the current one. The
+ *   request size adapts to the measured throughput.
+ *
+ *  \return Number of bytes read, or -1 on error.
+ */
 int RemoteFile::Read(void *data, int size)
 {
-    int recv = 0;
-    int sent = 0;
-    bool error = false;
-    bool response = false;
-
     QMutexLocker locker(&lock);
     if (!sock)
     {
@@ -549,7 +571,7 @@ int RemoteFile::Read(void *data, int size)
     if (!controlSock->isOpen() || controlSock->error())
         return -1;
 
-    if (sock->bytesAvailable() > 0)
+    if (!pendingsize && sock->bytesAvailable() > 0)
     {
         LOG(VB_NETWORK, LOG_ERR,
                 "RemoteFile::Read(): Read socket not empty to start!");
@@ -562,7 +584,7 @@ int RemoteFile::Read(void *data, int size)
         }
     }
 
-    if (controlSock->bytesAvailable() > 0)
+    if (!pendingsize && controlSock->bytesAvailable() > 0)
     {
         LOG(VB_NETWORK, LOG_ERR,
                 "RemoteFile::Read(): Control socket not empty to start!");
@@ -570,25 +592,151 @@ int RemoteFile::Read(void *data, int size)
         controlSock->readStringList(tempstrlist);
     }
 
+    if (!usereadahead)
+    {
+        SendBlockRequest(size);
+        int ret = ReceiveBlock((char *)data, size);
+        if (ret > 0)
+            readposition += ret;
+        return ret;
+    }
+
+    int ret = ReadPrefetched((char *)data, size);
+    if (ret > 0)
+        readposition += ret;
+
+    // Keep the backend busy while our caller works on this block.
+    if (ret >= 0 && !pendingsize && !prefetcheof &&
+        (prefetch.size() - prefetchpos) < blocksize)
+    {
+        SendBlockRequest(blocksize);
+    }
+
+    return ret;
+}
+
+/** \fn RemoteFile::ReadPrefetched(char*, int)
+ *  \brief Fills data from the prefetched block, receiving the block in
+ *         flight or requesting a new one as needed.
+ *
+ *   WARNING: Must be called with lock held.
+ */
+int RemoteFile::ReadPrefetched(char *data, int size)
+{
+    int copied = 0;
+
+    // A short block may just mean we caught up with a recording in
+    // progress, so ask again on the next read.
+    prefetcheof = false;
+
+    while (copied < size)
+    {
+        int avail = prefetch.size() - prefetchpos;
+        if (avail > 0)
+        {
+            int len = min(avail, size - copied);
+            memcpy(data + copied, prefetch.constData() + prefetchpos, len);
+            prefetchpos += len;
+            copied += len;
+            continue;
+        }
+
+        if (prefetcheof)
+            break;
+
+        if (!pendingsize)
+            SendBlockRequest(max(size - copied, blocksize));
+
+        int requested = pendingsize;
+        prefetch.resize(requested);
+        prefetchpos = 0;
+        int ret = ReceiveBlock(prefetch.data(), requested);
+        if (ret < 0)
+        {
+            prefetch.clear();
+            return (copied > 0) ? copied : ret;
+        }
+        prefetch.resize(ret);
+        prefetcheof = ret < requested;
+    }
+
+    return copied;
+}
+
+/** \fn RemoteFile::DrainPrefetch(void)
+ *  \brief Completes any block request in flight and discards the
+ *         prefetched data, so that another command can be sent.
+ *
+ *   WARNING: Must be called with lock held.
+ */
+void RemoteFile::DrainPrefetch(void)
+{
+    if (pendingsize)
+    {
+        int requested = pendingsize;
+        prefetch.resize(requested);
+        ReceiveBlock(prefetch.data(), requested);
+    }
+    prefetch.clear();
+    prefetchpos = 0;
+    prefetcheof = false;
+}
+
+/** \fn RemoteFile::SendBlockRequest(int)
+ *  \brief Asks the backend for the next size bytes of the file.
+ *
+ *   WARNING: Must be called with lock held.
+ */
+void RemoteFile::SendBlockRequest(int size)
+{
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "REQUEST_BLOCK";
     strlist << QString::number(size);
     controlSock->writeStringList(strlist);
 
-    sent = size;
+    pendingsize = size;
+}
+
+/** \fn RemoteFile::ReceiveBlock(char*, int)
+ *  \brief Receives the data and response for the block request in flight.
+ *
+ *   WARNING: Must be called with lock held.
+ *
+ *  \return Number of bytes received, or -1 on error.
+ */
+int RemoteFile::ReceiveBlock(char *data, int size)
+{
+    int recv = 0;
+    int sent = size;
+    bool error = false;
+    bool response = false;
+    QStringList strlist;
+
+    pendingsize = 0;
 
     int waitms = 10;
     MythTimer mtimer;
     mtimer.start();
 
+    // Times the transfer itself, the request may have been sent long
+    // before we came back for the reply. Whatever had already arrived
+    // by then says nothing about the speed of the link.
+    MythTimer rxtimer;
+    int rxbase = -1;
+
     while (recv < sent && !error && mtimer.elapsed() < 10000)
     {
         while (recv < sent && sock->waitForMore(waitms) > 0)
         {
-            int ret = sock->readBlock(((char *)data) + recv, sent - recv);
+            int ret = sock->readBlock(data + recv, sent - recv);
             if (ret > 0)
             {
                 recv += ret;
+                if (rxbase < 0)
+                {
+                    rxbase = recv;
+                    rxtimer.start();
+                }
             }
             else if (sock->error() != MythSocket::NoError)
             {
@@ -631,7 +779,19 @@ int RemoteFile::Read(void *data, int size)
         return sent;
 
     if (error || sent != recv)
-        recv = -1;
+        return -1;
+
+    // Only full blocks tell us how fast the link is, short ones are
+    // limited by how much the backend had to send.
+    int elapsed = (rxbase < 0) ? 0 : rxtimer.elapsed();
+    if (usereadahead && recv == size && elapsed > 0 && recv > rxbase)
+    {
+        long long target =
+            (long long)(recv - rxbase) * kBlockTargetMs / elapsed;
+        target = (blocksize + target) / 2;
+        blocksize = (int)max((long long)kMinBlockSize,
+                             min((long long)kMaxBlockSize, target));
+    }
 
     return recv;
 }
@@ -666,6 +826,8 @@ void RemoteFile::SetTimeout(bool fast)
     if (!controlSock->isOpen() || controlSock->error())
         return;
 
+    DrainPrefetch();
+
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "SET_TIMEOUT";
     strlist << QString::number((int)fast);
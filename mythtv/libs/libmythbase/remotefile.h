@@ -57,6 +57,10 @@ class MBASE_PUBLIC RemoteFile
 
   private:
     MythSocket     *openSocket(bool control);
+    void            SendBlockRequest(int size);
+    int             ReceiveBlock(char *data, int size);
+    int             ReadPrefetched(char *data, int size);
+    void            DrainPrefetch(void);
 
     QString         path;
     bool            usereadahead;
@@ -75,6 +79,14 @@ class MBASE_PUBLIC RemoteFile
 
     QStringList     possibleauxfiles;
     QStringList     auxfiles;
+
+    // Streaming reads keep one block request in flight and hand out
+    // the previously received block from here.
+    QByteArray      prefetch;
+    int             prefetchpos;
+    int             pendingsize;
+    int             blocksize;
+    bool            prefetcheof;
 };
 
 #endif
@@ -22,6 +22,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <complex>
 #include <cmath>
 #include <vector>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 #ifdef USE_FFTW3
 #include "fftw3.h"
 #else
@@ -204,6 +207,9 @@ public:
         const float modes[4][2] = {{0,0},{0,PI},{PI,0},{-PI/2,PI/2}};
         phase_offsetL = modes[mode][0];
         phase_offsetR = modes[mode][1];
+        // the offsets as rotations, so the bins need no polar conversion
+        rotateL = polar(1,phase_offsetL);
+        rotateR = polar(1,phase_offsetR);
     }
 
     // what steering mode should be chosen
@@ -225,6 +231,65 @@ private:
     static inline float min(float a, float b) { return a<b?a:b; }
     static inline float max(float a, float b) { return a>b?a:b; }
     static inline float clamp(float x) { return max(-1,min(1,x)); }
+    // the bin scaled to the given amplitude, keeping its phase
+    static inline cfloat rescale(const float cf[2], float amp, float a) {
+        return (amp > 0) ? cfloat(cf[0]*(a/amp),cf[1]*(a/amp)) : cfloat(a,0);
+    }
+
+    // out = in * wnd, the loops below are where the time goes outside the FFTs
+    static inline void window(float *out, const float *in, const float *wnd, unsigned n) {
+        unsigned k = 0;
+#ifdef __SSE__
+        for (;k+4<=n;k+=4)
+            _mm_storeu_ps(out+k,_mm_mul_ps(_mm_loadu_ps(in+k),_mm_loadu_ps(wnd+k)));
+#endif
+        for (;k<n;k++)
+            out[k] = in[k] * wnd[k];
+    }
+
+    // out = in * flt, for n complex bins and a real filter
+    static inline void scale_bins(float *out, const cfloat *in, const float *flt, unsigned n) {
+        const float *pin = reinterpret_cast<const float*>(in);
+        unsigned f = 0;
+#ifdef __SSE__
+        for (;f+4<=n;f+=4) {
+            __m128 fl = _mm_loadu_ps(flt+f);
+            _mm_storeu_ps(out+2*f,  _mm_mul_ps(_mm_loadu_ps(pin+2*f),  _mm_unpacklo_ps(fl,fl)));
+            _mm_storeu_ps(out+2*f+4,_mm_mul_ps(_mm_loadu_ps(pin+2*f+4),_mm_unpackhi_ps(fl,fl)));
+        }
+#endif
+        for (;f<n;f++) {
+            out[2*f]   = pin[2*f]   * flt[f];
+            out[2*f+1] = pin[2*f+1] * flt[f];
+        }
+    }
+
+    // t1 += w1 * d1 (overlap add) and t2 = w2 * d2 (no history yet),
+    // where d1/d2 hold a sample every step floats (1 real, 2 complex)
+    static inline void overlap(float *t1, float *t2, const float *w1, const float *w2,
+                               const float *d1, const float *d2, unsigned n, unsigned step) {
+        unsigned k = 0;
+#ifdef __SSE__
+        if (step == 1) {
+            for (;k+4<=n;k+=4) {
+                _mm_storeu_ps(t1+k,_mm_add_ps(_mm_loadu_ps(t1+k),
+                                              _mm_mul_ps(_mm_loadu_ps(w1+k),_mm_loadu_ps(d1+k))));
+                _mm_storeu_ps(t2+k,_mm_mul_ps(_mm_loadu_ps(w2+k),_mm_loadu_ps(d2+k)));
+            }
+        } else if (step == 2) {
+            for (;k+4<=n;k+=4) {
+                __m128 r1 = _mm_shuffle_ps(_mm_loadu_ps(d1+2*k),_mm_loadu_ps(d1+2*k+4),_MM_SHUFFLE(2,0,2,0));
+                __m128 r2 = _mm_shuffle_ps(_mm_loadu_ps(d2+2*k),_mm_loadu_ps(d2+2*k+4),_MM_SHUFFLE(2,0,2,0));
+                _mm_storeu_ps(t1+k,_mm_add_ps(_mm_loadu_ps(t1+k),_mm_mul_ps(_mm_loadu_ps(w1+k),r1)));
+                _mm_storeu_ps(t2+k,_mm_mul_ps(_mm_loadu_ps(w2+k),r2));
+            }
+        }
+#endif
+        for (;k<n;k++) {
+            t1[k] += w1[k] * d1[k*step];
+            t2[k]  = w2[k] * d2[k*step];
+        }
+    }
 
     // handle the output buffering for overlapped calls of block_decode
     void add_output(float *input1[2], float *input2[2], float center_width, float dimension, float adaption_rate, bool result=false) {
@@ -238,23 +303,10 @@ private:
         // 1. scale the input by the window function; this serves a dual purpose:
         // - first it improves the FFT resolution b/c boundary discontinuities (and their frequencies) get removed
         // - second it allows for smooth blending of varying filters between the blocks
-        {
-            float* pWnd = &wnd[0];
-            float* pLt = &lt[0];
-            float* pRt = &rt[0];
-            float* pIn0 = input1[0];
-            float* pIn1 = input1[1];
-            for (unsigned k=0;k<halfN;k++) {
-                *pLt++ = *pIn0++ * *pWnd;
-                *pRt++ = *pIn1++ * *pWnd++;
-            }
-            pIn0 = input2[0];
-            pIn1 = input2[1];
-            for (unsigned k=0;k<halfN;k++) {
-                *pLt++ = *pIn0++ * *pWnd;
-                *pRt++ = *pIn1++ * *pWnd++;
-            }
-        }
+        window(&lt[0],input1[0],&wnd[0],halfN);
+        window(&rt[0],input1[1],&wnd[0],halfN);
+        window(&lt[halfN],input2[0],&wnd[halfN],halfN);
+        window(&rt[halfN],input2[1],&wnd[halfN],halfN);
 
 #ifdef USE_FFTW3
         // ... and tranform it into the frequency domain
@@ -271,18 +323,27 @@ private:
         // 2. compare amplitude and phase of each DFT bin and produce the X/Y coordinates in the sound field
         //    but dont do DC or N/2 component
         for (unsigned f=0;f<halfN;f++) {           
-            // get left/right amplitudes/phases
+            // get left/right amplitudes
             float ampL = amplitude(dftL[f]), ampR = amplitude(dftR[f]);
-            float phaseL = phase(dftL[f]), phaseR = phase(dftR[f]);
 //          if (ampL+ampR < epsilon)
 //              continue;       
 
-            // calculate the amplitude/phase difference
+            // calculate the amplitude/phase difference; the absolute phase
+            // difference is the angle between the two bins, which takes one
+            // atan2 of L*conj(R) rather than one per channel
             float ampDiff = clamp((ampL+ampR < epsilon) ? 0 : (ampR-ampL) / (ampR+ampL));
-            float phaseDiff = phaseL - phaseR;
-            if (phaseDiff < -PI) phaseDiff += 2*PI;
-            if (phaseDiff > PI) phaseDiff -= 2*PI;
-            phaseDiff = abs(phaseDiff);
+            float phaseDiff;
+            if (ampL > 0 && ampR > 0) {
+                phaseDiff = atan2(fabs(dftL[f][1]*dftR[f][0] - dftL[f][0]*dftR[f][1]),
+                                  dftL[f][0]*dftR[f][0] + dftL[f][1]*dftR[f][1]);
+            } else {
+                // a silent bin has no angle to the other one, the steering
+                // has always used the other bin's own phase for it
+                phaseDiff = phase(dftL[f]) - phase(dftR[f]);
+                if (phaseDiff < -PI) phaseDiff += 2*PI;
+                if (phaseDiff > PI) phaseDiff -= 2*PI;
+                phaseDiff = abs(phaseDiff);
+            }
 
             if (linear_steering) {
                 // --- this is the fancy new linear mode ---
@@ -315,13 +376,6 @@ private:
             } else {
                 // --- this is the old & simple steering mode ---
 
-                // calculate the amplitude/phase difference
-                float ampDiff = clamp((ampL+ampR < epsilon) ? 0 : (ampR-ampL) / (ampR+ampL));
-                float phaseDiff = phaseL - phaseR;
-                if (phaseDiff < -PI) phaseDiff += 2*PI;
-                if (phaseDiff > PI) phaseDiff -= 2*PI;
-                phaseDiff = abs(phaseDiff);
-
                 // determine sound field x-position
                 xfs[f] = ampDiff;
 
@@ -359,11 +413,11 @@ private:
             }
 
             // ... and build the signal which we want to position
-            frontL[f] = polar(ampL+ampR,phaseL);
-            frontR[f] = polar(ampL+ampR,phaseR);
+            frontL[f] = rescale(dftL[f],ampL,ampL+ampR);
+            frontR[f] = rescale(dftR[f],ampR,ampL+ampR);
             avg[f] = frontL[f] + frontR[f];
-            surL[f] = polar(ampL+ampR,phaseL+phase_offsetL);
-            surR[f] = polar(ampL+ampR,phaseR+phase_offsetR);
+            surL[f] = frontL[f] * rotateL;
+            surR[f] = frontR[f] * rotateR;
             trueavg[f] = cfloat(dftL[f][0] + dftR[f][0], dftL[f][1] + dftR[f][1]);
         }
 
@@ -428,28 +482,14 @@ private:
     void apply_filter(cfloat *signal, float *flt, float *target) {
         // filter the signal
         unsigned f;
-        for (f=0;f<=halfN;f++) {
-            src[f][0] = signal[f].real() * flt[f];
-            src[f][1] = signal[f].imag() * flt[f];
-        }
+        scale_bins(&src[0][0],signal,flt,halfN+1);
 #ifdef USE_FFTW3
         // transform into time domain
         fftwf_execute(store);
 
-        float* pT1   = &target[current_buf*halfN];
-        float* pWnd1 = &wnd[0];
-        float* pDst1 = &dst[0];
-        float* pT2   = &target[(current_buf^1)*halfN];
-        float* pWnd2 = &wnd[halfN];
-        float* pDst2 = &dst[halfN];
         // add the result to target, windowed
-        for (unsigned int k=0;k<halfN;k++)
-        {
-            // 1st part is overlap add
-            *pT1++ += *pWnd1++ * *pDst1++;
-            // 2nd part is set as has no history
-            *pT2++  = *pWnd2++ * *pDst2++;
-        }
+        overlap(&target[current_buf*halfN],&target[(current_buf^1)*halfN],
+                &wnd[0],&wnd[halfN],&dst[0],&dst[halfN],halfN,1);
 #else
         // enforce odd symmetry
         for (f=1;f<halfN;f++) {
@@ -459,20 +499,9 @@ private:
         av_fft_permute(fftContextReverse, (FFTComplex*)&src[0]);
         av_fft_calc(fftContextReverse, (FFTComplex*)&src[0]);
 
-        float* pT1   = &target[current_buf*halfN];
-        float* pWnd1 = &wnd[0];
-        float* pDst1 = &src[0][0];
-        float* pT2   = &target[(current_buf^1)*halfN];
-        float* pWnd2 = &wnd[halfN];
-        float* pDst2 = &src[halfN][0];
-        // add the result to target, windowed
-        for (unsigned int k=0;k<halfN;k++)
-        {
-            // 1st part is overlap add
-            *pT1++ += *pWnd1++ * *pDst1; pDst1 += 2;
-            // 2nd part is set as has no history
-            *pT2++  = *pWnd2++ * *pDst2; pDst2 += 2;
-        }
+        // add the result to target, windowed (real parts only)
+        overlap(&target[current_buf*halfN],&target[(current_buf^1)*halfN],
+                &wnd[0],&wnd[halfN],&src[0][0],&src[halfN][0],halfN,2);
 #endif
     }
 
@@ -543,6 +572,7 @@ private:
     float surround_balance;            // the xfs balance that follows from the coeffs
     float surround_level;              // gain for the surround channels (follows from the coeffs
     float phase_offsetL, phase_offsetR;// phase shifts to be applied to the rear channels
+    cfloat rotateL, rotateR;           // the same phase shifts as unit vectors
     float front_separation;            // front stereo separation
     float rear_separation;             // rear stereo separation
     bool linear_steering;              // whether the steering should be linear or not
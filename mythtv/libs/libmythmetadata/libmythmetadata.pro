@@ -16,14 +16,14 @@ HEADERS += cleanup.h  dbaccess.h  dirscan.h  globals.h  parentalcontrols.h
 HEADERS += videoscan.h  videoutils.h  videometadata.h  videometadatalistmanager.h
 HEADERS += quicksp.h metadatacommon.h metadatadownload.h metadataimagedownload.h
 HEADERS += bluraymetadata.h mythmetaexp.h metadatafactory.h mythuimetadataresults.h
-HEADERS += mythuiimageresults.h
+HEADERS += mythuiimageresults.h videoscanwatcher.h
 
 SOURCES += cleanup.cpp  dbaccess.cpp  dirscan.cpp  globals.cpp
 SOURCES += parentalcontrols.cpp  videoscan.cpp  videoutils.cpp
 SOURCES += videometadata.cpp  videometadatalistmanager.cpp
 SOURCES += metadatacommon.cpp metadatadownload.cpp metadataimagedownload.cpp
 SOURCES += bluraymetadata.cpp metadatafactory.cpp mythuimetadataresults.cpp
-SOURCES += mythuiimageresults.cpp
+SOURCES += mythuiimageresults.cpp videoscanwatcher.cpp
 
 INCLUDEPATH += ../libmythbase ../libmythtv
 INCLUDEPATH += ../.. ../ ./ ../libmythupnp ../libmythui
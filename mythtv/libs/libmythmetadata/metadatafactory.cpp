@@ -1,5 +1,7 @@
 #include <QApplication>
 #include <QList>
+#include <QSet>
+#include <QStringList>
 #include <QUrl>
 
 #include "mythcontext.h"
@@ -14,6 +16,7 @@
 
 // Needed for video scanning
 #include "videometadatalistmanager.h"
+#include "videoscanwatcher.h"
 #include "globals.h"
 
 // Input for a lookup
@@ -42,6 +45,7 @@ MetadataFactory::MetadataFactory(QObject *parent) :
     m_lookupthread = new MetadataDownload(this);
     m_imagedownload = new MetadataImageDownload(this);
     m_videoscanner = new VideoScannerThread(this);
+    m_videowatcher = NULL;
 
     m_mlm = new VideoMetadataListManager();
 }
@@ -64,6 +68,8 @@ MetadataFactory::~MetadataFactory()
 
     if (m_videoscanner && m_videoscanner->wait())
         delete m_videoscanner;
+
+    delete m_videowatcher;
 }
 
 void MetadataFactory::Lookup(RecordingRule *recrule, bool automatic,
@@ -231,6 +237,14 @@ bool MetadataFactory::VideoGrabbersFunctional()
             m_lookupthread->TelevisionGrabberWorks());
 }
 
+bool MetadataFactory::IsRunning()
+{
+    return m_lookupthread->isRunning() ||
+           m_imagedownload->isRunning() ||
+           m_videoscanner->isRunning() ||
+           (m_videowatcher && m_videowatcher->IsScanning());
+}
+
 void MetadataFactory::VideoScan()
 {
     if (IsRunning())
@@ -259,6 +273,21 @@ void MetadataFactory::VideoScan(QStringList hosts)
     m_videoscanner->start();
 }
 
+/** \fn MetadataFactory::VideoScanWatch(void)
+ *  \brief Keeps the video database up to date by watching the video
+ *         directories on this host, instead of waiting for a full scan.
+ */
+void MetadataFactory::VideoScanWatch(void)
+{
+    if (m_videowatcher)
+        return;
+
+    m_scanning = true;
+
+    m_videowatcher = new VideoScanWatcher(this, m_videoscanner);
+    m_videowatcher->Start(GetVideoDirs());
+}
+
 void MetadataFactory::OnMultiResult(MetadataLookupList list)
 {
     if (!list.size())
@@ -568,13 +597,15 @@ void MetadataFactory::customEvent(QEvent *levent)
         QList<int> moves = vsc->moved;
         QList<int> deletions = vsc->deleted;
 
+        LOG(VB_GENERAL, LOG_INFO,
+            QString("Video Scan Complete: a(%1) m(%2) d(%3)")
+            .arg(additions.count()).arg(moves.count())
+            .arg(deletions.count()));
+
+        UpdateVideoList(additions, moves, deletions);
+
         if (!m_scanning)
         {
-            LOG(VB_GENERAL, LOG_INFO,
-                QString("Video Scan Complete: a(%1) m(%2) d(%3)")
-                .arg(additions.count()).arg(moves.count())
-                .arg(deletions.count()));
-
             if (m_parent)
                 QCoreApplication::postEvent(m_parent,
                     new MetadataFactoryVideoChanges(additions, moves,
@@ -582,15 +613,6 @@ void MetadataFactory::customEvent(QEvent *levent)
         }
         else
         {
-            LOG(VB_GENERAL, LOG_INFO,
-                QString("Video Scan Complete: a(%1) m(%2) d(%3)")
-                .arg(additions.count()).arg(moves.count())
-                .arg(deletions.count()));
-
-            VideoMetadataListManager::metadata_list ml;
-            VideoMetadataListManager::loadAllFromDatabase(ml);
-            m_mlm->setList(ml);
-
             for (QList<int>::const_iterator it = additions.begin();
                 it != additions.end(); ++it)
             {
@@ -604,6 +626,45 @@ void MetadataFactory::customEvent(QEvent *levent)
     }
 }
 
+/** \fn MetadataFactory::UpdateVideoList(const QList<int>&,
+ *                                        const QList<int>&,
+ *                                        const QList<int>&)
+ *  \brief Applies the changes found by a video scan to m_mlm, reading
+ *         only the added and moved videos from the database.
+ *
+ *   Videos that are kept stay the same objects, so lookups that are
+ *   still running for them remain valid.
+ */
+void MetadataFactory::UpdateVideoList(const QList<int> &additions,
+                                      const QList<int> &moves,
+                                      const QList<int> &deletions)
+{
+    QSet<int> changed = additions.toSet() + moves.toSet();
+    QSet<int> gone = changed + deletions.toSet();
+
+    VideoMetadataListManager::metadata_list ml;
+    VideoMetadataListManager::metadata_list::const_iterator p =
+        m_mlm->getList().begin();
+    for (; p != m_mlm->getList().end(); ++p)
+    {
+        if (!gone.contains((*p)->GetID()))
+            ml.push_back(*p);
+    }
+
+    if (!changed.empty())
+    {
+        QStringList ids;
+        QSet<int>::const_iterator it = changed.begin();
+        for (; it != changed.end(); ++it)
+            ids << QString::number(*it);
+
+        VideoMetadataListManager::loadAllFromDatabase(ml,
+            QString("WHERE intid IN (%1)").arg(ids.join(",")));
+    }
+
+    m_mlm->setList(ml);
+}
+
 // These functions exist to determine if we have enough
 // information to conclusively call something a Show vs. Movie
 
@@ -14,6 +14,7 @@
 
 class VideoMetadata;
 class RecordingRule;
+class VideoScanWatcher;
 
 class META_PUBLIC MetadataFactoryMultiResult : public QEvent
 {
@@ -94,10 +95,9 @@ class META_PUBLIC MetadataFactory : public QObject
 
     void VideoScan();
     void VideoScan(QStringList hosts);
+    void VideoScanWatch(void);
 
-    bool IsRunning() { return m_lookupthread->isRunning() ||
-                              m_imagedownload->isRunning() ||
-                              m_videoscanner->isRunning(); };
+    bool IsRunning();
 
     bool VideoGrabbersFunctional();
 
@@ -111,13 +111,19 @@ class META_PUBLIC MetadataFactory : public QObject
     void OnImageResult(MetadataLookup *lookup);
 
     void OnVideoResult(MetadataLookup *lookup);
+    void UpdateVideoList(const QList<int> &additions,
+                         const QList<int> &moves,
+                         const QList<int> &deletions);
 
     QObject *m_parent;
     MetadataDownload *m_lookupthread;
     MetadataImageDownload *m_imagedownload;
 
     VideoScannerThread *m_videoscanner;
+    VideoScanWatcher *m_videowatcher;
     VideoMetadataListManager *m_mlm;
+    /// Set once this factory scans videos itself, lookup results for
+    /// the videos it finds are then stored rather than passed on.
     bool m_scanning;
 
     // Variables used in synchronous mode
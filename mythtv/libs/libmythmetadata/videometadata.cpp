@@ -4,6 +4,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QRegExp>
+#include <QAtomicInt>
 
 #include "mythcorecontext.h"
 #include "mythmiscutil.h"
@@ -1753,18 +1754,28 @@ void VideoMetadata::SetCategoryID(int id)
     m_imp->SetCategoryID(id);
 }
 
+static QAtomicInt s_database_change_count;
+
+int VideoMetadata::GetDatabaseChangeCount(void)
+{
+    return s_database_change_count;
+}
+
 void VideoMetadata::SaveToDatabase()
 {
     m_imp->SaveToDatabase();
+    s_database_change_count.ref();
 }
 
 void VideoMetadata::UpdateDatabase()
 {
     m_imp->UpdateDatabase();
+    s_database_change_count.ref();
 }
 
 bool VideoMetadata::DeleteFromDatabase()
 {
+    s_database_change_count.ref();
     return m_imp->DeleteFromDatabase();
 }
 
@@ -59,6 +59,8 @@ class META_PUBLIC VideoMetadata
     static QString VideoFileHash(const QString &file_name, const QString &host);
     static QString FilenameToMeta(const QString &file_name, int position);
     static QString TrimTitle(const QString &title, bool ignore_case);
+    /// Incremented whenever any video's metadata is written to the database
+    static int GetDatabaseChangeCount(void);
 
   public:
     VideoMetadata(const QString &filename = QString(),
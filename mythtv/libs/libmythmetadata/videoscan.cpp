@@ -11,11 +11,18 @@
 #include "dirscan.h"
 #include "videometadatalistmanager.h"
 #include "videoscan.h"
+#include "videoscanwatcher.h"
 #include "videoutils.h"
 #include "mythevent.h"
 #include "remoteutil.h"
 #include "mythlogging.h"
 #include "mythdate.h"
+#include "mythmiscutil.h"
+#include "mythdb.h"
+
+/// Above this many changed files an incremental scan loads the whole
+/// videometadata table rather than looking the files up by name.
+static const int kMaxIncrementalLookup = 500;
 
 QEvent::Type VideoScanChanges::kEventType =
     (QEvent::Type) QEvent::registerEventType();
@@ -76,6 +83,7 @@ class MythUIProgressDialog;
 VideoScannerThread::VideoScannerThread(QObject *parent) :
     MThread("VideoScanner"),
     m_RemoveAll(false), m_KeepAll(false),
+    m_snapshot(NULL), m_dialog(NULL),
     m_DBDataChanged(false)
 {
     m_parent = parent;
@@ -143,24 +151,77 @@ void VideoScannerThread::SetDirs(QStringList dirs)
                                             0, *iter2, "Videos"));
 
     m_directories = dirs;
+    m_snapshot = NULL;
+}
+
+/** \fn VideoScannerThread::SetIncremental(VideoScanSnapshot*,const QStringList&)
+ *  \brief Makes the next run() only look at the given local directories,
+ *         using the snapshot to find what changed in them.
+ *
+ *   If dirs is empty all of the snapshot's root directories are checked.
+ *   The snapshot must not be touched by anyone else while the scan runs.
+ */
+void VideoScannerThread::SetIncremental(VideoScanSnapshot *snapshot,
+                                        const QStringList &dirs)
+{
+    m_snapshot = snapshot;
+    m_changedDirs = dirs;
 }
 
 void VideoScannerThread::run()
 {
     RunProlog();
 
-    VideoMetadataListManager::metadata_list ml;
-    VideoMetadataListManager::loadAllFromDatabase(ml);
-    m_dbmetadata->setList(ml);
-
     QList<QByteArray> image_types = QImageReader::supportedImageFormats();
-    QStringList imageExtensions;
+    m_imageExtensions.clear();
     for (QList<QByteArray>::const_iterator p = image_types.begin();
          p != image_types.end(); ++p)
     {
-        imageExtensions.push_back(QString(*p));
+        m_imageExtensions.push_back(QString(*p));
+    }
+
+    if (m_snapshot)
+    {
+        ResetCounts();
+        m_DBDataChanged = incrementalScan();
+    }
+    else
+    {
+        VideoMetadataListManager::metadata_list ml;
+        VideoMetadataListManager::loadAllFromDatabase(ml);
+        m_dbmetadata->setList(ml);
+
+        m_DBDataChanged = fullScan();
+    }
+
+    if (m_DBDataChanged)
+    {
+        QCoreApplication::postEvent(m_parent,
+            new VideoScanChanges(m_addList, m_movList,
+                                 m_delList));
+
+        QStringList slist;
+
+        QList<int>::const_iterator i;
+        for (i = m_addList.begin(); i != m_addList.end(); ++i)
+            slist << QString("added::%1").arg(*i);
+        for (i = m_movList.begin(); i != m_movList.end(); ++i)
+            slist << QString("moved::%1").arg(*i);
+        for (i = m_delList.begin(); i != m_delList.end(); ++i)
+            slist << QString("deleted::%1").arg(*i);
+
+        MythEvent me("VIDEO_LIST_CHANGE", slist);
+
+        gCoreContext->SendEvent(me);
     }
+    else if (!m_snapshot)
+        gCoreContext->SendMessage("VIDEO_LIST_NO_CHANGE");
+
+    RunEpilog();
+}
 
+bool VideoScannerThread::fullScan(void)
+{
     LOG(VB_GENERAL, LOG_INFO, QString("Beginning Video Scan."));
 
     uint counter = 0;
@@ -172,7 +233,7 @@ void VideoScannerThread::run()
     for (QStringList::const_iterator iter = m_directories.begin();
          iter != m_directories.end(); ++iter)
     {
-        if (!buildFileList(*iter, imageExtensions, fs_files))
+        if (!buildFileList(*iter, m_imageExtensions, fs_files))
         {
             if (iter->startsWith("myth://"))
             {
@@ -192,32 +253,111 @@ void VideoScannerThread::run()
 
     PurgeList db_remove;
     verifyFiles(fs_files, db_remove);
-    m_DBDataChanged = updateDB(fs_files, db_remove);
+    return updateDB(fs_files, db_remove);
+}
 
-    if (m_DBDataChanged)
+/** \fn VideoScannerThread::incrementalScan(void)
+ *  \brief Updates the database with only the files that were added to or
+ *         removed from the changed directories since the last snapshot.
+ *
+ *   Files whose size and modification time match a file removed in the
+ *   same pass are treated as moves and reuse the snapshot's hash rather
+ *   than hashing the file again.
+ */
+bool VideoScannerThread::incrementalScan(void)
+{
+    FileAssociations::ext_ignore_list ext_list;
+    FileAssociations::getFileAssociation().getExtensionIgnoreList(ext_list);
+    m_snapshot->SetFilter(ext_list, m_ListUnknown, m_imageExtensions);
+
+    VideoScanSnapshot::FileList added, removed;
+    m_snapshot->Update(m_changedDirs, added, removed);
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Incremental Video Scan of %1 directories: "
+                "%2 new files, %3 removed files")
+            .arg(m_changedDirs.empty() ? QString("all") :
+                 QString::number(m_changedDirs.size()))
+            .arg(added.size()).arg(removed.size()));
+
+    // Only the rows for the files in this batch are needed, unless the
+    // batch is so large that one full load is cheaper than a long IN list.
+    VideoMetadataListManager::metadata_list ml;
+    if (added.size() + removed.size() > kMaxIncrementalLookup)
     {
-        QCoreApplication::postEvent(m_parent,
-            new VideoScanChanges(m_addList, m_movList,
-                                 m_delList));
+        VideoMetadataListManager::loadAllFromDatabase(ml);
+    }
+    else if (!added.empty() || !removed.empty())
+    {
+        QStringList holders;
+        MSqlBindings bindings;
+        VideoScanSnapshot::FileList::const_iterator fit = added.begin();
+        for (; fit != added.end(); ++fit)
+        {
+            QString holder = QString(":FILE%1").arg(holders.size());
+            holders << holder;
+            bindings[holder] = fit->filename;
+        }
+        for (fit = removed.begin(); fit != removed.end(); ++fit)
+        {
+            QString holder = QString(":FILE%1").arg(holders.size());
+            holders << holder;
+            bindings[holder] = fit->filename;
+        }
+        QString sql = QString("WHERE filename IN (%1)")
+            .arg(holders.join(","));
+        MSqlEscapeAsAQuery(sql, bindings);
+        VideoMetadataListManager::loadAllFromDatabase(ml, sql);
+    }
+    m_dbmetadata->setList(ml);
 
-        QStringList slist;
+    FileCheckList fs_files;
+    VideoScanSnapshot::FileList::iterator it = added.begin();
+    for (; it != added.end(); ++it)
+    {
+        VideoMetadataListManager::VideoMetadataPtr meta =
+            m_dbmetadata->byFilename(it->filename);
+        if (meta && meta->GetHost().toLower() == it->host)
+            continue; // already known, e.g. the snapshot was just created
 
-        QList<int>::const_iterator i;
-        for (i = m_addList.begin(); i != m_addList.end(); ++i)
-            slist << QString("added::%1").arg(*i);
-        for (i = m_movList.begin(); i != m_movList.end(); ++i)
-            slist << QString("moved::%1").arg(*i);
-        for (i = m_delList.begin(); i != m_delList.end(); ++i)
-            slist << QString("deleted::%1").arg(*i);
+        if (it->hash.isEmpty())
+        {
+            VideoScanSnapshot::FileList::const_iterator rit = removed.begin();
+            for (; rit != removed.end(); ++rit)
+            {
+                if (rit->size == it->size && rit->mtime == it->mtime &&
+                    rit->host == it->host && !rit->hash.isEmpty())
+                {
+                    it->hash = rit->hash;
+                    break;
+                }
+            }
+        }
 
-        MythEvent me("VIDEO_LIST_CHANGE", slist);
+        if (it->hash.isEmpty())
+            it->hash = FileHash(it->path);
+        m_snapshot->SetHash(it->path, it->hash);
 
-        gCoreContext->SendEvent(me);
+        fs_files[it->filename].check = false;
+        fs_files[it->filename].host  = it->host;
+        fs_files[it->filename].hash  = it->hash;
     }
-    else
-        gCoreContext->SendMessage("VIDEO_LIST_NO_CHANGE");
 
-    RunEpilog();
+    PurgeList db_remove;
+    VideoScanSnapshot::FileList::const_iterator rit = removed.begin();
+    for (; rit != removed.end(); ++rit)
+    {
+        VideoMetadataListManager::VideoMetadataPtr meta =
+            m_dbmetadata->byFilename(rit->filename);
+        if (meta && meta->GetHost().toLower() == rit->host)
+            db_remove.push_back(std::make_pair(meta->GetID(), rit->filename));
+    }
+
+    bool changed = updateDB(fs_files, db_remove);
+
+    m_snapshot->Save();
+
+    return changed;
 }
 
 
@@ -311,7 +451,9 @@ bool VideoScannerThread::updateDB(const FileCheckList &add, const PurgeList &rem
             int id = -1;
 
             // Are we sure this needs adding?  Let's check our Hash list.
-            QString hash = VideoMetadata::VideoFileHash(p->first, p->second.host);
+            QString hash = p->second.hash;
+            if (hash.isEmpty())
+                hash = VideoMetadata::VideoFileHash(p->first, p->second.host);
             if (hash != "NULL" && !hash.isEmpty())
             {
                 id = VideoMetadata::UpdateHashedDBRecord(hash, p->first, p->second.host);
@@ -17,6 +17,7 @@ class QStringList;
 class MythUIProgressDialog;
 
 class VideoMetadataListManager;
+class VideoScanSnapshot;
 
 class META_PUBLIC VideoScanner : public QObject
 {
@@ -66,6 +67,7 @@ class META_PUBLIC VideoScannerThread : public MThread
     void SetDirs(QStringList dirs);
     void SetHosts(const QStringList &hosts);
     void SetProgressDialog(MythUIProgressDialog *dialog) { m_dialog = dialog; };
+    void SetIncremental(VideoScanSnapshot *snapshot, const QStringList &dirs);
     QStringList GetOfflineSGHosts(void) { return m_offlineSGHosts; };
     bool getDataChanged() { return m_DBDataChanged; };
 
@@ -77,6 +79,7 @@ class META_PUBLIC VideoScannerThread : public MThread
     {
         bool check;
         QString host;
+        QString hash;
     };
 
     typedef std::vector<std::pair<unsigned int, QString> > PurgeList;
@@ -84,6 +87,8 @@ class META_PUBLIC VideoScannerThread : public MThread
 
     void removeOrphans(unsigned int id, const QString &filename);
 
+    bool fullScan(void);
+    bool incrementalScan(void);
     void verifyFiles(FileCheckList &files, PurgeList &remove);
     bool updateDB(const FileCheckList &add, const PurgeList &remove);
     bool buildFileList(const QString &directory,
@@ -102,6 +107,10 @@ class META_PUBLIC VideoScannerThread : public MThread
     QStringList m_directories;
     QStringList m_liveSGHosts;
     QStringList m_offlineSGHosts;
+    QStringList m_imageExtensions;
+
+    VideoScanSnapshot *m_snapshot; // only set for incremental scans
+    QStringList m_changedDirs;
 
     VideoMetadataListManager *m_dbmetadata;
     MythUIProgressDialog *m_dialog;
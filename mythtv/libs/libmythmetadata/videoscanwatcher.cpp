@@ -0,0 +1,562 @@
+#include <QFileSystemWatcher>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "mythdirs.h"
+#include "videoscan.h"
+#include "videoscanwatcher.h"
+
+#define LOC QString("VideoScanWatcher: ")
+
+static const quint32 kSnapshotMagic   = 0x4d565353; // "MVSS"
+static const quint32 kSnapshotVersion = 1;
+
+static QDataStream &operator<<(QDataStream &out,
+                               const VideoScanSnapshot::FileInfo &info)
+{
+    out << info.filename << info.host << info.size
+        << (quint32) info.mtime << info.hash;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in,
+                               VideoScanSnapshot::FileInfo &info)
+{
+    quint32 mtime;
+    in >> info.filename >> info.host >> info.size >> mtime >> info.hash;
+    info.mtime = mtime;
+    return in;
+}
+
+QDataStream &operator<<(QDataStream &out,
+                        const VideoScanSnapshot::DirInfo &info)
+{
+    out << info.base << info.host << (quint32) info.mtime
+        << info.subdirs << info.files;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, VideoScanSnapshot::DirInfo &info)
+{
+    quint32 mtime;
+    in >> info.base >> info.host >> mtime >> info.subdirs >> info.files;
+    info.mtime = mtime;
+    return in;
+}
+
+VideoScanSnapshot::VideoScanSnapshot(const QString &filename) :
+    m_filename(filename), m_now(0), m_listUnknown(false)
+{
+}
+
+/** \fn VideoScanSnapshot::Load(void)
+ *  \brief Reads the snapshot saved by a previous run, if any.
+ */
+bool VideoScanSnapshot::Load(void)
+{
+    m_dirs.clear();
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != kSnapshotMagic || version != kSnapshotVersion)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Ignoring incompatible snapshot '%1'").arg(m_filename));
+        return false;
+    }
+
+    in >> m_dirs;
+    if (in.status() != QDataStream::Ok)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Ignoring corrupt snapshot '%1'").arg(m_filename));
+        m_dirs.clear();
+        return false;
+    }
+
+    // Recreate the file paths, they are the map keys and not stored twice.
+    DirMap::iterator dit = m_dirs.begin();
+    for (; dit != m_dirs.end(); ++dit)
+    {
+        QMap<QString, FileInfo>::iterator fit = dit->files.begin();
+        for (; fit != dit->files.end(); ++fit)
+            fit->path = fit.key();
+    }
+
+    LOG(VB_GENERAL, LOG_INFO, LOC + QString("Loaded snapshot of %1 "
+        "directories from '%2'").arg(m_dirs.size()).arg(m_filename));
+
+    return true;
+}
+
+bool VideoScanSnapshot::Save(void) const
+{
+    QString tmpname = m_filename + ".tmp";
+    QFile file(tmpname);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to write snapshot '%1'").arg(tmpname));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kSnapshotMagic << kSnapshotVersion << m_dirs;
+    file.close();
+
+    QFile::remove(m_filename);
+    return QFile::rename(tmpname, m_filename);
+}
+
+/** \fn VideoScanSnapshot::SetRoots(const QList<Root>&)
+ *  \brief Sets the top level directories; directories in the snapshot that
+ *         are no longer under one of them are dropped on the next Update().
+ */
+void VideoScanSnapshot::SetRoots(const QList<Root> &roots)
+{
+    m_roots = roots;
+}
+
+void VideoScanSnapshot::SetFilter(
+    const FileAssociations::ext_ignore_list &ext_disposition,
+    bool list_unknown, const QStringList &image_extensions)
+{
+    m_extensions.clear();
+    FileAssociations::ext_ignore_list::const_iterator p =
+        ext_disposition.begin();
+    for (; p != ext_disposition.end(); ++p)
+        m_extensions[p->first.toLower()] = p->second;
+
+    m_listUnknown = list_unknown;
+
+    m_imageExtensions.clear();
+    QStringList::const_iterator it = image_extensions.begin();
+    for (; it != image_extensions.end(); ++it)
+        m_imageExtensions.insert(it->toLower());
+}
+
+bool VideoScanSnapshot::IsIgnored(const QString &suffix) const
+{
+    QString ext = suffix.toLower();
+    if (m_imageExtensions.contains(ext))
+        return true;
+
+    std::map<QString, bool>::const_iterator it = m_extensions.find(ext);
+    if (it != m_extensions.end())
+        return it->second;
+
+    return !m_listUnknown;
+}
+
+/** \fn VideoScanSnapshot::Update(const QStringList&,FileList&,FileList&)
+ *  \brief Brings the snapshot up to date for the given directories and
+ *         returns the files that appeared and disappeared.
+ *
+ *   The listed directories are always re-read. With an empty list every
+ *   root is checked instead, re-reading only those directories whose
+ *   modification time differs from the snapshot.
+ */
+void VideoScanSnapshot::Update(const QStringList &dirs,
+                               FileList &added, FileList &removed)
+{
+    m_now = QDateTime::currentDateTime().toTime_t();
+
+    if (!dirs.empty())
+    {
+        QStringList::const_iterator it = dirs.begin();
+        for (; it != dirs.end(); ++it)
+        {
+            DirMap::const_iterator dit = m_dirs.find(*it);
+            if (dit == m_dirs.end())
+                continue; // removed along with its parent
+            ScanDir(*it, dit->base, dit->host, true, added, removed);
+        }
+        return;
+    }
+
+    QSet<QString> root_paths;
+    QList<Root>::const_iterator rit = m_roots.begin();
+    for (; rit != m_roots.end(); ++rit)
+    {
+        root_paths.insert(rit->path);
+        ScanDir(rit->path, rit->base, rit->host, false, added, removed);
+    }
+
+    // Forget directories that are no longer configured
+    QStringList old_roots;
+    DirMap::const_iterator dit = m_dirs.begin();
+    for (; dit != m_dirs.end(); ++dit)
+    {
+        QString parent = QFileInfo(dit.key()).path();
+        if (!root_paths.contains(dit.key()) && !m_dirs.contains(parent))
+            old_roots.push_back(dit.key());
+    }
+    QStringList::const_iterator oit = old_roots.begin();
+    for (; oit != old_roots.end(); ++oit)
+    {
+        FileList gone;
+        RemoveDir(*oit, gone);
+    }
+}
+
+void VideoScanSnapshot::ScanDir(const QString &path, const QString &base,
+                                const QString &host, bool force,
+                                FileList &added, FileList &removed)
+{
+    QFileInfo dir_info(path);
+    if (!dir_info.isDir())
+    {
+        RemoveDir(path, removed);
+        return;
+    }
+
+    uint mtime = dir_info.lastModified().toTime_t();
+
+    DirMap::iterator it = m_dirs.find(path);
+    bool known = (it != m_dirs.end());
+    if (known && !force && it->mtime == mtime)
+    {
+        // Nothing was added to or removed from this directory itself.
+        QStringList subdirs = it->subdirs;
+        QStringList::const_iterator sit = subdirs.begin();
+        for (; sit != subdirs.end(); ++sit)
+            ScanDir(*sit, base, host, false, added, removed);
+        return;
+    }
+
+    DirInfo old;
+    if (known)
+        old = *it;
+    else
+        m_newDirs.push_back(path);
+
+    DirInfo cur;
+    cur.base  = base;
+    cur.host  = host;
+    cur.mtime = mtime;
+
+    bool pending = false;
+    QStringList new_subdirs;
+
+    QFileInfoList list = QDir(path).entryInfoList();
+    QFileInfoList::const_iterator p = list.begin();
+    for (; p != list.end(); ++p)
+    {
+        if (p->fileName() == "." ||
+            p->fileName() == ".." ||
+            p->fileName() == "Thumbs.db")
+        {
+            continue;
+        }
+
+        QString fq_path = p->absoluteFilePath();
+
+        if (p->isDir() &&
+            !QDir(fq_path + "/VIDEO_TS").exists() &&
+            !QDir(fq_path + "/BDMV").exists())
+        {
+            cur.subdirs.push_back(fq_path);
+            if (!m_dirs.contains(fq_path))
+                new_subdirs.push_back(fq_path);
+            continue;
+        }
+
+        if (!p->isDir() && IsIgnored(p->suffix()))
+            continue;
+
+        FileInfo info;
+        info.path     = fq_path;
+        info.host     = host;
+        info.size     = p->isDir() ? 0 : p->size();
+        info.mtime    = p->lastModified().toTime_t();
+        if (host.isEmpty())
+            info.filename = fq_path;
+        else
+        {
+            info.filename = fq_path.mid(base.length());
+            if (info.filename.startsWith("/"))
+                info.filename = info.filename.mid(1);
+        }
+
+        QMap<QString, FileInfo>::const_iterator oit = old.files.find(fq_path);
+        if (oit != old.files.end())
+        {
+            // Content changes are not tracked, keep the hash if unchanged
+            if (oit->size == info.size && oit->mtime == info.mtime)
+                info.hash = oit->hash;
+            cur.files[fq_path] = info;
+            old.files.remove(fq_path);
+        }
+        else if (m_now < info.mtime + kSettleTime)
+        {
+            // Probably still being written, look at it again later
+            pending = true;
+        }
+        else
+        {
+            cur.files[fq_path] = info;
+            added.push_back(info);
+        }
+    }
+
+    QMap<QString, FileInfo>::const_iterator fit = old.files.begin();
+    for (; fit != old.files.end(); ++fit)
+        removed.push_back(*fit);
+
+    if (pending)
+    {
+        // Keep the old mtime so the files still settling are not skipped
+        // by the mtime shortcut above, in this run or after a restart.
+        cur.mtime = old.mtime;
+        m_pendingDirs.push_back(path);
+    }
+
+    m_dirs[path] = cur;
+
+    QStringList::const_iterator sit = old.subdirs.begin();
+    for (; sit != old.subdirs.end(); ++sit)
+    {
+        if (!cur.subdirs.contains(*sit))
+            RemoveDir(*sit, removed);
+        else if (!force)
+            ScanDir(*sit, base, host, false, added, removed);
+    }
+
+    for (sit = new_subdirs.begin(); sit != new_subdirs.end(); ++sit)
+        ScanDir(*sit, base, host, true, added, removed);
+}
+
+void VideoScanSnapshot::RemoveDir(const QString &path, FileList &removed)
+{
+    DirMap::iterator it = m_dirs.find(path);
+    if (it == m_dirs.end())
+        return;
+
+    DirInfo old = *it;
+    m_dirs.erase(it);
+    m_goneDirs.push_back(path);
+
+    QMap<QString, FileInfo>::const_iterator fit = old.files.begin();
+    for (; fit != old.files.end(); ++fit)
+        removed.push_back(*fit);
+
+    QStringList::const_iterator sit = old.subdirs.begin();
+    for (; sit != old.subdirs.end(); ++sit)
+        RemoveDir(*sit, removed);
+}
+
+void VideoScanSnapshot::SetHash(const QString &path, const QString &hash)
+{
+    DirMap::iterator it = m_dirs.find(QFileInfo(path).path());
+    if (it == m_dirs.end())
+        return;
+
+    QMap<QString, FileInfo>::iterator fit = it->files.find(path);
+    if (fit != it->files.end())
+        fit->hash = hash;
+}
+
+QStringList VideoScanSnapshot::TakeNewDirs(void)
+{
+    QStringList tmp = m_newDirs;
+    m_newDirs.clear();
+    return tmp;
+}
+
+QStringList VideoScanSnapshot::TakeGoneDirs(void)
+{
+    QStringList tmp = m_goneDirs;
+    m_goneDirs.clear();
+    return tmp;
+}
+
+QStringList VideoScanSnapshot::TakePendingDirs(void)
+{
+    QStringList tmp = m_pendingDirs;
+    m_pendingDirs.clear();
+    return tmp;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+VideoScanWatcher::VideoScanWatcher(QObject *parent,
+                                   VideoScannerThread *fullscan) :
+    QObject(parent),
+    m_watcher(new QFileSystemWatcher(this)),
+    m_timer(new QTimer(this)),
+    m_scanThread(new VideoScannerThread(parent)),
+    m_fullScan(fullscan),
+    m_snapshot(new VideoScanSnapshot(GetConfDir() + "/videoscan.snapshot")),
+    m_started(false)
+{
+    m_timer->setSingleShot(true);
+
+    connect(m_watcher, SIGNAL(directoryChanged(const QString&)),
+            SLOT(DirectoryChanged(const QString&)));
+    connect(m_timer, SIGNAL(timeout()), SLOT(ScanChanged()));
+    connect(m_scanThread->qthread(), SIGNAL(finished()),
+            SLOT(ScanFinished()));
+}
+
+VideoScanWatcher::~VideoScanWatcher()
+{
+    Stop();
+
+    if (m_scanThread && m_scanThread->wait())
+        delete m_scanThread;
+
+    delete m_snapshot;
+}
+
+/** \fn VideoScanWatcher::Start(const QStringList&)
+ *  \brief Starts watching the video directories on this host.
+ *
+ *   The directories are checked against the snapshot from the previous
+ *   run first, so changes made while we weren't running are picked up.
+ *   \param dirs Video directories, as returned by GetVideoDirs()
+ */
+void VideoScanWatcher::Start(const QStringList &dirs)
+{
+    if (m_started)
+        return;
+
+    QString localhost = gCoreContext->GetHostName().toLower();
+    QList<VideoScanSnapshot::Root> roots;
+
+    QStringList::const_iterator it = dirs.begin();
+    for (; it != dirs.end(); ++it)
+    {
+        if (it->startsWith("myth://"))
+        {
+            QUrl sgurl = *it;
+            QString host = sgurl.host().toLower();
+            QString path = QDir::cleanPath(sgurl.path());
+            if (host == localhost)
+                roots.push_back(VideoScanSnapshot::Root(path, path, host));
+        }
+        else
+        {
+            QString path = QDir::cleanPath(*it);
+            roots.push_back(VideoScanSnapshot::Root(path, QString(), QString()));
+        }
+    }
+
+    if (roots.empty())
+    {
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            "No local video directories to watch");
+        return;
+    }
+
+    m_started = true;
+    if (m_snapshot->Load())
+        m_watcher->addPaths(m_snapshot->Directories());
+    m_snapshot->SetRoots(roots);
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("Watching %1 local video directories").arg(roots.size()));
+
+    // Check everything against the snapshot
+    m_scanThread->SetHosts(QStringList(localhost));
+    m_scanThread->SetIncremental(m_snapshot, QStringList());
+    m_scanThread->start();
+}
+
+void VideoScanWatcher::Stop(void)
+{
+    if (!m_started)
+        return;
+
+    m_started = false;
+    m_timer->stop();
+    m_changed.clear();
+
+    QStringList watched = m_watcher->directories();
+    if (!watched.empty())
+        m_watcher->removePaths(watched);
+}
+
+bool VideoScanWatcher::IsScanning(void) const
+{
+    return m_scanThread->isRunning();
+}
+
+void VideoScanWatcher::DirectoryChanged(const QString &path)
+{
+    if (!m_started)
+        return;
+
+    m_changed.insert(path);
+
+    // Collect changes for a while so a copy of a whole
+    // directory tree is handled in one pass.
+    if (!m_timer->isActive())
+        m_timer->start(kBatchDelay);
+}
+
+void VideoScanWatcher::ScanChanged(void)
+{
+    if (!m_started || m_changed.empty())
+        return;
+
+    // ScanFinished() starts us again when the current scan is done
+    if (m_scanThread->isRunning())
+        return;
+
+    // A full scan may add the same files, try again once it is done
+    if (m_fullScan && m_fullScan->isRunning())
+    {
+        m_timer->start(kBatchDelay);
+        return;
+    }
+
+    QStringList dirs = m_changed.toList();
+    m_changed.clear();
+
+    m_scanThread->SetIncremental(m_snapshot, dirs);
+    m_scanThread->start();
+}
+
+void VideoScanWatcher::ScanFinished(void)
+{
+    QStringList gone = m_snapshot->TakeGoneDirs();
+    QStringList added = m_snapshot->TakeNewDirs();
+    QStringList pending = m_snapshot->TakePendingDirs();
+
+    if (!m_started)
+        return;
+
+    QStringList watched = m_watcher->directories();
+    QStringList remove;
+    QStringList::const_iterator it = gone.begin();
+    for (; it != gone.end(); ++it)
+    {
+        if (watched.contains(*it))
+            remove.push_back(*it);
+    }
+    if (!remove.empty())
+        m_watcher->removePaths(remove);
+    if (!added.empty())
+        m_watcher->addPaths(added);
+
+    for (it = pending.begin(); it != pending.end(); ++it)
+        m_changed.insert(*it);
+
+    if (!m_changed.empty() && !m_timer->isActive())
+    {
+        m_timer->start(pending.empty() ? kBatchDelay :
+                       VideoScanSnapshot::kSettleTime * 1000);
+    }
+}
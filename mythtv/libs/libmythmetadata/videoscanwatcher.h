@@ -0,0 +1,151 @@
+#ifndef VIDEO_SCAN_WATCHER_H
+#define VIDEO_SCAN_WATCHER_H
+
+#include <map>
+
+#include <QObject> // for moc
+#include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QSet>
+
+#include "mythmetaexp.h"
+#include "dbaccess.h"
+
+class QFileSystemWatcher;
+class QDataStream;
+class QTimer;
+class VideoScannerThread;
+
+/** \class VideoScanSnapshot
+ *  \brief Persistent record of the video files found in local directories.
+ *
+ *   For every directory the snapshot keeps its modification time, its
+ *   subdirectories and the path, size, modification time and hash of each
+ *   video file in it. This lets an incremental scan list only directories
+ *   whose contents changed and reuse the hashes of files that were moved.
+ */
+class META_PUBLIC VideoScanSnapshot
+{
+  public:
+    class Root
+    {
+      public:
+        Root() {}
+        Root(const QString &p, const QString &b, const QString &h) :
+            path(p), base(b), host(h) {}
+        QString path; ///< local directory to scan
+        QString base; ///< storage group directory filenames are relative to
+        QString host; ///< storage group host, empty for plain directories
+    };
+
+    class FileInfo
+    {
+      public:
+        FileInfo() : size(0), mtime(0) {}
+        QString path;     ///< local path
+        QString filename; ///< filename as stored in videometadata
+        QString host;
+        qint64  size;
+        uint    mtime;
+        QString hash;
+    };
+    typedef QList<FileInfo> FileList;
+
+    VideoScanSnapshot(const QString &filename);
+
+    bool Load(void);
+    bool Save(void) const;
+
+    void SetRoots(const QList<Root> &roots);
+    void SetFilter(const FileAssociations::ext_ignore_list &ext_disposition,
+                   bool list_unknown, const QStringList &image_extensions);
+
+    void Update(const QStringList &dirs, FileList &added, FileList &removed);
+    void SetHash(const QString &path, const QString &hash);
+
+    QStringList Directories(void) const { return m_dirs.keys(); }
+
+    QStringList TakeNewDirs(void);
+    QStringList TakeGoneDirs(void);
+    QStringList TakePendingDirs(void);
+
+    /// Seconds a new file must go unmodified before it is added, so that
+    /// files which are still being copied in are not hashed early.
+    static const uint kSettleTime = 60;
+
+  private:
+    class DirInfo
+    {
+      public:
+        DirInfo() : mtime(0) {}
+        QString              base;
+        QString              host;
+        uint                 mtime;
+        QStringList          subdirs;
+        QMap<QString, FileInfo> files;
+    };
+    typedef QMap<QString, DirInfo> DirMap;
+
+    void ScanDir(const QString &path, const QString &base,
+                 const QString &host, bool force,
+                 FileList &added, FileList &removed);
+    void RemoveDir(const QString &path, FileList &removed);
+    bool IsIgnored(const QString &suffix) const;
+
+    QString      m_filename;
+    QList<Root>  m_roots;
+    DirMap       m_dirs;
+    uint         m_now;
+
+    std::map<QString, bool> m_extensions;
+    bool         m_listUnknown;
+    QSet<QString> m_imageExtensions;
+
+    QStringList  m_newDirs;
+    QStringList  m_goneDirs;
+    QStringList  m_pendingDirs;
+
+    friend QDataStream &operator<<(QDataStream&, const DirInfo&);
+    friend QDataStream &operator>>(QDataStream&, DirInfo&);
+};
+
+/** \class VideoScanWatcher
+ *  \brief Keeps the video database in sync with the local video directories
+ *         by watching them for changes and scanning only what changed.
+ *
+ *   Directories on other hosts are not watched; those are still picked up
+ *   by the normal full video scan.
+ */
+class META_PUBLIC VideoScanWatcher : public QObject
+{
+    Q_OBJECT
+
+  public:
+    VideoScanWatcher(QObject *parent, VideoScannerThread *fullscan = NULL);
+    ~VideoScanWatcher();
+
+    void Start(const QStringList &dirs);
+    void Stop(void);
+
+    bool IsScanning(void) const;
+
+  private slots:
+    void DirectoryChanged(const QString &path);
+    void ScanChanged(void);
+    void ScanFinished(void);
+
+  private:
+    QFileSystemWatcher *m_watcher;
+    QTimer             *m_timer;
+    VideoScannerThread *m_scanThread;
+    VideoScannerThread *m_fullScan; ///< not owned, scans are never run at once
+    VideoScanSnapshot  *m_snapshot;
+    QSet<QString>       m_changed;
+    bool                m_started;
+
+    /// Milliseconds to collect change notifications before scanning
+    static const int kBatchDelay = 5000;
+};
+
+#endif
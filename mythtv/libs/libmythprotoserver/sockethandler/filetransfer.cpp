@@ -113,11 +113,15 @@ int FileTransfer::RequestBlock(int size)
     while (readsLocked)
         readsUnlockedCond.wait(&lock, 100 /*ms*/);
 
-    requestBuffer.resize(max((size_t)max(size,0) + 128, requestBuffer.size()));
+    // Send large requests in pieces, so the client starts receiving
+    // data before the whole block has been read from disk.
+    const int kMaxChunk = 256 * 1024;
+    int chunk = min(max(size, 0), kMaxChunk);
+    requestBuffer.resize(max((size_t)chunk + 128, requestBuffer.size()));
     char *buf = &requestBuffer[0];
     while (tot < size && !rbuffer->GetStopReads() && readthreadlive)
     {
-        int request = size - tot;
+        int request = min(size - tot, kMaxChunk);
 
         ret = rbuffer->Read(buf, request);
         
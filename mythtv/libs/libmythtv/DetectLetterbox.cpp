@@ -5,6 +5,10 @@
 #include "mythplayer.h"
 #include "videoouttypes.h"
 #include "mythcorecontext.h"
+#include "lumascan.h"
+
+// Pixels averaged around each detection line, to ride out noise in the bars
+static const int kDetectionRun = 16;
 
 DetectLetterbox::DetectLetterbox(MythPlayer* const player)
 {
@@ -52,6 +56,8 @@ void DetectLetterbox::Detect(VideoFrame *frame)
     const int halfLimit = (int) ((height * (1 - m_player->GetVideoAspect() * 9 / 14) / 2) * detectLetterboxLimit / 100);
 
     const int xPos[] = {width / 4, width / 2, width * 3 / 4};    // Lines to scan for black letterbox edge
+    const int run = max(min(kDetectionRun, width / 4), 1);
+    const int xRun[] = {xPos[0] - run / 2, xPos[1] - run / 2, xPos[2] - run / 2};
     int topHits = 0, bottomHits = 0, minTop = 0, minBottom = 0, maxTop = 0, maxBottom = 0;
     int topHit[] = {0, 0, 0}, bottomHit[] = {0, 0, 0};
 
@@ -118,8 +124,10 @@ void DetectLetterbox::Detect(VideoFrame *frame)
          detectionLine < NUMBER_OF_DETECTION_LINES;
          detectionLine++)
     {
-        averageY += buf[offsets[0] + 5 * pitches[0]            + xPos[detectionLine]];
-        averageY += buf[offsets[0] + (height - 6) * pitches[0] + xPos[detectionLine]];
+        averageY += LumaScan::Sum(buf + offsets[0] + 5 * pitches[0] +
+                                  xRun[detectionLine], run) / run;
+        averageY += LumaScan::Sum(buf + offsets[0] + (height - 6) * pitches[0] +
+                                  xRun[detectionLine], run) / run;
     }
     averageY /= NUMBER_OF_DETECTION_LINES * 2;
     if (averageY > 64) // To bright to be a letterbox border
@@ -132,34 +140,41 @@ void DetectLetterbox::Detect(VideoFrame *frame)
              detectionLine < NUMBER_OF_DETECTION_LINES;
              detectionLine++)
         {
-            int Y = buf[offsets[0] +  y     * pitches[0] +  xPos[detectionLine]];
-            int U = buf[offsets[1] + (y>>1) * pitches[1] + (xPos[detectionLine]>>1)];
-            int V = buf[offsets[2] + (y>>1) * pitches[2] + (xPos[detectionLine]>>1)];
-            if ((!topHit[detectionLine]) &&
-                ( Y > averageY + THRESHOLD || Y < averageY - THRESHOLD ||
-                  U < 128 - 32 || U > 128 + 32 ||
-                  V < 128 - 32 || V > 128 + 32 ))
+            // lines which already hit the picture need not be read again
+            if (!topHit[detectionLine])
             {
-                topHit[detectionLine] = y;
-                topHits++;
-                if (!minTop)
-                    minTop = y;
-                maxTop = y;
+                int Y = LumaScan::Sum(buf + offsets[0] + y * pitches[0] +
+                                      xRun[detectionLine], run) / run;
+                int U = buf[offsets[1] + (y>>1) * pitches[1] + (xPos[detectionLine]>>1)];
+                int V = buf[offsets[2] + (y>>1) * pitches[2] + (xPos[detectionLine]>>1)];
+                if (Y > averageY + THRESHOLD || Y < averageY - THRESHOLD ||
+                    U < 128 - 32 || U > 128 + 32 ||
+                    V < 128 - 32 || V > 128 + 32)
+                {
+                    topHit[detectionLine] = y;
+                    topHits++;
+                    if (!minTop)
+                        minTop = y;
+                    maxTop = y;
+                }
             }
 
-            Y = buf[offsets[0] + (height-y-1     ) * pitches[0] + xPos[detectionLine]];
-            U = buf[offsets[1] + ((height-y-1) >> 1) * pitches[1] + (xPos[detectionLine]>>1)];
-            V = buf[offsets[2] + ((height-y-1) >> 1) * pitches[2] + (xPos[detectionLine]>>1)];
-            if ((!bottomHit[detectionLine]) &&
-                ( Y > averageY + THRESHOLD || Y < averageY - THRESHOLD ||
-                  U < 128 - 32 || U > 128 + 32 ||
-                  V < 128 - 32 || V > 128 + 32 ))
+            if (!bottomHit[detectionLine])
             {
-                bottomHit[detectionLine] = y;
-                bottomHits++;
-                if (!minBottom)
-                    minBottom = y;
-                maxBottom = y;
+                int Y = LumaScan::Sum(buf + offsets[0] + (height-y-1) * pitches[0] +
+                                      xRun[detectionLine], run) / run;
+                int U = buf[offsets[1] + ((height-y-1) >> 1) * pitches[1] + (xPos[detectionLine]>>1)];
+                int V = buf[offsets[2] + ((height-y-1) >> 1) * pitches[2] + (xPos[detectionLine]>>1)];
+                if (Y > averageY + THRESHOLD || Y < averageY - THRESHOLD ||
+                    U < 128 - 32 || U > 128 + 32 ||
+                    V < 128 - 32 || V > 128 + 32)
+                {
+                    bottomHit[detectionLine] = y;
+                    bottomHits++;
+                    if (!minBottom)
+                        minBottom = y;
+                    maxBottom = y;
+                }
             }
         }
 
@@ -506,6 +506,18 @@ bool AudioPlayer::GetBufferStatus(uint &fill, uint &total)
     return true;
 }
 
+bool AudioPlayer::GetLatencyStats(int64_t &buffered, uint &underruns,
+                                  float &dsptime)
+{
+    buffered = 0;
+    underruns = 0;
+    dsptime = 0.0f;
+    if (!m_audioOutput || m_no_audio_out)
+        return false;
+    m_audioOutput->GetLatencyStats(buffered, underruns, dsptime);
+    return true;
+}
+
 bool AudioPlayer::IsBufferAlmostFull(void)
 {
     uint ofill = 0, ototal = 0, othresh = 0;
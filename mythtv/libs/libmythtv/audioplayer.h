@@ -75,6 +75,7 @@ class MTV_PUBLIC AudioPlayer
     bool NeedDecodingBeforePassthrough(void);
     int64_t LengthLastData(void);
     bool GetBufferStatus(uint &fill, uint &total);
+    bool GetLatencyStats(int64_t &buffered, uint &underruns, float &dsptime);
     bool IsBufferAlmostFull(void);
 
   private:
@@ -26,6 +26,7 @@ using namespace std;
 #include "mythdbcon.h"
 #include "iso639.h"
 #include "mpegtables.h"
+#include "startcode.h"
 #include "atscdescriptors.h"
 #include "dvbdescriptors.h"
 #include "cc608decoder.h"
@@ -756,9 +757,34 @@ void AvFormatDecoder::SeekReset(long long newKey, uint skipFrames,
         }
     }
 
-    // Skip all the desired number of skipFrames
+    // Skip all the desired number of skipFrames. The frames decoded here
+    // are discarded, so avoid the work nothing else depends on: the IDCT
+    // of MPEG-2 B frames and the loop filter of H.264 non-reference frames.
+    AVCodecContext *skipctx = NULL;
+    AVDiscard old_skip_idct = AVDISCARD_DEFAULT;
+    AVDiscard old_skip_loop = AVDISCARD_DEFAULT;
+    int av_index = selectedTrack[kTrackTypeVideo].av_stream_index;
+    if (skipFrames > 1 && !private_dec &&
+        av_index >= 0 && av_index < (int)ic->nb_streams)
+    {
+        skipctx = ic->streams[av_index]->codec;
+        old_skip_idct = skipctx->skip_idct;
+        old_skip_loop = skipctx->skip_loop_filter;
+        skipctx->skip_idct = max(old_skip_idct, AVDISCARD_NONREF);
+        skipctx->skip_loop_filter = max(old_skip_loop, AVDISCARD_NONREF);
+    }
+
     for (;skipFrames > 0 && !ateof; skipFrames--)
     {
+        // Decode fully again once the frames still to come out of the
+        // decoder's reorder delay could be displayed
+        if (skipctx && skipFrames <= (uint)skipctx->has_b_frames + 1)
+        {
+            skipctx->skip_idct = old_skip_idct;
+            skipctx->skip_loop_filter = old_skip_loop;
+            skipctx = NULL;
+        }
+
         GetFrame(kDecodeVideo);
         if (decoded_video_frame)
         {
@@ -767,6 +793,12 @@ void AvFormatDecoder::SeekReset(long long newKey, uint skipFrames,
         }
     }
 
+    if (skipctx)
+    {
+        skipctx->skip_idct = old_skip_idct;
+        skipctx->skip_loop_filter = old_skip_loop;
+    }
+
     if (doflush)
     {
         firstvpts = 0;
@@ -2864,7 +2896,7 @@ void AvFormatDecoder::MpegPreProcessPkt(AVStream *stream, AVPacket *pkt)
 
     while (bufptr < bufend)
     {
-        bufptr = avpriv_mpv_find_start_code(bufptr, bufend, &start_code_state);
+        bufptr = find_start_code(bufptr, bufend, &start_code_state);
 
         float aspect_override = -1.0f;
         if (ringBuffer->IsDVD())
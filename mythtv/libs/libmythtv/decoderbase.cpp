@@ -1,4 +1,6 @@
 #include <unistd.h>
+#include <limits.h>
+#include <string.h>
 #include <math.h>
 
 #include <algorithm>
@@ -19,6 +21,10 @@ using namespace std;
 
 #define LOC QString("Dec: ")
 
+/// Upper bounds (ms) of the seek latency histogram buckets
+static const int kSeekStatBounds[] = { 50, 100, 250, 500, 1000, INT_MAX };
+static const uint kSeekStatLogInterval = 20;
+
 DecoderBase::DecoderBase(MythPlayer *parent, const ProgramInfo &pginfo)
     : m_parent(parent), m_playbackinfo(new ProgramInfo(pginfo)),
       m_audio(m_parent->GetAudio()), ringBuffer(NULL),
@@ -38,7 +44,8 @@ DecoderBase::DecoderBase(MythPlayer *parent, const ProgramInfo &pginfo)
       m_positionMapLock(QMutex::Recursive),
       dontSyncPositionMap(false),
 
-      seeksnap(UINT64_MAX), livetv(false), watchingrecording(false),
+      seeksnap(UINT64_MAX), seekCount(0),
+      livetv(false), watchingrecording(false),
 
       hasKeyFrameAdjustTable(false), lowbuffers(false),
       getrawframes(false), getrawvideo(false),
@@ -49,6 +56,7 @@ DecoderBase::DecoderBase(MythPlayer *parent, const ProgramInfo &pginfo)
       // language preference
       languagePreference(iso639_get_language_key_list())
 {
+    memset(seekLatency, 0, sizeof(seekLatency));
     ResetTracks();
     tracks[kTrackTypeAudio].push_back(StreamInfo(0, 0, 0, 0, 0));
     tracks[kTrackTypeCC608].push_back(StreamInfo(0, 0, 0, 1, 0));
@@ -800,6 +808,32 @@ void DecoderBase::DoFastForwardSeek(long long desiredFrame, bool &needflush)
     }
 }
 
+/** \fn DecoderBase::UpdateSeekStats(int)
+ *  \brief Records how long a seek took, and periodically logs the
+ *         distribution of seek latencies.
+ */
+void DecoderBase::UpdateSeekStats(int elapsed_ms)
+{
+    uint i = 0;
+    while (elapsed_ms > kSeekStatBounds[i])
+        i++;
+    seekLatency[i]++;
+    seekCount++;
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Seek took %1 ms").arg(elapsed_ms));
+
+    if (seekCount % kSeekStatLogInterval)
+        return;
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Seek latency after %1 seeks: <=50ms %2, <=100ms %3, "
+                "<=250ms %4, <=500ms %5, <=1s %6, >1s %7")
+            .arg(seekCount).arg(seekLatency[0]).arg(seekLatency[1])
+            .arg(seekLatency[2]).arg(seekLatency[3]).arg(seekLatency[4])
+            .arg(seekLatency[5]));
+}
+
 void DecoderBase::UpdateFramesPlayed(void)
 {
     m_parent->SetFramesPlayed(framesPlayed);
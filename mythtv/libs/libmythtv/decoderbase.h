@@ -179,6 +179,8 @@ class DecoderBase
 
     void SetTranscoding(bool value) { transcoding = value; }
 
+    void UpdateSeekStats(int elapsed_ms);
+
     bool IsErrored() const { return errored; }
 
     void SetWaitForChange(void);
@@ -272,6 +274,9 @@ class DecoderBase
     bool dontSyncPositionMap;
 
     uint64_t seeksnap;
+    /// Seek latency histogram, bucket upper bounds in kSeekStatBounds
+    uint seekLatency[6];
+    uint seekCount;
     bool livetv;
     bool watchingrecording;
 
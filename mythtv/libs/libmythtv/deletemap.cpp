@@ -547,23 +547,14 @@ bool DeleteMap::IsInDelete(uint64_t frame) const
     if (m_deleteMap.isEmpty())
         return false;
 
-    frm_dir_map_t::const_iterator it = m_deleteMap.find(frame);
+    // The first mark at or after frame decides, or failing that the last
+    // mark, so look it up instead of walking the map.
+    frm_dir_map_t::const_iterator it = m_deleteMap.lowerBound(frame);
     if (it != m_deleteMap.end())
-        return true;
-
-    int      lasttype  = MARK_UNSET;
-    uint64_t lastframe = UINT64_MAX;
-    for (it = m_deleteMap.begin() ; it != m_deleteMap.end(); ++it)
-    {
-        if (it.key() > frame)
-            return MARK_CUT_END == it.value();
-        lasttype  = it.value();
-        lastframe = it.key();
-    }
+        return (it.key() == frame) || (MARK_CUT_END == it.value());
 
-    if (lasttype == MARK_CUT_START && lastframe <= frame)
-        return true;
-    return false;
+    --it;
+    return MARK_CUT_START == it.value();
 }
 
 /**
@@ -588,30 +579,24 @@ uint64_t DeleteMap::GetNearestMark(
     uint64_t frame, uint64_t total, bool right,
     bool *hasMark) const
 {
-    uint64_t result;
     if (hasMark)
         *hasMark = true;
-    frm_dir_map_t::const_iterator it = m_deleteMap.begin();
+
     if (right)
     {
-        result = total;
-        for (; it != m_deleteMap.end(); ++it)
-            if (it.key() > frame)
-                return it.key();
+        frm_dir_map_t::const_iterator it = m_deleteMap.upperBound(frame);
+        if (it != m_deleteMap.end())
+            return it.key();
         if (hasMark)
             *hasMark = false;
+        return total;
     }
-    else
-    {
-        result = 0;
-        for (; it != m_deleteMap.end(); ++it)
-        {
-            if (it.key() >= frame)
-                return result;
-            result = it.key();
-        }
-    }
-    return result;
+
+    frm_dir_map_t::const_iterator it = m_deleteMap.lowerBound(frame);
+    if (it == m_deleteMap.begin())
+        return 0;
+    --it;
+    return it.key();
 }
 
 /**
@@ -476,6 +476,16 @@ int FileRingBuffer::safe_read(int fd, void *data, uint sz)
         if (tot < sz)
             usleep(60000);
     }
+
+    // Ask the kernel to start fetching the next block now, so that it
+    // is in the page cache by the time the read ahead thread wants it.
+    if (tot > 0 && !oldfile)
+    {
+        off64_t cur = lseek64(fd2, 0, SEEK_CUR);
+        if (cur >= 0)
+            posix_fadvise(fd2, cur, sz, POSIX_FADV_WILLNEED);
+    }
+
     return tot;
 }
 
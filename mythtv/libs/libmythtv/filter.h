@@ -23,6 +23,18 @@ typedef struct VideoFilter_ VideoFilter;
 
 typedef VideoFilter*(*init_filter)(int, int, int *, int *, char *, int);
 
+/*
+ * Filters whose output rows can be computed independently of each other may
+ * also provide a prepare and a slice function. The filter chain then calls
+ * prepare once per frame, which does any work that needs the whole frame
+ * and returns the most bands the frame may be split into (1 to process it
+ * in one piece, 0 to skip it). The chain then calls slice for each band,
+ * on several threads at once, instead of calling filter. Each band must
+ * only write its own rows, and must not read rows other bands write.
+ */
+typedef int (*prepare_filter)(VideoFilter *, VideoFrame *, int);
+typedef void (*slice_filter)(VideoFilter *, VideoFrame *, int, int, int);
+
 typedef struct FilterInfo_
 {
     init_filter filter_init;
@@ -30,6 +42,8 @@ typedef struct FilterInfo_
     char *descript;
     FmtConv *formats;
     char *libname;
+    prepare_filter filter_prepare;
+    slice_filter filter_slice;
 } FilterInfo;
 
 struct VideoFilter_
@@ -42,6 +56,10 @@ struct VideoFilter_
     VideoFrameType outpixfmt;
     char *opts;
     FilterInfo *info;
+
+    /* Set by the filter manager from the filter's FilterInfo */
+    prepare_filter prepare;
+    slice_filter slice;
 };
 
 #define FILT_NULL {NULL,NULL,NULL,NULL,NULL}
@@ -7,17 +7,58 @@
 #include "compat.h"
 #endif
 
+// C++ headers
+#include <algorithm>
+
 // Qt headers
 #include <QDir>
+#include <QRunnable>
 #include <QStringList>
 
 // MythTV headers
 #include "mythcontext.h"
 #include "filtermanager.h"
+#include "mthreadpool.h"
 #include "mythdirs.h"
 
 #define LOC QString("FilterManager: ")
 
+/// Runs one band of a sliced filter on a FilterChain pool thread
+class FilterSlice : public QRunnable
+{
+  public:
+    FilterSlice(FilterChain &chain) :
+        m_chain(chain), m_filter(NULL), m_frame(NULL),
+        m_field(0), m_slice(0), m_slices(1)
+    {
+        setAutoDelete(false);
+    }
+
+    void Set(VideoFilter *filter, VideoFrame *frame, int field,
+             int slice, int slices)
+    {
+        m_filter = filter;
+        m_frame  = frame;
+        m_field  = field;
+        m_slice  = slice;
+        m_slices = slices;
+    }
+
+    void run(void)
+    {
+        m_filter->slice(m_filter, m_frame, m_field, m_slice, m_slices);
+        m_chain.SliceDone();
+    }
+
+  private:
+    FilterChain &m_chain;
+    VideoFilter *m_filter;
+    VideoFrame  *m_frame;
+    int          m_field;
+    int          m_slice;
+    int          m_slices;
+};
+
 static const char *FmtToString(VideoFrameType ft)
 {
     switch(ft)
@@ -37,8 +78,24 @@ static const char *FmtToString(VideoFrameType ft)
     }
 }
 
+FilterChain::FilterChain(int threads) :
+    max_threads(max(threads, 1)), slice_pool(NULL), slices_left(0)
+{
+}
+
 FilterChain::~FilterChain()
 {
+    if (slice_pool)
+    {
+        slice_pool->waitForDone();
+        delete slice_pool;
+    }
+
+    vector<FilterSlice*>::iterator st = slice_tasks.begin();
+    for (; st != slice_tasks.end(); ++st)
+        delete *st;
+    slice_tasks.clear();
+
     vector<VideoFilter*>::iterator it = filters.begin();
     for (; it != filters.end(); ++it)
     {
@@ -58,9 +115,67 @@ void FilterChain::ProcessFrame(VideoFrame *frame, FrameScanType scan)
     if (!frame)
         return;
 
+    int field = (kScan_Intr2ndField == scan);
+
     vector<VideoFilter*>::iterator it = filters.begin();
     for (; it != filters.end(); ++it)
-        (*it)->filter(*it, frame, kScan_Intr2ndField == scan);
+    {
+        VideoFilter *filter = *it;
+
+        if (!filter->prepare || !filter->slice)
+        {
+            filter->filter(filter, frame, field);
+            continue;
+        }
+
+        int slices = min(filter->prepare(filter, frame, field), max_threads);
+        if (slices == 1)
+            filter->slice(filter, frame, field, 0, 1);
+        else if (slices > 1)
+            ProcessSlices(filter, frame, field, slices);
+    }
+}
+
+/** \fn FilterChain::ProcessSlices(VideoFilter*, VideoFrame*, int, int)
+ *  \brief Runs a sliced filter over horizontal bands of the frame.
+ *
+ *   The first band is processed on the calling thread, the others on the
+ *   chain's pool threads, which are kept around between frames.
+ */
+void FilterChain::ProcessSlices(VideoFilter *filter, VideoFrame *frame,
+                                int field, int slices)
+{
+    if (!slice_pool)
+    {
+        slice_pool = new MThreadPool("FilterChain");
+        slice_pool->setMaxThreadCount(max_threads - 1);
+    }
+
+    while ((int)slice_tasks.size() < slices - 1)
+        slice_tasks.push_back(new FilterSlice(*this));
+
+    slice_lock.lock();
+    slices_left = slices - 1;
+    slice_lock.unlock();
+
+    for (int i = 1; i < slices; i++)
+    {
+        slice_tasks[i - 1]->Set(filter, frame, field, i, slices);
+        slice_pool->start(slice_tasks[i - 1], "FilterSlice");
+    }
+
+    filter->slice(filter, frame, field, 0, slices);
+
+    QMutexLocker locker(&slice_lock);
+    while (slices_left > 0)
+        slice_wait.wait(&slice_lock);
+}
+
+void FilterChain::SliceDone(void)
+{
+    QMutexLocker locker(&slice_lock);
+    if (--slices_left <= 0)
+        slice_wait.wakeAll();
 }
 
 FilterManager::FilterManager()
@@ -160,6 +275,8 @@ bool FilterManager::LoadFilterLib(const QString &path)
 
         FilterInfo *newFilter = new FilterInfo;
         newFilter->filter_init = NULL;
+        newFilter->filter_prepare = NULL;
+        newFilter->filter_slice = NULL;
         newFilter->name     = strdup(filtInfo->name);
         newFilter->descript = strdup(filtInfo->descript);
 
@@ -202,7 +319,7 @@ FilterChain *FilterManager::LoadFilters(QString Filters,
         return NULL;
 
     vector<const FilterInfo*> FiltInfoChain;
-    FilterChain *FiltChain = new FilterChain;
+    FilterChain *FiltChain = new FilterChain(max_threads);
     vector<FmtConv*> FmtList;
     const FilterInfo *FI;
     const FilterInfo *FI2;
@@ -554,5 +671,7 @@ VideoFilter * FilterManager::LoadFilter(const FilterInfo *FiltInfo,
     else
         Filter->opts = NULL;
     Filter->info = const_cast<FilterInfo*>(FiltInfo);
+    Filter->prepare = filtInfo->filter_prepare;
+    Filter->slice = filtInfo->filter_slice;
     return Filter;
 }
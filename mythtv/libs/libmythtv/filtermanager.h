@@ -12,17 +12,25 @@ extern "C" {
 using namespace std;
 
 // Qt headers
+#include <QWaitCondition>
 #include <QString>
+#include <QMutex>
 
 typedef map<QString,void*>       library_map_t;
 typedef map<QString,FilterInfo*> filter_map_t;
 
 #include "videoouttypes.h"
+#include "mythtvexp.h"
 
-class FilterChain
+class MThreadPool;
+class FilterSlice;
+
+class MTV_PUBLIC FilterChain
 {
+    friend class FilterSlice;
+
   public:
-    FilterChain() { }
+    FilterChain(int max_threads = 1);
     virtual ~FilterChain();
 
     void ProcessFrame(VideoFrame *Frame, FrameScanType scan = kScan_Ignore);
@@ -30,10 +38,21 @@ class FilterChain
     void Append(VideoFilter *f) { filters.push_back(f); }
 
   private:
+    void ProcessSlices(VideoFilter *filter, VideoFrame *frame,
+                       int field, int slices);
+    void SliceDone(void);
+
     vector<VideoFilter*> filters;
+
+    int                  max_threads;
+    MThreadPool         *slice_pool;
+    vector<FilterSlice*> slice_tasks;
+    QMutex               slice_lock;
+    QWaitCondition       slice_wait;
+    int                  slices_left;
 };
 
-class FilterManager
+class MTV_PUBLIC FilterManager
 {
   public:
     FilterManager();
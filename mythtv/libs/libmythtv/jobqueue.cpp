@@ -6,12 +6,14 @@
 #include <cstdlib>
 #include <fcntl.h>
 #include <pthread.h>
+#include <algorithm>
 using namespace std;
 
 #include <QDateTime>
 #include <QFileInfo>
 #include <QRegExp>
 #include <QEvent>
+#include <QThread>
 #include <QCoreApplication>
 
 #include "mythconfig.h"
@@ -43,15 +45,41 @@ using namespace std;
 
 #define LOC     QString("JobQueue: ")
 
+namespace
+{
+    /// Orders queue entries so higher priority jobs are looked at first
+    struct job_priority_sort
+    {
+        job_priority_sort(const vector<int> &priority) : m_priority(priority) {}
+
+        bool operator()(int lhs, int rhs) const
+        {
+            return m_priority[lhs] > m_priority[rhs];
+        }
+
+      private:
+        const vector<int> &m_priority;
+    };
+}
+
 JobQueue::JobQueue(bool master) :
     m_hostname(gCoreContext->GetHostName()),
     jobsRunning(0),
     jobQueueCPU(0),
+    maxLoad(0),
+    maxStreams(0),
+    preemptForRecording(false),
+    coreCount(max(QThread::idealThreadCount(), 1)),
+    hostLoad(-1.0),
+    activeRecordings(0),
+    cpuInUse(0),
+    streamsInUse(0),
     m_pginfo(NULL),
     runningJobsLock(new QMutex(QMutex::Recursive)),
     isMaster(master),
     queueThread(new MThread("JobQueue", this)),
-    processQueue(false)
+    processQueue(false),
+    queueChanged(false)
 {
     jobQueueCPU = gCoreContext->GetNumSetting("JobQueueCPU", 0);
 
@@ -145,9 +173,24 @@ void JobQueue::customEvent(QEvent *e)
                 runningJobsLock->unlock();
             }
         }
+        else if ((message == "JOBQUEUE_CHANGED") ||
+                 message.startsWith("SYSTEM_EVENT REC_STARTED ") ||
+                 message.startsWith("SYSTEM_EVENT REC_FINISHED "))
+        {
+            // Look at the queue now instead of at the next poll, so new
+            // jobs start and recordings get their disk time back promptly
+            WakeQueue();
+        }
     }
 }
 
+void JobQueue::WakeQueue(void)
+{
+    QMutexLocker locker(&queueThreadCondLock);
+    queueChanged = true;
+    queueThreadCond.wakeAll();
+}
+
 void JobQueue::run(void)
 {
     queueThreadCondLock.lock();
@@ -210,6 +253,10 @@ void JobQueue::ProcessQueue(void)
         jobsRunning = 0;
         GetJobsInQueue(jobs);
 
+        UpdateHostLoad(jobs);
+        PreemptJobs(jobs);
+        ResumePreemptedJobs(jobs);
+
         if (jobs.size())
         {
             inTimeWindow = InJobRunWindow();
@@ -223,7 +270,21 @@ void JobQueue::ProcessQueue(void)
                      (status == JOB_PAUSED)) &&
                     (hostname == m_hostname))
                 jobsRunning++;
+
+                // Jobs are looked at by priority below, so every job must be
+                // known before checking for other jobs on the same recording
+                jobStatus[jobs[x].id] = status;
+            }
+
+            vector<int> order(jobs.size());
+            vector<int> priority(jobs.size());
+            for (uint x = 0; x < order.size(); x++)
+            {
+                order[x] = x;
+                priority[x] = GetJobResources(jobs[x].type).priority;
             }
+            stable_sort(order.begin(), order.end(),
+                        job_priority_sort(priority));
 
             message = QString("Currently Running %1 jobs.")
                               .arg(jobsRunning);
@@ -251,9 +312,9 @@ void JobQueue::ProcessQueue(void)
             }
 
 
-            for ( int x = 0;
-                 (x < jobs.size()) && (jobsRunning < maxJobs); x++)
+            for (uint i = 0; (i < order.size()) && (jobsRunning < maxJobs); i++)
             {
+                int x = order[i];
                 jobID = jobs[x].id;
                 cmds = jobs[x].cmds;
                 flags = jobs[x].flags;
@@ -289,7 +350,8 @@ void JobQueue::ProcessQueue(void)
                 {
                     int otherJobID = GetRunningJobID(jobs[x].chanid,
                                                      jobs[x].recstartts);
-                    if (otherJobID && (jobStatus.contains(otherJobID)) &&
+                    if (otherJobID && (otherJobID != jobID) &&
+                        (jobStatus.contains(otherJobID)) &&
                         (!(jobStatus[otherJobID] & JOB_DONE)))
                     {
                         message =
@@ -435,6 +497,16 @@ void JobQueue::ProcessQueue(void)
                 if (startedJobAlready)
                     continue;
 
+                // Leave the job for a host with spare capacity, or for later
+                if (inTimeWindow && !HaveCapacityFor(jobs[x], message))
+                {
+                    message = QString("Skipping '%1' job for %2, %3")
+                                      .arg(JobText(jobs[x].type)).arg(logInfo)
+                                      .arg(message);
+                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                    continue;
+                }
+
                 if ((inTimeWindow) &&
                     (hostname.isEmpty()) &&
                     (!ChangeJobHost(jobID, m_hostname)))
@@ -463,6 +535,10 @@ void JobQueue::ProcessQueue(void)
 
                 ProcessJob(jobs[x]);
 
+                JobResources res = GetJobResources(jobs[x].type);
+                cpuInUse += res.cpu;
+                streamsInUse += res.streams;
+
                 startedJobAlready = true;
             }
         }
@@ -491,12 +567,13 @@ void JobQueue::ProcessQueue(void)
 
 
         locker.relock();
-        if (processQueue)
+        if (processQueue && !queueChanged)
         {
             int st = (startedJobAlready) ? (5 * 1000) : (sleepTime * 1000);
             if (st > 0)
                 queueThreadCond.wait(locker.mutex(), st);
         }
+        queueChanged = false;
     }
 }
 
@@ -609,6 +686,8 @@ bool JobQueue::QueueJob(int jobType, uint chanid, const QDateTime &recstartts,
         return false;
     }
 
+    gCoreContext->SendMessage("JOBQUEUE_CHANGED");
+
     return true;
 }
 
@@ -759,7 +838,11 @@ bool JobQueue::StopJob(int jobID)
     MythEvent me(message);
     gCoreContext->dispatch(me);
 
-    return ChangeJobCmds(jobID, JOB_STOP);
+    if (!ChangeJobCmds(jobID, JOB_STOP))
+        return false;
+
+    gCoreContext->SendMessage("JOBQUEUE_CHANGED");
+    return true;
 }
 
 bool JobQueue::DeleteAllJobs(uint chanid, const QDateTime &recstartts)
@@ -1451,6 +1534,250 @@ bool JobQueue::AllowedToRun(JobQueueEntry job)
     return false;
 }
 
+/** \fn JobQueue::GetJobResources(int)
+ *  \brief Returns the resources a job of the given type is expected to use.
+ *
+ *   Metadata lookups are cheap and let the other jobs use the results, so
+ *   they go first. Commercial flagging reads the recording once and can be
+ *   paused, transcoding reads and writes it and keeps more cores busy.
+ */
+JobResources JobQueue::GetJobResources(int jobType)
+{
+    JobResources res = { 1, 1, 0, false };
+
+    switch (jobType)
+    {
+        case JOB_METADATA:
+            res.cpu = 0; res.streams = 0; res.priority = 3;
+            break;
+        case JOB_COMMFLAG:
+            res.cpu = 1; res.streams = 1; res.priority = 2;
+            res.pausable = true;
+            break;
+        case JOB_TRANSCODE:
+            res.cpu = 2; res.streams = 2; res.priority = 1;
+            break;
+        default:
+            break;
+    }
+
+    if (gCoreContext->GetNumSetting("AutoTranscodeBeforeAutoCommflag", 0))
+    {
+        if (jobType == JOB_TRANSCODE)
+            res.priority = 2;
+        else if (jobType == JOB_COMMFLAG)
+            res.priority = 1;
+    }
+
+    return res;
+}
+
+/// Returns the number of recordings, including Live TV, in progress on host
+int JobQueue::CountActiveRecordings(const QString &hostname)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    query.prepare("SELECT COUNT(*) FROM inuseprograms "
+                  "WHERE hostname = :HOSTNAME AND recusage = :RECUSAGE "
+                  "AND lastupdatetime > :ONEHOURAGO ;");
+    query.bindValue(":HOSTNAME", hostname);
+    query.bindValue(":RECUSAGE", kRecorderInUseID);
+    query.bindValue(":ONEHOURAGO", MythDate::current().addSecs(-61 * 60));
+
+    if (!query.exec())
+    {
+        MythDB::DBError("Error in JobQueue::CountActiveRecordings()", query);
+        return 0;
+    }
+
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+/** \fn JobQueue::UpdateHostLoad(const QMap<int, JobQueueEntry>&)
+ *  \brief Works out how much of this host's CPU and disk budget is in use.
+ *
+ *   Disk use is counted in streams: each recording in progress on this host
+ *   is one, and each running job adds what GetJobResources() says it uses.
+ */
+void JobQueue::UpdateHostLoad(const QMap<int, JobQueueEntry> &jobs)
+{
+    maxLoad = gCoreContext->GetNumSetting("JobQueueMaxLoad", 100);
+    maxStreams = gCoreContext->GetNumSetting("JobQueueMaxStreams", 6);
+    preemptForRecording =
+        gCoreContext->GetNumSetting("JobQueuePreemptForRecording", 1);
+
+    double loads[3];
+    if (getloadavg(loads, 3) == -1)
+        hostLoad = -1.0;
+    else
+        hostLoad = loads[0] * 100.0 / coreCount;
+
+    activeRecordings = CountActiveRecordings(m_hostname);
+
+    runningJobsLock->lock();
+    QSet<int>::iterator pit = preemptedJobs.begin();
+    while (pit != preemptedJobs.end())
+    {
+        if (runningJobs.contains(*pit))
+            ++pit;
+        else
+            pit = preemptedJobs.erase(pit);
+    }
+    runningJobsLock->unlock();
+
+    cpuInUse = 0;
+    streamsInUse = activeRecordings;
+
+    QMap<int, JobQueueEntry>::const_iterator it = jobs.begin();
+    for (; it != jobs.end(); ++it)
+    {
+        if ((*it).hostname != m_hostname)
+            continue;
+
+        // A job the user resumed is no longer ours to resume
+        if (((*it).status == JOB_RUNNING) && ((*it).cmds & JOB_RESUME))
+            preemptedJobs.remove((*it).id);
+
+        if (((*it).status != JOB_PENDING) &&
+            ((*it).status != JOB_STARTING) &&
+            ((*it).status != JOB_RUNNING))
+            continue;
+
+        if (preemptedJobs.contains((*it).id))
+            continue;
+
+        JobResources res = GetJobResources((*it).type);
+        cpuInUse += res.cpu;
+        streamsInUse += res.streams;
+    }
+
+    LOG(VB_JOBQUEUE, LOG_INFO, LOC +
+        QString("Load is %1% of %2 core(s), %3 recording(s) in progress, "
+                "%4 of %5 stream(s) and %6 core(s) used by jobs")
+            .arg((hostLoad < 0) ? QString("unknown") :
+                 QString::number((int) hostLoad))
+            .arg(coreCount).arg(activeRecordings)
+            .arg(streamsInUse).arg(maxStreams).arg(cpuInUse));
+}
+
+/** \fn JobQueue::HaveCapacityFor(const JobQueueEntry&, QString&) const
+ *  \brief Returns true if this host can start the job without going over
+ *         its CPU or disk budget, otherwise sets reason.
+ *
+ *   A job this host cannot start stays unclaimed, so a backend with spare
+ *   capacity can pick it up instead.
+ */
+bool JobQueue::HaveCapacityFor(const JobQueueEntry &job, QString &reason) const
+{
+    JobResources res = GetJobResources(job.type);
+
+    if (res.cpu && maxLoad && (hostLoad >= maxLoad))
+    {
+        reason = QString("system load of %1% is above the %2% limit.")
+                     .arg((int) hostLoad).arg(maxLoad);
+        return false;
+    }
+
+    if (res.cpu && cpuInUse && (cpuInUse + res.cpu > coreCount))
+    {
+        reason = QString("running jobs are already using all %1 core(s).")
+                     .arg(coreCount);
+        return false;
+    }
+
+    if (res.streams && maxStreams && (streamsInUse + res.streams > maxStreams))
+    {
+        reason = QString("%1 of %2 disk stream(s) are in use.")
+                     .arg(streamsInUse).arg(maxStreams);
+        return false;
+    }
+
+    return true;
+}
+
+/** \fn JobQueue::PreemptJobs(const QMap<int, JobQueueEntry>&)
+ *  \brief Pauses running jobs while recordings need their disk time.
+ *
+ *   Only jobs whose programs honour JOB_PAUSE are paused, lowest priority
+ *   and most recently queued first, until the host is back within its
+ *   stream budget. ResumePreemptedJobs() picks them up again later.
+ */
+void JobQueue::PreemptJobs(const QMap<int, JobQueueEntry> &jobs)
+{
+    if (!preemptForRecording || !maxStreams || !activeRecordings)
+        return;
+
+    while (streamsInUse > maxStreams)
+    {
+        int victim = -1;
+        JobResources victimRes = GetJobResources(JOB_NONE);
+
+        QMap<int, JobQueueEntry>::const_iterator it = jobs.begin();
+        for (; it != jobs.end(); ++it)
+        {
+            if (((*it).hostname != m_hostname) ||
+                ((*it).status != JOB_RUNNING) ||
+                preemptedJobs.contains((*it).id))
+                continue;
+
+            JobResources res = GetJobResources((*it).type);
+            if (!res.pausable || !res.streams)
+                continue;
+
+            if ((victim < 0) || (res.priority < victimRes.priority) ||
+                ((res.priority == victimRes.priority) &&
+                 ((*it).id > jobs[victim].id)))
+            {
+                victim = it.key();
+                victimRes = res;
+            }
+        }
+
+        if (victim < 0)
+            break;
+
+        LOG(VB_JOBQUEUE, LOG_INFO, LOC +
+            QString("Pausing '%1' job ID %2, %3 recording(s) in progress")
+                .arg(JobText(jobs[victim].type)).arg(jobs[victim].id)
+                .arg(activeRecordings));
+
+        PauseJob(jobs[victim].id);
+        preemptedJobs.insert(jobs[victim].id);
+        cpuInUse -= victimRes.cpu;
+        streamsInUse -= victimRes.streams;
+    }
+}
+
+/// Resumes the jobs PreemptJobs() paused once there is room for them again
+void JobQueue::ResumePreemptedJobs(const QMap<int, JobQueueEntry> &jobs)
+{
+    if (preemptedJobs.empty())
+        return;
+
+    QMap<int, JobQueueEntry>::const_iterator it = jobs.begin();
+    for (; it != jobs.end(); ++it)
+    {
+        if (!preemptedJobs.contains((*it).id) ||
+            ((*it).status != JOB_PAUSED))
+            continue;
+
+        JobResources res = GetJobResources((*it).type);
+        if (preemptForRecording && maxStreams &&
+            (streamsInUse + res.streams > maxStreams))
+            continue;
+
+        LOG(VB_JOBQUEUE, LOG_INFO, LOC +
+            QString("Resuming '%1' job ID %2, %3 recording(s) in progress")
+                .arg(JobText((*it).type)).arg((*it).id)
+                .arg(activeRecordings));
+
+        ResumeJob((*it).id);
+        preemptedJobs.remove((*it).id);
+        cpuInUse += res.cpu;
+        streamsInUse += res.streams;
+    }
+}
+
 enum JobCmds JobQueue::GetJobCmd(int jobID)
 {
     MSqlQuery query(MSqlQuery::InitCon());
@@ -1833,6 +2160,9 @@ void JobQueue::RemoveRunningJob(int id)
     }
 
     runningJobsLock->unlock();
+
+    // The job's resources are free again, see if another job can start
+    WakeQueue();
 }
 
 QString JobQueue::PrettyPrint(off_t bytes)
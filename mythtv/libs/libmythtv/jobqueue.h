@@ -10,6 +10,7 @@
 #include <QEvent>
 #include <QMutex>
 #include <QMap>
+#include <QSet>
 
 #include "mythtvexp.h"
 
@@ -111,6 +112,14 @@ typedef struct runningjobinfo {
     ProgramInfo *pginfo;
 } RunningJobInfo;
 
+/// Resources a job of a given type is expected to use while it runs
+typedef struct jobresources {
+    int  cpu;       ///< cores the job keeps busy
+    int  streams;   ///< recording sized streams the job reads or writes
+    int  priority;  ///< higher priority jobs start first and pause last
+    bool pausable;  ///< the job program honours JOB_PAUSE and JOB_RESUME
+} JobResources;
+
 class JobQueue;
 
 class MTV_PUBLIC JobQueue : public QObject, public QRunnable
@@ -185,6 +194,7 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     static void RemoveJobsFromMask(int jobs, int &mask) { mask &= ~jobs; }
 
     static QString JobText(int jobType);
+    static JobResources GetJobResources(int jobType);
     static QString StatusText(int status);
 
     static bool HasRunningOrPendingJobs(int startingWithinMins = 0);
@@ -213,6 +223,13 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
 
     static bool InJobRunWindow(int orStartingWithinMins = 0);
 
+    static int CountActiveRecordings(const QString &hostname);
+    void UpdateHostLoad(const QMap<int, JobQueueEntry> &jobs);
+    bool HaveCapacityFor(const JobQueueEntry &job, QString &reason) const;
+    void PreemptJobs(const QMap<int, JobQueueEntry> &jobs);
+    void ResumePreemptedJobs(const QMap<int, JobQueueEntry> &jobs);
+    void WakeQueue(void);
+
     void StartChildJob(void *(*start_routine)(void *), int jobID);
 
     QString GetJobDescription(int jobType);
@@ -238,6 +255,17 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     int jobsRunning;
     int jobQueueCPU;
 
+    // Host budget, refreshed on every pass through the queue
+    int    maxLoad;           ///< max load average per core, in percent
+    int    maxStreams;        ///< max recordings plus streaming jobs
+    bool   preemptForRecording;
+    int    coreCount;
+    double hostLoad;          ///< one minute load average per core, percent
+    int    activeRecordings;
+    int    cpuInUse;
+    int    streamsInUse;
+    QSet<int> preemptedJobs;  ///< jobs we paused, as opposed to the user
+
     ProgramInfo *m_pginfo;
 
     QMutex controlFlagsLock;
@@ -252,6 +280,7 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     QWaitCondition queueThreadCond;
     QMutex queueThreadCondLock;
     bool processQueue;
+    bool queueChanged;
 };
 
 #endif
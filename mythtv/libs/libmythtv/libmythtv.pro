@@ -200,6 +200,7 @@ HEADERS += mpeg/atsc_huffman.h
 HEADERS += mpeg/freesat_huffman.h   mpeg/freesat_tables.h
 HEADERS += mpeg/iso6937tables.h
 HEADERS += mpeg/tsstats.h           mpeg/streamlisteners.h
+HEADERS += mpeg/startcode.h
 HEADERS += mpeg/H264Parser.h
 
 SOURCES += mpeg/tspacket.cpp        mpeg/pespacket.cpp
@@ -421,8 +422,8 @@ using_frontend {
     }
 
     # Misc. frontend
-    HEADERS += DetectLetterbox.h
-    SOURCES += DetectLetterbox.cpp
+    HEADERS += DetectLetterbox.h        lumascan.h
+    SOURCES += DetectLetterbox.cpp      lumascan.cpp
 
     using_libdns_sd {
         !macx: LIBS += -ldns_sd
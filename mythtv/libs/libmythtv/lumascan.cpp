@@ -0,0 +1,122 @@
+#include <algorithm>
+using namespace std;
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+extern "C" {
+#include "libavutil/cpu.h"
+}
+
+#include "lumascan.h"
+
+#ifdef __SSE2__
+static bool sse2_check(void)
+{
+    static bool has_sse2 = av_get_cpu_flags() & AV_CPU_FLAG_SSE2;
+    return has_sse2;
+}
+
+static bool use_simd = sse2_check();
+
+static inline void range_sse2(const unsigned char *buf, int count,
+                              unsigned char &minval, unsigned char &maxval)
+{
+    __m128i lo = _mm_set1_epi8(minval);
+    __m128i hi = _mm_set1_epi8(maxval);
+
+    for (; count >= 16; count -= 16, buf += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)buf);
+        lo = _mm_min_epu8(lo, v);
+        hi = _mm_max_epu8(hi, v);
+    }
+
+    // fold the sixteen lanes into one
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 2));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 2));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 1));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 1));
+    minval = _mm_cvtsi128_si32(lo) & 0xff;
+    maxval = _mm_cvtsi128_si32(hi) & 0xff;
+
+    for (; count > 0; count--, buf++)
+    {
+        minval = min(minval, *buf);
+        maxval = max(maxval, *buf);
+    }
+}
+
+static inline uint sum_sse2(const unsigned char *buf, int count)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc  = zero;
+
+    for (; count >= 16; count -= 16, buf += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)buf);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+
+    uint sum = _mm_cvtsi128_si32(acc) +
+               _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+
+    for (; count > 0; count--, buf++)
+        sum += *buf;
+    return sum;
+}
+#endif
+
+/** \fn LumaScan::Range(const unsigned char*, int, int, unsigned char&, unsigned char&)
+ *  \brief Widens [minval, maxval] to take in count values, step bytes apart.
+ */
+void LumaScan::Range(const unsigned char *buf, int count, int step,
+                     unsigned char &minval, unsigned char &maxval)
+{
+#ifdef __SSE2__
+    if (use_simd && step == 1)
+    {
+        range_sse2(buf, count, minval, maxval);
+        return;
+    }
+#endif
+
+    unsigned char lo = minval, hi = maxval;
+    for (; count > 0; count--, buf += step)
+    {
+        lo = min(lo, *buf);
+        hi = max(hi, *buf);
+    }
+    minval = lo;
+    maxval = hi;
+}
+
+/** \fn LumaScan::Sum(const unsigned char*, int)
+ *  \brief Returns the sum of count consecutive values.
+ */
+uint LumaScan::Sum(const unsigned char *buf, int count)
+{
+#ifdef __SSE2__
+    if (use_simd)
+        return sum_sse2(buf, count);
+#endif
+
+    uint sum = 0;
+    for (; count > 0; count--, buf++)
+        sum += *buf;
+    return sum;
+}
+
+void LumaScan::SetSIMD(bool enable)
+{
+#ifdef __SSE2__
+    use_simd = enable && sse2_check();
+#else
+    (void)enable;
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef LUMASCAN_H_
+#define LUMASCAN_H_
+
+#include "mythtvexp.h"
+
+/** \class LumaScan
+ *  \brief Kernels used to find black bars, shared by DetectLetterbox and
+ *         the mythcommflag BorderDetector.
+ *
+ *   Both look at long runs of luma values and only need their range or
+ *   their average, so the runs of consecutive pixels are handled sixteen
+ *   at a time with SSE2 where the CPU has it.
+ */
+class MTV_PUBLIC LumaScan
+{
+  public:
+    static void Range(const unsigned char *buf, int count, int step,
+                      unsigned char &minval, unsigned char &maxval);
+    static uint Sum(const unsigned char *buf, int count);
+
+    /// Turns the SSE2 kernels off or back on, for benchmarking
+    static void SetSIMD(bool enable);
+};
+
+#endif
@@ -191,6 +191,7 @@ void MPEGStreamData::Reset(int desiredProgram)
     _pids_audio.clear();
 
     _pid_video_single_program = _pid_pmt_single_program = 0xffffffff;
+    PIDsChanged();
 
     _pat_version.clear();
     _pat_section_seen.clear();
@@ -643,6 +644,7 @@ bool MPEGStreamData::CreatePMTSingleProgram(const ProgramMapTable &pmt)
 
     if (videoPIDs.size() >= 1)
         _pid_video_single_program = videoPIDs[0];
+    PIDsChanged();
     for (uint i = 1; i < videoPIDs.size(); i++)
         AddWritingPID(videoPIDs[i]);
 
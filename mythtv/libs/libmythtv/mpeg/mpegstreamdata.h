@@ -12,6 +12,7 @@ using namespace std;
 
 // Qt
 #include <QMap>
+#include <QAtomicInt>
 
 #include "tspacket.h"
 #include "mythtimer.h"
@@ -123,26 +124,34 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     virtual void HandleTSTables(const TSPacket* tspacket);
     virtual bool ProcessTSPacket(const TSPacket& tspacket);
     virtual int  ProcessData(const unsigned char *buffer, int len);
+    static int ResyncStream(const unsigned char *buffer, int curr_pos, int len);
     inline  void HandleAdaptationFieldControl(const TSPacket* tspacket);
 
     // Listening
     virtual void AddListeningPID(
         uint pid, PIDPriority priority = kPIDPriorityNormal)
-        { _pids_listening[pid] = priority; }
+        { _pids_listening[pid] = priority; PIDsChanged(); }
     virtual void AddNotListeningPID(uint pid)
-        { _pids_notlistening[pid] = kPIDPriorityNormal; }
+        { _pids_notlistening[pid] = kPIDPriorityNormal; PIDsChanged(); }
     virtual void AddWritingPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_writing[pid] = priority; }
+        { _pids_writing[pid] = priority; PIDsChanged(); }
     virtual void AddAudioPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_audio[pid] = priority; }
+        { _pids_audio[pid] = priority; PIDsChanged(); }
 
-    virtual void RemoveListeningPID(uint pid) { _pids_listening.remove(pid);  }
+    virtual void RemoveListeningPID(uint pid)
+        { _pids_listening.remove(pid); PIDsChanged(); }
     virtual void RemoveNotListeningPID(uint pid)
-        { _pids_notlistening.remove(pid); }
-    virtual void RemoveWritingPID(uint pid) { _pids_writing.remove(pid);    }
-    virtual void RemoveAudioPID(uint pid)   { _pids_audio.remove(pid);      }
+        { _pids_notlistening.remove(pid); PIDsChanged(); }
+    virtual void RemoveWritingPID(uint pid)
+        { _pids_writing.remove(pid); PIDsChanged(); }
+    virtual void RemoveAudioPID(uint pid)
+        { _pids_audio.remove(pid); PIDsChanged(); }
+
+    /// \brief Returns a count that changes whenever the set of PIDs
+    ///        returned by GetPIDs() may have changed.
+    int PIDChangeCount(void) const { return _pid_change_count; }
 
     virtual bool IsListeningPID(uint pid) const;
     virtual bool IsNotListeningPID(uint pid) const;
@@ -340,8 +349,7 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     void ProcessCAT(const ConditionalAccessTable *cat);
     void ProcessPMT(const ProgramMapTable *pmt);
     void ProcessEncryptedPacket(const TSPacket&);
-
-    static int ResyncStream(const unsigned char *buffer, int curr_pos, int len);
+    void PIDsChanged(void) { _pid_change_count.ref(); }
 
     void UpdateTimeOffset(uint64_t si_utc_time);
 
@@ -372,6 +380,7 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     pid_map_t                 _pids_writing;
     pid_map_t                 _pids_audio;
     bool                      _listening_disabled;
+    QAtomicInt                _pid_change_count;
 
     // Encryption monitoring
     mutable QMutex            _encryption_lock;
@@ -50,6 +50,7 @@ void ScanStreamData::Reset(void)
     if (m_no_default_pid)
     {
         _pids_listening.clear();
+        PIDsChanged();
         return;
     }
 
@@ -0,0 +1,154 @@
+// -*- Mode: c++ -*-
+#ifndef _START_CODE_H_
+#define _START_CODE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+/** \fn find_start_code(const uint8_t*,const uint8_t*,uint32_t*)
+ *  \brief Finds the next MPEG start code (00 00 01 xx) in a buffer.
+ *
+ *   This is a drop in replacement for avpriv_mpv_find_start_code(),
+ *   the state carries the last four bytes seen so start codes split
+ *   across buffers (e.g. TS packets) are found. But instead of looking
+ *   at every third byte it lets memchr() skip ahead to the next 0x01,
+ *   which the C library does many bytes at a time.
+ *
+ *  \return pointer just past the start code's id byte, with the start
+ *          code in state, or end if none was found.
+ */
+static inline const uint8_t *find_start_code(
+    const uint8_t *p, const uint8_t *end, uint32_t *state)
+{
+    // Complete any start code begun in the previous buffer
+    for (int i = 0; i < 3; i++)
+    {
+        if (p >= end)
+            return end;
+        uint32_t tmp = *state << 8;
+        *state = tmp + *(p++);
+        if (tmp == 0x100)
+            return p;
+    }
+    if (p >= end)
+        return end;
+
+    // Look for the 0x01 of a 00 00 01 that is followed by an id byte,
+    // the two zeros may be the last bytes checked above.
+    const uint8_t *r = p - 1;
+    while (r < end - 1)
+    {
+        r = static_cast<const uint8_t*>(memchr(r, 0x01, end - 1 - r));
+        if (!r)
+            break;
+        if (!r[-1] && !r[-2])
+        {
+            p = r + 2;
+            *state = (0x100 | p[-1]);
+            return p;
+        }
+        r++;
+    }
+
+    *state = ((uint32_t)end[-4] << 24) | ((uint32_t)end[-3] << 16) |
+             ((uint32_t)end[-2] <<  8) |  (uint32_t)end[-1];
+    return end;
+}
+
+/// A start code found by find_ts_start_codes()
+struct TSStartCode
+{
+    uint32_t packet; ///< index of the TS packet in the block
+    uint32_t offset; ///< offset just past the id byte in that packet
+    uint8_t  id;     ///< the xx in 00 00 01 xx
+};
+
+/** \fn find_ts_start_codes(const uint8_t*,uint32_t,uint32_t,uint32_t*,std::vector<TSStartCode>&)
+ *  \brief Finds the MPEG start codes in the payloads of one PID in a
+ *         contiguous block of 188 byte TS packets.
+ *
+ *   This finds the same start codes as calling find_start_code() on
+ *   each packet's payload in turn, with the state reset to 0xffffffff
+ *   on a payload unit start as DTVRecorder does, and it skips the same
+ *   packets MPEGStreamData does (transport errors and scrambled ones).
+ *   But rather than one memchr() per packet it keeps a single memchr()
+ *   running ahead across the whole block, so a 0x01 free stretch of
+ *   packets costs one call. Only bytes within a matching payload count.
+ *
+ *  \return number of start codes appended to codes, the state is left
+ *          as it would be after the last packet so blocks can be chained.
+ */
+static inline uint32_t find_ts_start_codes(
+    const uint8_t *block, uint32_t count, uint32_t pid, uint32_t *state,
+    std::vector<TSStartCode> &codes)
+{
+    const uint32_t kPacketSize = 188;
+    const uint8_t *block_end = block + count * kPacketSize;
+    const uint8_t *next = block; // next 0x01 at or after this point
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t *pkt = block + i * kPacketSize;
+        if ((((pkt[1] << 8) | pkt[2]) & 0x1fff) != pid)
+            continue;
+        if ((pkt[1] & 0x80) || (pkt[3] & 0xc0)) // error or scrambled
+            continue;
+
+        uint32_t start = (pkt[3] & 0x20) ? 5 + pkt[4] : 4;
+        if (!(pkt[3] & 0x10) || start >= kPacketSize)
+            continue; // no payload
+
+        if (pkt[1] & 0x40) // payload unit start
+            *state = 0xffffffff;
+
+        const uint8_t *p   = pkt + start;
+        const uint8_t *end = pkt + kPacketSize;
+
+        // Complete any start code begun in the previous payload
+        for (int j = 0; j < 3 && p < end; j++)
+        {
+            uint32_t tmp = *state << 8;
+            *state = tmp + *(p++);
+            if (tmp == 0x100)
+            {
+                TSStartCode sc = { i, (uint32_t)(p - pkt), p[-1] };
+                codes.push_back(sc);
+                found++;
+            }
+        }
+        if (p >= end)
+            continue;
+
+        // Start codes with the 0x01 from p-1 up to the last byte but one
+        const uint8_t *r = p - 1;
+        while (true)
+        {
+            if (next < r)
+            {
+                next = static_cast<const uint8_t*>(
+                    memchr(r, 0x01, block_end - r));
+                if (!next)
+                    next = block_end;
+            }
+            if (next >= end - 1)
+                break;
+            if (!next[-1] && !next[-2])
+            {
+                TSStartCode sc = { i, (uint32_t)(next + 2 - pkt), next[1] };
+                codes.push_back(sc);
+                found++;
+            }
+            r = next + 1;
+        }
+
+        *state = ((uint32_t)end[-4] << 24) | ((uint32_t)end[-3] << 16) |
+                 ((uint32_t)end[-2] <<  8) |  (uint32_t)end[-1];
+    }
+
+    return found;
+}
+
+#endif // _START_CODE_H_
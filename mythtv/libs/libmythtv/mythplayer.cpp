@@ -2093,8 +2093,9 @@ bool MythPlayer::PrebufferEnoughFrames(int min_buffers)
         if (last_msg > 100)
         {
             LOG(VB_GENERAL, LOG_NOTICE, LOC +
-                QString("Waited %1ms for video buffers %2")
-                    .arg(waited_for).arg(videoOutput->GetFrameStatus()));
+                QString("Waited %1ms for video buffers %2 (%3)")
+                    .arg(waited_for).arg(videoOutput->GetFrameStatus())
+                    .arg(videoOutput->GetFrameWaitStatus()));
             buffering_last_msg = QTime::currentTime();
             if (audio.IsBufferAlmostFull())
             {
@@ -3129,10 +3130,13 @@ void MythPlayer::DecoderLoop(bool pause)
             if (decoder)
             {
                 decoderSeekLock.lock();
+                MythTimer seektimer;
+                seektimer.start();
                 if (((uint64_t)decoderSeek < framesPlayed) && decoder)
                     decoder->DoRewind(decoderSeek);
                 else if (decoder)
                     decoder->DoFastForward(decoderSeek);
+                decoder->UpdateSeekStats(seektimer.elapsed());
                 decoderSeek = -1;
                 decoderSeekLock.unlock();
             }
@@ -4576,6 +4580,7 @@ void MythPlayer::GetPlaybackData(InfoMap &infoMap)
     infoMap.insert("decoderrate", player_ctx->buffer->GetDecoderRate());
     infoMap.insert("storagerate", player_ctx->buffer->GetStorageRate());
     infoMap.insert("bufferavail", player_ctx->buffer->GetAvailableBuffer());
+    infoMap.insert("bufferstats", player_ctx->buffer->GetReadAheadStats());
     infoMap.insert("buffersize",
         QString::number(player_ctx->buffer->GetBufferSize() >> 20));
     infoMap.insert("avsync",
@@ -4588,6 +4593,15 @@ void MythPlayer::GetPlaybackData(InfoMap &infoMap)
     }
     if (decoder)
         infoMap["videodecoder"] = decoder->GetCodecDecoderName();
+    int64_t buffered;
+    uint underruns;
+    float dsptime;
+    if (audio.GetLatencyStats(buffered, underruns, dsptime))
+    {
+        infoMap["audiobuffered"]  = QString::number(buffered);
+        infoMap["audiounderruns"] = QString::number(underruns);
+        infoMap["audiodsp"]       = QString::number(dsptime, 'f', 2);
+    }
     if (output_jmeter)
     {
         infoMap["framerate"] = QString("%1%2%3")
@@ -26,6 +26,7 @@
 #include "mythlogging.h"
 #include "mpegtables.h"
 #include "ringbuffer.h"
+#include "startcode.h"
 #include "tv_rec.h"
 
 extern "C" {
@@ -431,7 +432,7 @@ bool DTVRecorder::FindMPEG2Keyframes(const TSPacket* tspacket)
 
     while (bufptr < bufend)
     {
-        bufptr = avpriv_mpv_find_start_code(bufptr, bufend, &_start_code);
+        bufptr = find_start_code(bufptr, bufend, &_start_code);
         bytes_left = bufend - bufptr;
         if ((_start_code & 0xffffff00) == 0x00000100)
         {
@@ -960,8 +961,7 @@ void DTVRecorder::FindPSKeyFrames(const uint8_t *buffer, uint len)
         bool hasKeyFrame  = false;
 
         const uint8_t *tmp = bufptr;
-        bufptr =
-            avpriv_mpv_find_start_code(bufptr + skip, bufend, &_start_code);
+        bufptr = find_start_code(bufptr + skip, bufend, &_start_code);
         _audio_bytes_remaining = 0;
         _other_bytes_remaining = 0;
         _video_bytes_remaining -= std::min(
@@ -254,19 +254,7 @@ void DVBStreamHandler::RunTS(void)
             continue;
         }
 
-        _listener_lock.lock();
-
-        if (_stream_data_list.empty())
-        {
-            _listener_lock.unlock();
-            continue;
-        }
-
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(buffer, len);
-
-        _listener_lock.unlock();
+        remainder = DemuxData(buffer, len);
 
         if (remainder > 0 && (len > remainder)) // leftover bytes
             memmove(buffer, &(buffer[len - remainder]), remainder);
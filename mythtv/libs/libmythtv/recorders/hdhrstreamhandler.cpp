@@ -158,19 +158,8 @@ void HDHRStreamHandler::run(void)
 
         // Assume data_length is a multiple of 188 (packet size)
 
-        _listener_lock.lock();
+        remainder = DemuxData(data_buffer, data_length);
 
-        if (_stream_data_list.empty())
-        {
-            _listener_lock.unlock();
-            continue;
-        }
-
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(data_buffer, data_length);
-
-        _listener_lock.unlock();
         if (remainder != 0)
         {
             LOG(VB_RECORD, LOG_INFO, LOC +
@@ -10,10 +10,12 @@
 # include <sys/socket.h>
 # include <netinet/in.h>
 # include <netinet/ip.h>
+# include <errno.h>
 #endif
 
 // Qt headers
 #include <QUdpSocket>
+#include <QVector>
 
 // MythTV headers
 #include "iptvstreamhandler.h"
@@ -285,44 +287,214 @@ void IPTVStreamHandler::run(void)
 IPTVStreamHandlerReadHelper::IPTVStreamHandlerReadHelper(
     IPTVStreamHandler *p, QUdpSocket *s, uint stream) :
     m_parent(p), m_socket(s), m_sender(p->m_sender[stream]),
-    m_stream(stream)
+    m_stream(stream), m_stats_received(0), m_stats_dropped(0)
 {
     connect(m_socket, SIGNAL(readyRead()),
             this,     SLOT(ReadPending()));
+    m_stats_timer.start();
 }
 
+#define LOC_RH QString("IPTVSH(%1): ").arg(m_parent->_device)
+
 void IPTVStreamHandlerReadHelper::ReadPending(void)
 {
     QHostAddress sender;
     quint16 senderPort;
     bool sender_null = m_sender.isNull();
+    uint received = 0;
+    uint dropped = 0;
+
+    // The first datagram always goes through QUdpSocket::readDatagram(),
+    // Qt disables the socket notifier while emitting readyRead() and
+    // only re-enables it from there. Whatever else is queued is then
+    // drained in batches by ReadBatch() where that is supported.
+    if (m_socket->hasPendingDatagrams())
+    {
+        UDPPacket packet(m_parent->m_buffer->GetEmptyPacket());
+        QByteArray &data = packet.GetDataReference();
+        data.resize(m_socket->pendingDatagramSize());
+        m_socket->readDatagram(data.data(), data.size(),
+                               &sender, &senderPort);
+        received++;
+        if (sender_null || sender == m_sender)
+        {
+            PushPacket(packet);
+        }
+        else
+        {
+            m_parent->m_buffer->FreePacket(packet);
+            dropped++;
+        }
+    }
 
-    if (0 == m_stream)
+    received += ReadBatch(sender_null);
+
+    while (m_socket->hasPendingDatagrams())
     {
-        while (m_socket->hasPendingDatagrams())
+        UDPPacket packet(m_parent->m_buffer->GetEmptyPacket());
+        QByteArray &data = packet.GetDataReference();
+        data.resize(m_socket->pendingDatagramSize());
+        m_socket->readDatagram(data.data(), data.size(),
+                               &sender, &senderPort);
+        received++;
+        if (sender_null || sender == m_sender)
         {
-            UDPPacket packet(m_parent->m_buffer->GetEmptyPacket());
-            QByteArray &data = packet.GetDataReference();
-            data.resize(m_socket->pendingDatagramSize());
-            m_socket->readDatagram(data.data(), data.size(),
-                                   &sender, &senderPort);
-            if (sender_null || sender == m_sender)
-                m_parent->m_buffer->PushDataPacket(packet);
+            PushPacket(packet);
+        }
+        else
+        {
+            m_parent->m_buffer->FreePacket(packet);
+            dropped++;
         }
     }
+
+    UpdateStats(received, dropped);
+}
+
+void IPTVStreamHandlerReadHelper::PushPacket(const UDPPacket &packet)
+{
+    if (0 == m_stream)
+        m_parent->m_buffer->PushDataPacket(packet);
     else
+        m_parent->m_buffer->PushFECPacket(packet, m_stream - 1);
+}
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+/** \fn IPTVStreamHandlerReadHelper::ReadBatch(bool)
+ *  \brief Drains the socket with recvmmsg(), kRecvBatch datagrams per
+ *         system call, straight into packets from the PacketBuffer pool.
+ *
+ *   The slots are kMaxDatagramSize bytes, which covers any datagram
+ *   that fits in an Ethernet frame; truncated datagrams are dropped.
+ *   Returns the number of datagrams read, dropped ones included.
+ */
+uint IPTVStreamHandlerReadHelper::ReadBatch(bool sender_null)
+{
+    static const uint kRecvBatch       = 32;
+    static const int  kMaxDatagramSize = 2048;
+
+    int fd = m_socket->socketDescriptor();
+    if (fd < 0)
+        return 0;
+
+    PacketBuffer *buffer = m_parent->m_buffer;
+    QVector<UDPPacket> packets;
+    packets.reserve(kRecvBatch);
+    struct mmsghdr          msgs[kRecvBatch];
+    struct iovec            iovs[kRecvBatch];
+    struct sockaddr_storage addrs[kRecvBatch];
+
+    for (uint i = 0; i < kRecvBatch; i++)
+    {
+        packets.push_back(buffer->GetEmptyPacket());
+        QByteArray &data = packets[i].GetDataReference();
+        data.resize(kMaxDatagramSize);
+        iovs[i].iov_base = data.data();
+        iovs[i].iov_len  = kMaxDatagramSize;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    }
+
+    uint received = 0;
+    uint dropped  = 0;
+    uint used     = 0;
+    while (true)
     {
-        while (m_socket->hasPendingDatagrams())
+        // Reset the slots consumed by the previous call
+        for (uint i = 0; i < used; i++)
+        {
+            packets[i] = buffer->GetEmptyPacket();
+            QByteArray &data = packets[i].GetDataReference();
+            data.resize(kMaxDatagramSize);
+            iovs[i].iov_base = data.data();
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_flags   = 0;
+        }
+
+        int ret = recvmmsg(fd, msgs, kRecvBatch, MSG_DONTWAIT, NULL);
+        if (ret <= 0)
+        {
+            if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                errno != EINTR)
+            {
+                LOG(VB_RECORD, LOG_ERR, LOC_RH + "recvmmsg failed " + ENO);
+            }
+            used = 0;
+            break;
+        }
+
+        used = ret;
+        received += used;
+        for (uint i = 0; i < used; i++)
         {
-            UDPPacket packet(m_parent->m_buffer->GetEmptyPacket());
-            QByteArray &data = packet.GetDataReference();
-            data.resize(m_socket->pendingDatagramSize());
-            m_socket->readDatagram(data.data(), data.size(),
-                                   &sender, &senderPort);
-            if (sender_null || sender == m_sender)
-                m_parent->m_buffer->PushFECPacket(packet, m_stream - 1);
+            bool ok = !(msgs[i].msg_hdr.msg_flags & MSG_TRUNC);
+            if (ok && !sender_null)
+            {
+                QHostAddress sender(reinterpret_cast<const sockaddr*>(
+                                        &addrs[i]));
+                ok = (sender == m_sender);
+            }
+
+            if (ok)
+            {
+                packets[i].GetDataReference().resize(msgs[i].msg_len);
+                PushPacket(packets[i]);
+            }
+            else
+            {
+                buffer->FreePacket(packets[i]);
+                dropped++;
+            }
         }
+
+        if (used < kRecvBatch)
+            break;
     }
+
+    // Return the unused slots to the pool
+    for (uint i = used; i < kRecvBatch; i++)
+        buffer->FreePacket(packets[i]);
+
+    m_stats_dropped += dropped;
+    return received;
+}
+#else
+uint IPTVStreamHandlerReadHelper::ReadBatch(bool)
+{
+    return 0;
+}
+#endif
+
+void IPTVStreamHandlerReadHelper::UpdateStats(uint received, uint dropped)
+{
+    m_stats_received += received;
+    m_stats_dropped  += dropped;
+
+    int elapsed = m_stats_timer.elapsed();
+    if (elapsed < 30000)
+        return;
+
+    QString msg =
+        QString("Stream %1: %2 packets/sec, %3 dropped in the last %4 secs")
+        .arg(m_stream)
+        .arg(m_stats_received * 1000 / elapsed)
+        .arg(m_stats_dropped).arg(elapsed / 1000);
+    if (0 == m_stream && m_parent->m_use_rtp_streaming)
+    {
+        const RTPPacketBuffer *buffer =
+            static_cast<const RTPPacketBuffer*>(m_parent->m_buffer);
+        msg += QString(", %1 recovered by FEC and %2 lost in total")
+            .arg(buffer->GetRecoveredPacketCount())
+            .arg(buffer->GetLostPacketCount());
+    }
+    LOG(VB_RECORD, LOG_INFO, LOC_RH + msg);
+
+    m_stats_received = 0;
+    m_stats_dropped  = 0;
+    m_stats_timer.restart();
 }
 
 #define LOC_WH QString("IPTVSH(%1): ").arg(m_parent->_device)
@@ -339,19 +511,9 @@ void IPTVStreamHandlerWriteHelper::timerEvent(QTimerEvent*)
         if (packet.GetDataReference().isEmpty())
             break;
 
-        int remainder = 0;
-        {
-            QMutexLocker locker(&m_parent->_listener_lock);
-            QByteArray &data = packet.GetDataReference();
-            IPTVStreamHandler::StreamDataList::const_iterator sit;
-            sit = m_parent->_stream_data_list.begin();
-            for (; sit != m_parent->_stream_data_list.end(); ++sit)
-            {
-                remainder = sit.key()->ProcessData(
-                    reinterpret_cast<const unsigned char*>(data.data()),
-                    data.size());
-            }
-        }
+        QByteArray &data = packet.GetDataReference();
+        int remainder = m_parent->DemuxData(
+            reinterpret_cast<const unsigned char*>(data.data()), data.size());
 
         if (remainder != 0)
         {
@@ -391,18 +553,8 @@ void IPTVStreamHandlerWriteHelper::timerEvent(QTimerEvent*)
             }
             m_last_sequence_number = seq_num;
 
-            m_parent->_listener_lock.lock();
-
-            int remainder = 0;
-            IPTVStreamHandler::StreamDataList::const_iterator sit;
-            sit = m_parent->_stream_data_list.begin();
-            for (; sit != m_parent->_stream_data_list.end(); ++sit)
-            {
-                remainder = sit.key()->ProcessData(
-                    ts_packet.GetTSData(), ts_packet.GetTSDataSize());
-            }
-
-            m_parent->_listener_lock.unlock();
+            int remainder = m_parent->DemuxData(
+                ts_packet.GetTSData(), ts_packet.GetTSDataSize());
 
             if (remainder != 0)
             {
@@ -3,6 +3,8 @@
 #ifndef _IPTVSTREAMHANDLER_H_
 #define _IPTVSTREAMHANDLER_H_
 
+#include <stdint.h>
+
 #include <vector>
 using namespace std;
 
@@ -14,6 +16,7 @@ using namespace std;
 
 #include "channelutil.h"
 #include "streamhandler.h"
+#include "mythtimer.h"
 
 #define IPTV_SOCKET_COUNT 3
 
@@ -22,6 +25,7 @@ class DTVSignalMonitor;
 class MPEGStreamData;
 class PacketBuffer;
 class IPTVChannel;
+class UDPPacket;
 
 class IPTVStreamHandlerReadHelper : QObject
 {
@@ -34,11 +38,21 @@ class IPTVStreamHandlerReadHelper : QObject
   public slots:
     void ReadPending(void);
 
+  private:
+    uint ReadBatch(bool sender_null);
+    void PushPacket(const UDPPacket &packet);
+    void UpdateStats(uint received, uint dropped);
+
   private:
     IPTVStreamHandler *m_parent;
     QUdpSocket *m_socket;
     QHostAddress m_sender;
     uint m_stream;
+
+    /// Packets received and dropped since the stats were last logged
+    uint64_t m_stats_received;
+    uint64_t m_stats_dropped;
+    MythTimer m_stats_timer;
 };
 
 class IPTVStreamHandlerWriteHelper : QObject
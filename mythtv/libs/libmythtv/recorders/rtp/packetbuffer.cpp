@@ -41,14 +41,11 @@ UDPPacket PacketBuffer::PopDataPacket(void)
 
 UDPPacket PacketBuffer::GetEmptyPacket(void)
 {
-    QMap<uint64_t, UDPPacket>::iterator it = m_empty_packets.begin();
-    if (it == m_empty_packets.end())
-    {
+    if (m_empty_packets.empty())
         return UDPPacket(m_next_empty_packet_key++);
-    }
 
-    UDPPacket packet(*it);
-    m_empty_packets.erase(it);
+    UDPPacket packet(m_empty_packets.back());
+    m_empty_packets.pop_back();
 
     return packet;
 }
@@ -57,5 +54,5 @@ void PacketBuffer::FreePacket(const UDPPacket &packet)
 {
     uint64_t top = packet.GetKey() & (0xFFFFFFFFULL<<32);
     if (top == (m_next_empty_packet_key & (0xFFFFFFFFULL<<32)))
-        m_empty_packets[packet.GetKey()] = packet;
+        m_empty_packets.push_back(packet);
 }
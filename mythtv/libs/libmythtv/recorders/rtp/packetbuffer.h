@@ -8,7 +8,6 @@
 #define _PACKET_BUFFER_H_
 
 #include <QList>
-#include <QMap>
 
 #include "udppacket.h"
 
@@ -47,7 +46,7 @@ class PacketBuffer
     uint64_t m_next_empty_packet_key;
     
     /// Packets ready for reuse
-    QMap<uint64_t, UDPPacket> m_empty_packets;
+    QList<UDPPacket> m_empty_packets;
 
     /// Ordered list of available packets
     QList<UDPPacket> m_available_packets;
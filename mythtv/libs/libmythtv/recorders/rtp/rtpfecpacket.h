@@ -3,12 +3,23 @@
  * Distributed as part of MythTV under GPL v2 and later.
  */
 
+#include <arpa/inet.h> // for ntohs()/ntohl()
+
 #include "udppacket.h"
 
 #ifndef _RTP_FEC_PACKET_H_
 #define _RTP_FEC_PACKET_H_
 
 /** \brief RTP FEC Packet
+ *
+ *  SMPTE 2022-1 FEC packet, this is an RTP packet whose payload starts
+ *  with the RFC 2733 FEC header and its SMPTE 2022-1 extension. The
+ *  packet protects the NA media packets with sequence numbers
+ *  SNBase + i * Offset, the recovery fields and the payload are the
+ *  XOR of the corresponding fields of those media packets.
+ *
+ *  In a column FEC stream Offset is the number of columns L and NA the
+ *  number of rows D, in a row FEC stream Offset is 1 and NA is L.
  */
 class RTPFECPacket : public UDPPacket
 {
@@ -17,7 +28,47 @@ class RTPFECPacket : public UDPPacket
     RTPFECPacket(uint64_t key) : UDPPacket(key) { }
     RTPFECPacket(void) : UDPPacket(0ULL) { }
 
-    // TODO
+    /// Size of the RTP header plus the FEC header
+    static const int kHeaderSize = 12 + 16;
+
+    bool IsValid(void) const
+    {
+        return ((m_data.size() >= kHeaderSize) &&
+                (2 == ((GetByte(0) >> 6) & 0x3)) &&
+                GetOffset() && GetNA());
+    }
+
+    /// Recovery field for the RTP padding, extension and CSRC count
+    uint GetFlagsRecovery(void) const { return GetByte(0) & 0x3f; }
+    /// Recovery field for the RTP marker bit
+    uint GetMarkerRecovery(void) const { return GetByte(1) & 0x80; }
+
+    uint GetSNBase(void) const { return Get16(12); }
+    uint GetLengthRecovery(void) const { return Get16(14); }
+    uint GetPayloadTypeRecovery(void) const { return GetByte(16) & 0x7f; }
+    uint GetTimeStampRecovery(void) const { return Get32(20); }
+    /// True for the row FEC stream, false for the column FEC stream
+    bool IsRowFEC(void) const { return (GetByte(24) >> 6) & 0x1; }
+    uint GetOffset(void) const { return GetByte(25); }
+    uint GetNA(void) const { return GetByte(26); }
+
+    const unsigned char *GetFECPayload(void) const
+    {
+        return reinterpret_cast<const unsigned char*>(m_data.data()) +
+            kHeaderSize;
+    }
+    uint GetFECPayloadSize(void) const { return m_data.size() - kHeaderSize; }
+
+  private:
+    uint GetByte(int i) const { return (unsigned char) m_data[i]; }
+    uint Get16(int i) const
+    {
+        return ntohs(*reinterpret_cast<const uint16_t*>(m_data.data()+i));
+    }
+    uint Get32(int i) const
+    {
+        return ntohl(*reinterpret_cast<const uint32_t*>(m_data.data()+i));
+    }
 };
 
 #endif // _RTP_FEC_PACKET_H_
@@ -4,9 +4,13 @@
  * Distributed as part of MythTV under GPL v2 and later.
  */
 
+// C++ headers
 #include <algorithm>
 using namespace std;
 
+// C headers
+#include <string.h>
+
 #include "rtppacketbuffer.h"
 #include "rtpdatapacket.h"
 #include "rtpfecpacket.h"
@@ -41,33 +45,293 @@ void RTPPacketBuffer::PushDataPacket(const UDPPacket &udp_packet)
         .arg(m_large_sequence_number_seen_recently));
 */
 
-    m_unordered_packets[key] = packet;
+    if (m_ring_started && key + kRingSize < m_ring_head)
+    {
+        // The sequence went backwards by more than the window,
+        // the sender restarted so flush and start over.
+        while (m_ring_count)
+            ReleaseHead();
+        m_ring_started = false;
+    }
+
+    if (!m_ring_started)
+    {
+        m_ring_head = key;
+        m_ring_started = true;
+    }
+
+    if (key < m_ring_head)
+    {
+        // Arrived after its slot was released, too late to reorder
+        FreePacket(packet);
+        return;
+    }
+
+    if (key >= m_ring_head + kRingSize)
+    {
+        // Make room in the window for packets far ahead of the head,
+        // once the window is empty we can jump straight there.
+        uint64_t new_head = key - kRingSize + 1;
+        while (m_ring_count && m_ring_head < new_head)
+            ReleaseHead();
+        m_ring_head = max(m_ring_head, new_head);
+    }
+
+    if (m_ring_used[key & (kRingSize - 1)])
+    {
+        // Duplicate packet
+        FreePacket(packet);
+        return;
+    }
+
+    InsertPacket(packet, key);
 
     // TODO pushing packets onto the ordered list should be based on
     // the bitrate and the M+N of the FEC.. but for now...
-    const int kHighWaterMark = 500;
-    const int kLowWaterMark  = 100;
-    if (m_unordered_packets.size() > kHighWaterMark)
+    const uint kHighWaterMark = 500;
+    const uint kLowWaterMark  = 100;
+    if (m_ring_count > kHighWaterMark)
+    {
+        while (m_ring_count > kLowWaterMark)
+            ReleaseHead();
+    }
+}
+
+void RTPPacketBuffer::InsertPacket(const RTPDataPacket &packet, uint64_t key)
+{
+    uint slot = key & (kRingSize - 1);
+    m_ring[slot] = packet;
+    m_ring_used[slot] = true;
+    m_ring_keys[slot] = key;
+    m_ring_count++;
+}
+
+/// Moves the packet at the head of the reorder window, if we received
+/// it or can rebuild it, to the list of available packets and advances
+/// the window by one.
+void RTPPacketBuffer::ReleaseHead(void)
+{
+    uint slot = m_ring_head & (kRingSize - 1);
+    if (!m_ring_used[slot] && m_fec_cover[slot])
+        ProcessFEC();
+
+    if (m_ring_used[slot])
     {
-        while (m_unordered_packets.size() > kLowWaterMark)
-        {
-            QMap<uint64_t, RTPDataPacket>::iterator it =
-                m_unordered_packets.begin();
 /*
-            LOG(VB_RECORD, LOG_DEBUG, QString("Popping %1 as %2")
-                .arg((*it).GetSequenceNumber()).arg(it.key()));
+        LOG(VB_RECORD, LOG_DEBUG, QString("Popping %1 as %2")
+            .arg(m_ring[slot].GetSequenceNumber()).arg(m_ring_head));
 */
-            m_available_packets.push_back(*it);
-            m_unordered_packets.erase(it);
+        m_available_packets.push_back(m_ring[slot]);
+        m_ring_used[slot] = false;
+        m_ring_count--;
+        if (!m_fec_seen)
+        {
+            m_ring[slot] = RTPDataPacket();
+            m_ring_keys[slot] = ~0ULL;
         }
     }
+    else
+    {
+        m_lost_packets++;
+    }
+    m_ring_head++;
+}
+
+bool RTPPacketBuffer::HasPacket(uint64_t key) const
+{
+    return m_ring_keys[key & (kRingSize - 1)] == key;
+}
+
+/// Returns the extended sequence number closest to the head of the
+/// window with the given RTP sequence number.
+uint64_t RTPPacketBuffer::ExtendSequenceNumber(uint seq) const
+{
+    uint64_t key = (m_ring_head & ~0xFFFFULL) | (seq & 0xFFFF);
+    if (key + (1ULL<<15) < m_ring_head)
+        key += 1ULL<<16;
+    else if ((key > m_ring_head + (1ULL<<15)) && (key >= (1ULL<<16)))
+        key -= 1ULL<<16;
+    return key;
+}
+
+/// Counts the FEC packet as protecting the slots of its packets.
+void RTPPacketBuffer::AddFECCover(const FECEntry &fec, int delta)
+{
+    uint offset = fec.packet.GetOffset();
+    uint na     = fec.packet.GetNA();
+    for (uint i = 0; i < na; i++)
+        m_fec_cover[(fec.base + i * offset) & (kRingSize - 1)] += delta;
+}
+
+QList<RTPPacketBuffer::FECEntry>::iterator RTPPacketBuffer::EraseFEC(
+    QList<FECEntry>::iterator it)
+{
+    AddFECCover(*it, -1);
+    FreePacket((*it).packet);
+    return m_fec_packets.erase(it);
 }
 
 void RTPPacketBuffer::PushFECPacket(
     const UDPPacket &packet, uint fec_stream_num)
 {
-    (void) fec_stream_num;
-    // TODO IMPLEMENT
-    // for now just free the packet for immediate reuse
-    FreePacket(packet);
+    // SMPTE 2022-1 sends the column FEC on the first FEC stream and the
+    // row FEC on the second, anything else is not what the header says.
+    RTPFECPacket fec_packet(packet);
+    if (!fec_packet.IsValid() || !m_ring_started ||
+        fec_packet.IsRowFEC() != (1 == fec_stream_num) ||
+        (fec_packet.IsRowFEC() && 1 != fec_packet.GetOffset()))
+    {
+        FreePacket(packet);
+        return;
+    }
+
+    m_fec_seen = true;
+
+    // Forget FEC packets whose protected packets have all been released
+    const uint kMaxFECPackets = 256;
+    QList<FECEntry>::iterator it = m_fec_packets.begin();
+    while (it != m_fec_packets.end())
+    {
+        const RTPFECPacket &p = (*it).packet;
+        if ((*it).base + (p.GetNA() - 1) * p.GetOffset() < m_ring_head)
+            it = EraseFEC(it);
+        else
+            ++it;
+    }
+    while ((uint)m_fec_packets.size() >= kMaxFECPackets)
+        EraseFEC(m_fec_packets.begin());
+
+    uint64_t base = ExtendSequenceNumber(fec_packet.GetSNBase());
+    if (base + (fec_packet.GetNA() - 1) * fec_packet.GetOffset() <
+        m_ring_head)
+    {
+        // Too late to be of any use
+        FreePacket(packet);
+        return;
+    }
+
+    // Recovery is deferred until the missing packet reaches the head of
+    // the window, so a FEC packet adds no latency when nothing is lost.
+    m_fec_packets.push_back(FECEntry(fec_packet, base));
+    AddFECCover(m_fec_packets.back(), 1);
+}
+
+/// Rebuilds what missing packets we can, repeating while that makes
+/// more FEC packets usable (i.e. a row recovery completing a column).
+void RTPPacketBuffer::ProcessFEC(void)
+{
+    bool recovered = true;
+    while (recovered)
+    {
+        recovered = false;
+        QList<FECEntry>::iterator it = m_fec_packets.begin();
+        while (it != m_fec_packets.end())
+        {
+            uint64_t before = m_recovered_packets;
+            if (RecoverPacket(*it))
+            {
+                recovered |= (before != m_recovered_packets);
+                it = EraseFEC(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+/** \fn RTPPacketBuffer::RecoverPacket(const FECEntry&)
+ *  \brief Rebuilds the packet protected by a FEC packet when it is
+ *         the only one of them missing.
+ *
+ *   The RTP header fields and the payload of the missing packet are
+ *   the XOR of the FEC recovery fields with the same fields of the
+ *   other protected packets, the SSRC is copied from those packets.
+ *
+ *  \return true if the FEC packet is no longer needed.
+ */
+bool RTPPacketBuffer::RecoverPacket(const FECEntry &fec)
+{
+    const RTPFECPacket &fec_packet = fec.packet;
+    uint offset = fec_packet.GetOffset();
+    uint na     = fec_packet.GetNA();
+
+    uint64_t missing_key = 0;
+    uint missing = 0;
+    for (uint i = 0; i < na; i++)
+    {
+        uint64_t key = fec.base + i * offset;
+        if (HasPacket(key))
+            continue;
+        if (key < m_ring_head)
+            return true; // already released as lost
+        if (missing++)
+            return false; // more than one missing, maybe later
+        missing_key = key;
+    }
+
+    if (!missing)
+        return true;
+
+    if (missing_key >= m_ring_head + kRingSize)
+        return false;
+
+    uint flags  = fec_packet.GetFlagsRecovery();
+    uint marker = fec_packet.GetMarkerRecovery();
+    uint pt     = fec_packet.GetPayloadTypeRecovery();
+    uint ts     = fec_packet.GetTimeStampRecovery();
+    uint length = fec_packet.GetLengthRecovery();
+    uint ssrc   = 0;
+    QByteArray payload(
+        reinterpret_cast<const char*>(fec_packet.GetFECPayload()),
+        fec_packet.GetFECPayloadSize());
+
+    for (uint i = 0; i < na; i++)
+    {
+        uint64_t key = fec.base + i * offset;
+        if (key == missing_key)
+            continue;
+
+        const RTPDataPacket &p = m_ring.at(key & (kRingSize - 1));
+        const QByteArray data = p.GetData();
+        int size = data.size() - 12;
+        if (size < 0)
+            return true;
+
+        const unsigned char *buf =
+            reinterpret_cast<const unsigned char*>(data.constData());
+        flags  ^= buf[0] & 0x3f;
+        marker ^= buf[1] & 0x80;
+        pt     ^= buf[1] & 0x7f;
+        ts     ^= p.GetTimeStamp();
+        length ^= size;
+        ssrc    = p.GetSynchronizationSource();
+
+        if (payload.size() < size)
+            payload.append(QByteArray(size - payload.size(), '\0'));
+        char *out = payload.data();
+        for (int j = 0; j < size; j++)
+            out[j] ^= buf[12 + j];
+    }
+
+    length &= 0xffff;
+    if ((int)length > payload.size())
+        return true; // inconsistent FEC data
+
+    RTPDataPacket packet(GetEmptyPacket());
+    QByteArray &data = packet.GetDataReference();
+    data.resize(12 + length);
+    unsigned char *buf = reinterpret_cast<unsigned char*>(data.data());
+    buf[0] = 0x80 | flags;
+    buf[1] = marker | pt;
+    *reinterpret_cast<uint16_t*>(buf + 2) = htons(missing_key & 0xffff);
+    *reinterpret_cast<uint32_t*>(buf + 4) = htonl(ts);
+    *reinterpret_cast<uint32_t*>(buf + 8) = htonl(ssrc);
+    memcpy(buf + 12, payload.constData(), length);
+
+    InsertPacket(packet, missing_key);
+    m_recovered_packets++;
+
+    return true;
 }
@@ -7,9 +7,11 @@
 #ifndef _RTP_PACKET_BUFFER_H_
 #define _RTP_PACKET_BUFFER_H_
 
-#include <QMap>
+#include <QVector>
+#include <QList>
 
 #include "rtpdatapacket.h"
+#include "rtpfecpacket.h"
 #include "packetbuffer.h"
 
 class RTPPacketBuffer : public PacketBuffer
@@ -18,7 +20,11 @@ class RTPPacketBuffer : public PacketBuffer
     RTPPacketBuffer(unsigned int bitrate) :
         PacketBuffer(bitrate),
         m_large_sequence_number_seen_recently(0),
-        m_current_sequence(0ULL)
+        m_current_sequence(0ULL),
+        m_ring(kRingSize), m_ring_used(kRingSize, false),
+        m_ring_head(0ULL), m_ring_keys(kRingSize, ~0ULL),
+        m_ring_count(0), m_ring_started(false),
+        m_fec_cover(kRingSize, 0), m_fec_seen(false), m_recovered_packets(0ULL), m_lost_packets(0ULL)
     {
     }
 
@@ -28,12 +34,59 @@ class RTPPacketBuffer : public PacketBuffer
     /// Adds SMPTE 2022 Forward Error Correction Stream packet
     virtual void PushFECPacket(const UDPPacket&, unsigned int fec_stream_num);
 
+    /// Number of data packets rebuilt from FEC packets
+    uint64_t GetRecoveredPacketCount(void) const { return m_recovered_packets; }
+    /// Number of data packets that were missing when released
+    uint64_t GetLostPacketCount(void) const { return m_lost_packets; }
+
   private:
+    class FECEntry
+    {
+      public:
+        FECEntry(const RTPFECPacket &p, uint64_t b) : packet(p), base(b) { }
+        RTPFECPacket packet;
+        /// Extended sequence number of the first protected packet
+        uint64_t base;
+    };
+
+    void InsertPacket(const RTPDataPacket &packet, uint64_t key);
+    void ReleaseHead(void);
+    bool HasPacket(uint64_t key) const;
+    uint64_t ExtendSequenceNumber(uint seq) const;
+    void ProcessFEC(void);
+    bool RecoverPacket(const FECEntry &fec);
+    void AddFECCover(const FECEntry &fec, int delta);
+    QList<FECEntry>::iterator EraseFEC(QList<FECEntry>::iterator it);
+
+  private:
+    /// Size of the reorder window, must be a power of two
+    static const uint kRingSize = 1024;
+
     int m_large_sequence_number_seen_recently;
     uint64_t m_current_sequence;
 
-    /// The key is the RTP sequence number + sequence if applicable
-    QMap<uint64_t, RTPDataPacket> m_unordered_packets;
+    /// Reorder window, indexed by the extended sequence number
+    /// (RTP sequence number + sequence if applicable) modulo kRingSize
+    QVector<RTPDataPacket> m_ring;
+    QVector<bool> m_ring_used;
+    /// Extended sequence number of the oldest slot in the window
+    uint64_t m_ring_head;
+    /// Extended sequence number of the packet held in each slot. Once
+    /// FEC is in use released packets are kept until their slot is
+    /// reused, so they can still be used to rebuild a later packet.
+    QVector<uint64_t> m_ring_keys;
+    /// Number of occupied slots in the window
+    uint m_ring_count;
+    bool m_ring_started;
+
+    /// FEC packets that may still be needed
+    QList<FECEntry> m_fec_packets;
+    /// Number of FEC packets in m_fec_packets protecting a packet in
+    /// each slot, so released slots with no FEC skip recovery
+    QVector<uint> m_fec_cover;
+    bool m_fec_seen;
+    uint64_t m_recovered_packets;
+    uint64_t m_lost_packets;
 };
 
 #endif // _RTP_PACKET_BUFFER_H_
@@ -20,7 +20,9 @@ StreamHandler::StreamHandler(const QString &device) :
     _pid_lock(QMutex::Recursive),
     _open_pid_filters(0),
 
-    _listener_lock(QMutex::Recursive)
+    _listener_lock(QMutex::Recursive),
+    _demux_dirty(true),
+    _demux_table(0x2000, 0)
 {
 }
 
@@ -86,6 +88,7 @@ void StreamHandler::AddListener(MPEGStreamData *data,
     else
     {
         _stream_data_list[data] = output_file;
+        _demux_dirty = true;
     }
 
     if (!output_file.isEmpty())
@@ -125,6 +128,7 @@ void StreamHandler::RemoveListener(MPEGStreamData *data)
         if (!(*it).isEmpty())
             RemoveNamedOutputFile(*it);
         _stream_data_list.erase(it);
+        _demux_dirty = true;
     }
 
     if (_stream_data_list.empty())
@@ -374,3 +378,166 @@ PIDPriority StreamHandler::GetPIDPriority(uint pid) const
 
     return tmp;
 }
+
+/** \fn StreamHandler::DemuxData(const unsigned char*,int)
+ *  \brief Splits a buffer of transport stream data among all listeners.
+ *
+ *   Each packet is parsed once and handed, by reference into the shared
+ *   read-only buffer, only to the listeners whose PIDs include the packet's
+ *   PID. The PID to listener table is rebuilt whenever a listener is added
+ *   or removed or a listener's PIDChangeCount() changes.
+ *
+ *   Must be called from the stream handler's run thread.
+ *
+ *  \return number of unprocessed bytes left at the end of the buffer.
+ */
+int StreamHandler::DemuxData(const unsigned char *buffer, int len)
+{
+    QMutexLocker locker(&_listener_lock);
+
+    if (_stream_data_list.empty())
+        return 0;
+
+    if (_stream_data_list.size() > (int)kMaxDemuxListeners)
+    {
+        int remainder = 0;
+        StreamDataList::const_iterator sit = _stream_data_list.begin();
+        for (; sit != _stream_data_list.end(); ++sit)
+            remainder = sit.key()->ProcessData(buffer, len);
+        return remainder;
+    }
+
+    // PIDs may also be changed from outside this thread, e.g. by the
+    // recorder or the signal monitor, pick those changes up here.
+    for (uint i = 0; i < _demux_listeners.size() && !_demux_dirty; i++)
+    {
+        if (_demux_listeners[i]->PIDChangeCount() != _demux_change_count[i])
+            _demux_dirty = true;
+    }
+
+    if (_demux_dirty)
+        UpdateDemuxTable();
+
+    int pos = 0;
+    bool resync = false;
+
+    while (pos + int(TSPacket::kSize) <= len)
+    { // while we have a whole packet left...
+        if (buffer[pos] != SYNC_BYTE || resync)
+        {
+            int newpos = MPEGStreamData::ResyncStream(buffer, pos+1, len);
+            LOG(VB_RECORD, LOG_DEBUG, LOC +
+                QString("Resyncing @ %1+1 w/len %2 -> %3")
+                .arg(pos).arg(len).arg(newpos));
+            if (newpos == -1)
+                return len - pos;
+            if (newpos == -2)
+                return TSPacket::kSize;
+            pos = newpos;
+        }
+
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(&buffer[pos]);
+        pos += TSPacket::kSize; // Advance to next TS packet
+        resync = false;
+
+        uint32_t mask = _demux_table[pkt->PID()];
+        for (uint i = 0; mask; i++, mask >>= 1)
+        {
+            if (!(mask & 0x1))
+                continue;
+
+            _demux_listeners[i]->ProcessTSPacket(*pkt);
+            _demux_packets[i]++;
+
+            // A PAT or PMT may have changed what this listener wants
+            if (_demux_listeners[i]->PIDChangeCount() != _demux_change_count[i])
+                _demux_dirty = true;
+        }
+
+        if (_demux_dirty)
+            UpdateDemuxTable();
+
+        if (pkt->TransportError())
+        {
+            if (pos + int(TSPacket::kSize) > len)
+                continue;
+            if (buffer[pos] != SYNC_BYTE)
+            {
+                // if the packet is bad, and we don't appear to be
+                // in sync on the next packet, then resync. Otherwise
+                // just process the next packet normally.
+                pos -= TSPacket::kSize;
+                resync = true;
+            }
+        }
+    }
+
+    if (!_demux_stats_timer.isRunning())
+        _demux_stats_timer.start();
+    else if (_demux_stats_timer.elapsed() > 60000)
+        LogDemuxStats();
+
+    return len - pos;
+}
+
+/** \fn StreamHandler::UpdateDemuxTable(void)
+ *  \brief Rebuilds the PID to listener table used by DemuxData().
+ *
+ *   Must be called with _listener_lock held.
+ */
+void StreamHandler::UpdateDemuxTable(void)
+{
+    QMap<MPEGStreamData*, uint64_t> old_packets;
+    for (uint i = 0; i < _demux_listeners.size(); i++)
+        old_packets[_demux_listeners[i]] = _demux_packets[i];
+
+    _demux_listeners.clear();
+    _demux_change_count.clear();
+    _demux_packets.clear();
+    _demux_table.assign(0x2000, 0);
+
+    StreamDataList::const_iterator sit = _stream_data_list.begin();
+    for (uint i = 0; sit != _stream_data_list.end() &&
+             i < kMaxDemuxListeners; ++sit, ++i)
+    {
+        MPEGStreamData *sd = sit.key();
+
+        // Read the count before the PIDs so a concurrent change
+        // causes another rebuild rather than being missed.
+        _demux_listeners.push_back(sd);
+        _demux_change_count.push_back(sd->PIDChangeCount());
+        _demux_packets.push_back(old_packets.value(sd, 0));
+
+        pid_map_t pids;
+        sd->GetPIDs(pids);
+        pid_map_t::const_iterator it = pids.constBegin();
+        for (; it != pids.constEnd(); ++it)
+        {
+            if (it.key() < 0x2000)
+                _demux_table[it.key()] |= (1U << i);
+        }
+    }
+
+    _demux_dirty = false;
+}
+
+/** \fn StreamHandler::LogDemuxStats(void)
+ *  \brief Logs the per listener packet rate seen by DemuxData()
+ *         and resets the counters.
+ */
+void StreamHandler::LogDemuxStats(void)
+{
+    int elapsed = max(_demux_stats_timer.restart(), 1);
+
+    QString msg;
+    for (uint i = 0; i < _demux_listeners.size(); i++)
+    {
+        msg += QString(" 0x%1: %2 pkt/s")
+            .arg((uint64_t)_demux_listeners[i],0,16)
+            .arg(_demux_packets[i] * 1000 / elapsed);
+        _demux_packets[i] = 0;
+    }
+
+    LOG(VB_RECORD, LOG_INFO, LOC +
+        QString("Demux %1 listeners:").arg(_demux_listeners.size()) + msg);
+}
@@ -81,6 +81,10 @@ class StreamHandler : protected MThread, public DeviceReaderCB
 
     PIDPriority GetPIDPriority(uint pid) const;
 
+    int  DemuxData(const unsigned char *buffer, int len);
+    void UpdateDemuxTable(void);
+    void LogDemuxStats(void);
+
     // DeviceReaderCB
     virtual void ReaderPaused(int fd) { (void) fd; }
     virtual void PriorityEvent(int fd) { (void) fd; }
@@ -122,6 +126,18 @@ class StreamHandler : protected MThread, public DeviceReaderCB
     typedef QMap<MPEGStreamData*,QString> StreamDataList;
     mutable QMutex    _listener_lock;
     StreamDataList    _stream_data_list;
+
+    /// Maximum number of listeners the shared demux table can route to,
+    /// any more and DemuxData() falls back to MPEGStreamData::ProcessData().
+    static const uint kMaxDemuxListeners = 32;
+    // Shared demux state, protected by _listener_lock
+    bool              _demux_dirty;
+    vector<MPEGStreamData*> _demux_listeners;
+    vector<int>       _demux_change_count;
+    vector<uint64_t>  _demux_packets;
+    /// Bitmask of _demux_listeners indices interested in each PID
+    vector<uint32_t>  _demux_table;
+    MythTimer         _demux_stats_timer;
 };
 
 #endif // _STREAM_HANDLER_H_
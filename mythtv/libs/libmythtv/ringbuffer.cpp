@@ -40,6 +40,8 @@ const int  RingBuffer::kDefaultOpenTimeout = 2000; // ms
 const int  RingBuffer::kLiveTVOpenTimeout  = 10000;
 
 #define CHUNK 32768 /* readblocksize increments */
+#define FILL_MIN_SECS 0.35f /* default seconds buffered before reads */
+#define STALL_DECAY_TIME 30000 /* ms without a stall before buffering less */
 
 #define LOC      QString("RingBuf(%1): ").arg(filename)
 
@@ -196,7 +198,9 @@ RingBuffer::RingBuffer(RingBufferType rbtype) :
     rawbitrate(8000),         playspeed(1.0f),
     fill_threshold(65536),    fill_min(-1),
     readblocksize(CHUNK),     wanttoread(0),
-    numfailures(0),           commserror(false),
+    numfailures(0),           stallcount(0),
+    stallarmed(0),            readlatency(0),
+    fill_min_secs(FILL_MIN_SECS), commserror(false),
     oldfile(false),           livetvchain(NULL),
     ignoreliveeof(false),     readAdjust(0),
     bitrateMonitorEnabled(false)
@@ -377,10 +381,13 @@ void RingBuffer::CalcReadAheadThresh(void)
     else
         readblocksize = max(rbs,readblocksize);
 
-    // minumum seconds of buffering before allowing read
-    float secs_min = 0.35;
+    // minumum seconds of buffering before allowing read, this grows
+    // when the reader stalls and must cover a couple of storage reads
+    float secs_min = max(fill_min_secs,
+                         2 * readlatency.fetchAndAddOrdered(0) * 0.001f);
     // set the minimum buffering before allowing ffmpeg read
     fill_min  = (uint) ((estbitrate * 1000 * secs_min) * 0.125f);
+    fill_min  = min(fill_min, (int)bufferSize / 2);
     // make this a multiple of ffmpeg block size..
     if (fill_min >= CHUNK || rbs >= CHUNK)
     {
@@ -401,9 +408,11 @@ void RingBuffer::CalcReadAheadThresh(void)
 
     LOG(VB_FILE, LOG_INFO, LOC +
         QString("CalcReadAheadThresh(%1 Kb)\n\t\t\t -> "
-                "threshhold(%2 KB) min read(%3 KB) blk size(%4 KB)")
+                "threshhold(%2 KB) min read(%3 KB) blk size(%4 KB) "
+                "min secs(%5) read latency(%6 ms)")
             .arg(estbitrate).arg(fill_threshold/1024)
-            .arg(fill_min/1024).arg(readblocksize/1024));
+            .arg(fill_min/1024).arg(readblocksize/1024)
+            .arg(secs_min).arg(readlatency.fetchAndAddOrdered(0)));
 }
 
 bool RingBuffer::IsNearEnd(double fps, uint vvf) const
@@ -485,6 +494,7 @@ void RingBuffer::ResetReadAhead(long long newinternal)
     ateof = false;
     readsallowed = false;
     setswitchtonext = false;
+    stallarmed.fetchAndStoreRelease(0);
     generalWait.wakeAll();
 
     rbwlock.unlock();
@@ -741,6 +751,12 @@ void RingBuffer::run(void)
     int readtimeavg = 300;
     bool ignore_for_read_timing = true;
 
+    // These are used to adjust the buffering to reader stalls
+    int stallshandled = stallcount.fetchAndAddOrdered(0);
+    MythTimer stall_timer;
+    stall_timer.start();
+    bool short_read = false;
+
     gettimeofday(&lastread, NULL); // this is just to keep gcc happy
 
     CreateReadAheadBuffer();
@@ -884,6 +900,19 @@ void RingBuffer::run(void)
                     .arg(QString("(%1Mbps)").arg((double)bps / 1000000.0)));
             UpdateStorageRate(bps);
 
+            if (read_return > 0)
+            {
+                int latency = readlatency.fetchAndAddOrdered(0);
+                readlatency.fetchAndStoreRelease(
+                    (latency * 7 + sr_elapsed) / 8);
+            }
+            // A short read means we caught up with the end of the file,
+            // the reader waiting on the recorder is not a storage stall.
+            if (read_return >= 0)
+                short_read = read_return < totfree;
+            if (short_read)
+                stallarmed.fetchAndStoreRelease(0);
+
             if (read_return >= 0)
             {
                 poslock.lockForWrite();
@@ -901,8 +930,47 @@ void RingBuffer::run(void)
             }
         }
 
+        int stalls = stallcount.fetchAndAddOrdered(0);
+        bool decay = (stalls == stallshandled) &&
+            (fill_min_secs > FILL_MIN_SECS) &&
+            (stall_timer.elapsed() > STALL_DECAY_TIME);
+        if (stalls != stallshandled || decay)
+        {
+            rwlock.unlock();
+            rwlock.lockForWrite();
+
+            // Each stall buys another 50% of buffered playback time, up to
+            // the point where more buffering can no longer help. Once the
+            // storage keeps up again this is slowly given back.
+            if (decay)
+            {
+                fill_min_secs = max(fill_min_secs / 1.5f, FILL_MIN_SECS);
+            }
+            else
+            {
+                for (int i = stallshandled; i != stalls; i++)
+                    fill_min_secs = min(fill_min_secs * 1.5f, 3.0f);
+                stallshandled = stalls;
+            }
+            stall_timer.start();
+            bool was_allowed = readsallowed;
+            CalcReadAheadThresh();
+            readsallowed = was_allowed;
+
+            LOG(VB_FILE, LOG_INFO, LOC +
+                QString("Reader stalled %1 times, buffering %2 secs "
+                        "before allowing reads")
+                    .arg(stalls).arg(fill_min_secs));
+
+            rwlock.unlock();
+            rwlock.lockForRead();
+        }
+
         int used = bufferSize - ReadBufFree();
 
+        if (used >= fill_threshold && !short_read)
+            stallarmed.fetchAndStoreRelease(1);
+
         bool reads_were_allowed = readsallowed;
 
         if ((0 == read_return) || (numfailures > 5) ||
@@ -1067,6 +1135,16 @@ bool RingBuffer::WaitForAvail(int count)
         generalWait.wakeAll();
     }
 
+    // The read ahead thread could not keep up with the reader, so have it
+    // buffer more before allowing reads again. Only the first wait after
+    // the buffer was full is counted, see note 2 in ringbuffer.h.
+    if ((avail < count) && !ateof && !stopreads && !request_pause &&
+        !commserror && readaheadrunning && !setswitchtonext &&
+        stallarmed.testAndSetOrdered(1, 0))
+    {
+        stallcount.fetchAndAddOrdered(1);
+    }
+
     MythTimer t;
     t.start();
     while ((avail < count) && !stopreads &&
@@ -1376,6 +1454,23 @@ QString RingBuffer::GetAvailableBuffer(void)
     return QString("%1%").arg((int)(((float)avail / (float)bufferSize) * 100.0));
 }
 
+/** \fn RingBuffer::GetReadAheadStats(void)
+ *  \brief Returns the number of times the reader had to wait for the
+ *         read ahead thread and the average storage read latency.
+ */
+QString RingBuffer::GetReadAheadStats(void)
+{
+    if (type == kRingBuffer_DVD || type == kRingBuffer_BD)
+        return "N/A";
+
+    rwlock.lockForRead();
+    QString ret = QString("%1 stalls, %2 ms/read")
+        .arg(stallcount.fetchAndAddOrdered(0))
+        .arg(readlatency.fetchAndAddOrdered(0));
+    rwlock.unlock();
+    return ret;
+}
+
 uint64_t RingBuffer::UpdateDecoderRate(uint64_t latest)
 {
     if (!bitrateMonitorEnabled)
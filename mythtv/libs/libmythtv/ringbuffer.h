@@ -4,6 +4,7 @@
 #define _RINGBUFFER_H_
 
 #include <QReadWriteLock>
+#include <QAtomicInt>
 #include <QWaitCondition>
 #include <QString>
 #include <QMutex>
@@ -75,6 +76,7 @@ class MTV_PUBLIC RingBuffer : protected MThread
     QString GetDecoderRate(void);
     QString GetStorageRate(void);
     QString GetAvailableBuffer(void);
+    QString GetReadAheadStats(void);
     uint    GetBufferSize(void) { return bufferSize; }
     long long GetWritePosition(void) const;
     /// \brief Returns the size of the file we are reading/writing,
@@ -230,6 +232,10 @@ class MTV_PUBLIC RingBuffer : protected MThread
     int       readblocksize;      // protected by rwlock
     int       wanttoread;         // protected by rwlock
     int       numfailures;        // protected by rwlock (see note 1)
+    QAtomicInt stallcount;        // see note 2
+    QAtomicInt stallarmed;        // see note 2
+    QAtomicInt readlatency;       // see note 2
+    float     fill_min_secs;      // protected by rwlock
     bool      commserror;         // protected by rwlock
 
     bool oldfile;                 // protected by rwlock
@@ -252,6 +258,14 @@ class MTV_PUBLIC RingBuffer : protected MThread
     // fragile state of affairs and care must be taken when modifying
     // code or locking around this variable.
 
+    // note 2: these are changed while holding only a read lock, by the
+    // reading thread (stallcount, stallarmed) and by the read ahead
+    // thread (stallarmed, readlatency), so they are atomic instead.
+    // stallarmed is set once the buffer has filled up since the last
+    // seek and cleared by a short read, so that only waits caused by
+    // slow storage are counted as stalls. fill_min_secs is only changed
+    // by the read ahead thread with the write lock held.
+
     /// Condition to signal that the read ahead thread is running
     QWaitCondition generalWait;         // protected by rwlock
 
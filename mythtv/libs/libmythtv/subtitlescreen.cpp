@@ -524,6 +524,8 @@ static const float PAD_HEIGHT = 0.04;
 // extra blank space between lines to make 17 lines within the safe
 // area.
 static const float LINE_SPACING = (20.0 / 17.0);
+// Measurements kept before the caches are flushed
+static const int kMaxMetricsCache = 2000;
 
 SubtitleScreen::SubtitleScreen(MythPlayer *player, const char * name,
                                int fontStretch) :
@@ -531,9 +533,10 @@ SubtitleScreen::SubtitleScreen(MythPlayer *player, const char * name,
     m_player(player),  m_subreader(NULL),   m_608reader(NULL),
     m_708reader(NULL), m_safeArea(QRect()),
     m_removeHTML(QRegExp("</?.+>")),        m_subtitleType(kDisplayNone),
+    m_fontSize(0),
     m_textFontZoom(100), m_textFontZoomPrev(100), m_refreshArea(false),
     m_fontStretch(fontStretch),
-    m_format(new SubtitleFormat)
+    m_format(new SubtitleFormat),           m_preparedStart(0)
 {
     m_removeHTML.setMinimal(true);
 
@@ -1082,7 +1085,18 @@ void SubtitleScreen::DisplayTextSubtitles(void)
         changed |= subs->HasSubtitleChanged(playPos);
     if (!changed)
     {
+        // Use the quiet time to lay out the next subtitle, so it is
+        // measured before it is due rather than on the frame it appears.
+        uint64_t start = 0;
+        QStringList nextsubs;
+        if (playPos != 0)
+            nextsubs = subs->GetNextSubtitles(playPos, start);
         subs->Unlock();
+        if (!nextsubs.empty() && start != m_preparedStart)
+        {
+            m_preparedStart = start;
+            PrepareTextSubtitles(nextsubs);
+        }
         return;
     }
 
@@ -1140,6 +1154,18 @@ void SubtitleScreen::DrawTextSubtitles(QStringList &wrappedsubs,
     m_refreshArea = fsub.Draw(m_family, NULL, start, duration) || m_refreshArea;
 }
 
+/** \fn SubtitleScreen::PrepareTextSubtitles(QStringList&)
+ *  \brief Lays out text subtitles without drawing them, which leaves
+ *         their measurements cached for when they are displayed.
+ */
+void SubtitleScreen::PrepareTextSubtitles(QStringList &wrappedsubs)
+{
+    FormattedTextSubtitle fsub(m_safeArea, this);
+    fsub.InitFromSRT(wrappedsubs, m_textFontZoom);
+    fsub.WrapLongLines();
+    fsub.Layout();
+}
+
 void SubtitleScreen::DisplayDVDButton(AVSubtitle* dvdButton, QRect &buttonPos)
 {
     if (!dvdButton || !m_player)
@@ -2048,11 +2074,30 @@ static QSize CalcShadowOffsetPadding(MythFontProperties *mythfont)
     return QSize(shadowWidth + outlineSize, shadowHeight + outlineSize);
 }
 
+// Everything GetFont() uses that changes the size of the text, but not
+// the colours, which are set on every call anyway.
+QString SubtitleScreen::MetricsKey(const CC708CharacterAttribute &format,
+                                   bool teletext) const
+{
+    int style = (format.italics   ? 1 : 0) | (format.boldface ? 2 : 0) |
+                (format.underline ? 4 : 0) | (teletext        ? 8 : 0);
+    return QString("%1|%2|%3|%4|%5|%6|%7|%8|")
+        .arg(m_family).arg(m_fontSize).arg(m_textFontZoom).arg(m_fontStretch)
+        .arg(format.pen_size & 0x3).arg(format.font_tag & 0x7)
+        .arg(format.edge_type).arg(style);
+}
+
 QSize SubtitleScreen::CalcTextSize(const QString &text,
                                    const CC708CharacterAttribute &format,
                                    bool teletext,
                                    float layoutSpacing) const
 {
+    QString key = MetricsKey(format, teletext) +
+        QString::number(layoutSpacing) + "|" + text;
+    QHash<QString, QSize>::const_iterator it = m_textSizeCache.find(key);
+    if (it != m_textSizeCache.end())
+        return *it;
+
     MythFontProperties *mythfont = GetFont(format, teletext);
     QFont *font = mythfont->GetFace();
     QFontMetrics fm(*font);
@@ -2061,6 +2106,10 @@ QSize SubtitleScreen::CalcTextSize(const QString &text,
     if (layoutSpacing > 0 && !text.trimmed().isEmpty())
         height = max(height, (int)(font->pixelSize() * layoutSpacing));
     height += CalcShadowOffsetPadding(mythfont).height();
+
+    if (m_textSizeCache.size() >= kMaxMetricsCache)
+        m_textSizeCache.clear();
+    m_textSizeCache.insert(key, QSize(width, height));
     return QSize(width, height);
 }
 
@@ -2070,12 +2119,21 @@ QSize SubtitleScreen::CalcTextSize(const QString &text,
 int SubtitleScreen::CalcPadding(const CC708CharacterAttribute &format,
                                 bool teletext, bool isLeft) const
 {
+    QString key = MetricsKey(format, teletext) + (isLeft ? "L" : "R");
+    QHash<QString, int>::const_iterator it = m_paddingCache.find(key);
+    if (it != m_paddingCache.end())
+        return *it;
+
     MythFontProperties *mythfont = GetFont(format, teletext);
     QFont *font = mythfont->GetFace();
     QFontMetrics fm(*font);
     int result = fm.maxWidth() * PAD_WIDTH;
     if (!isLeft)
         result += CalcShadowOffsetPadding(mythfont).width();
+
+    if (m_paddingCache.size() >= kMaxMetricsCache)
+        m_paddingCache.clear();
+    m_paddingCache.insert(key, result);
     return result;
 }
 
@@ -73,6 +73,7 @@ class SubtitleScreen : public MythScreenType
     void DisplayRawTextSubtitles(void);
     void DrawTextSubtitles(QStringList &wrappedsubs, uint64_t start,
                            uint64_t duration);
+    void PrepareTextSubtitles(QStringList &wrappedsubs);
     void DisplayCC608Subtitles(void);
     void DisplayCC708Subtitles(void);
     void AddScaledImage(QImage &img, QRect &pos);
@@ -81,6 +82,8 @@ class SubtitleScreen : public MythScreenType
     MythFontProperties* GetFont(CC708CharacterAttribute attr,
                                 bool teletext) const;
     void SetFontSize(int pixelSize) { m_fontSize = pixelSize; }
+    QString MetricsKey(const CC708CharacterAttribute &format,
+                       bool teletext) const;
 
     MythPlayer        *m_player;
     SubtitleReader    *m_subreader;
@@ -99,6 +102,12 @@ class SubtitleScreen : public MythScreenType
     int                m_fontStretch;
     QString            m_family; // 608, 708, text, teletext
     class SubtitleFormat *m_format;
+    // Text measurements, keyed by everything that selects the font.
+    // Captions repeat the same lines as they roll up, so most layouts
+    // are served from here without creating any QFontMetrics.
+    mutable QHash<QString, QSize> m_textSizeCache;
+    mutable QHash<QString, int>   m_paddingCache;
+    uint64_t           m_preparedStart; // start of the laid out next sub
 
 #ifdef USING_LIBASS
     bool InitialiseAssLibrary(void);
@@ -12,6 +12,7 @@
 // C++
 #include <algorithm>
 using std::lower_bound;
+using std::upper_bound;
 
 // Qt
 #include <QTextCodec>
@@ -102,6 +103,31 @@ QStringList TextSubtitles::GetSubtitles(uint64_t timecode) const
     return list;
 }
 
+/** \fn TextSubtitles::GetNextSubtitles(uint64_t, uint64_t&) const
+ *  \brief Returns the first subtitles starting after the given timecode,
+ *         so they can be laid out before they are due.
+ *
+ *  \param timecode The timecode of the current video position.
+ *  \param start    Set to the starting timecode of the returned subtitles.
+ *  \return The subtitles as a list of strings, empty if there are none.
+ */
+QStringList TextSubtitles::GetNextSubtitles(uint64_t timecode,
+                                            uint64_t &start) const
+{
+    text_subtitle_t searchTarget(timecode, timecode);
+
+    TextSubtitleList::const_iterator nextSubPos =
+        upper_bound(m_subtitles.begin(), m_subtitles.end(), searchTarget);
+
+    if (nextSubPos == m_subtitles.end())
+        return QStringList();
+
+    start = (*nextSubPos).start;
+    QStringList tmp = (*nextSubPos).textLines;
+    tmp.detach();
+    return tmp;
+}
+
 void TextSubtitles::AddSubtitle(const text_subtitle_t &newSub)
 {
     m_lock.lock();
@@ -50,6 +50,7 @@ class TextSubtitles
 
     bool HasSubtitleChanged(uint64_t timecode) const;
     QStringList GetSubtitles(uint64_t timecode) const;
+    QStringList GetNextSubtitles(uint64_t timecode, uint64_t &start) const;
 
     /** \fn TextSubtitles::IsFrameBasedTiming(void) const
      *  \brief Returns true in case the subtitle timing data is frame-based.
@@ -2,9 +2,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <climits>
 #include <unistd.h>
 #include <sched.h> // for sched_yield
 
+// Qt headers
+#include <QPair>
+
 // MythTV headers
 
 #include "compat.h"
@@ -89,7 +93,7 @@ TVRec::TVRec(int capturecardnum)
       transcodeFirst(false),
       earlyCommFlag(false),         runJobOnHostOnly(false),
       eitCrawlIdleStart(60),        eitTransportTimeout(5*60),
-      audioSampleRateDB(0),
+      audioSampleRateDB(0),         fastChannelChange(false),
       overRecordSecNrml(0),         overRecordSecCat(0),
       overRecordCategory(""),
       // Configuration variables from setup rutines
@@ -99,7 +103,7 @@ TVRec::TVRec(int capturecardnum)
       pendingRecLock(QMutex::Recursive),
       internalState(kState_None), desiredNextState(kState_None),
       changeState(false), pauseNotify(true),
-      stateFlags(0), lastTuningRequest(0),
+      stateFlags(0), lastTuningRequest(0), tuningCount(0),
       triggerEventLoopLock(QMutex::NonRecursive),
       triggerEventLoopSignal(false),
       triggerEventSleepLock(QMutex::NonRecursive),
@@ -119,6 +123,7 @@ TVRec::TVRec(int capturecardnum)
 {
     QMutexLocker locker(&cardsLock);
     cards[cardid] = this;
+    memset(tuningLatency, 0, sizeof(tuningLatency));
 }
 
 bool TVRec::CreateChannel(const QString &startchannel,
@@ -165,6 +170,7 @@ bool TVRec::Init(void)
         max(gCoreContext->GetNumSetting("EITTransportTimeout", 5) * 60, 6);
     eitCrawlIdleStart = gCoreContext->GetNumSetting("EITCrawIdleStart", 60);
     audioSampleRateDB = gCoreContext->GetNumSetting("AudioSampleRate");
+    fastChannelChange = gCoreContext->GetNumSetting("FastChannelChange", 0);
     overRecordSecNrml = gCoreContext->GetNumSetting("RecordOverTime");
     overRecordSecCat  = gCoreContext->GetNumSetting("CategoryOverTime") * 60;
     overRecordCategory= gCoreContext->GetSetting("OverTimeCategory");
@@ -1772,6 +1778,94 @@ static bool ApplyCachedPids(DTVSignalMonitor *dtvMon, const DTVChannel* channel)
     return vctpid_cached;
 }
 
+/// Last PAT & PMT seen for each multiplex and program number, these
+/// let FastChannelChange skip waiting for the tables after a tune.
+typedef QPair<ProgramAssociationTable*, ProgramMapTable*> zap_tables_t;
+static QMutex                      zap_cache_lock;
+static QMap<QString, zap_tables_t> zap_cache;
+
+static uint get_mplexid(const ChannelBase *channel)
+{
+    if (!channel)
+        return 0;
+    return ChannelUtil::GetMplexID(channel->GetCurrentSourceID(),
+                                   channel->GetCurrentName());
+}
+
+static void CacheZapTables(uint mplexid, const MPEGStreamData *sd)
+{
+    int progNum = sd->DesiredProgram();
+    if (!mplexid || progNum <= 0)
+        return;
+
+    const ProgramAssociationTable *pat = NULL;
+    pat_vec_t pats = sd->GetCachedPATs();
+    for (uint i = 0; i < pats.size() && !pat; i++)
+    {
+        if (!pats[i]->LastSection() && pats[i]->FindPID(progNum))
+            pat = pats[i];
+    }
+    pmt_const_ptr_t pmt = sd->GetCachedPMT(progNum, 0);
+
+    if (pat && pmt && !pmt->LastSection())
+    {
+        QMutexLocker locker(&zap_cache_lock);
+
+        // The tables are small, but don't let this grow without bound
+        if (zap_cache.size() >= 1024)
+        {
+            QMap<QString, zap_tables_t>::iterator it = zap_cache.begin();
+            for (; it != zap_cache.end(); ++it)
+            {
+                delete (*it).first;
+                delete (*it).second;
+            }
+            zap_cache.clear();
+        }
+
+        QString key = QString("%1_%2").arg(mplexid).arg(progNum);
+        QMap<QString, zap_tables_t>::iterator it = zap_cache.find(key);
+        if (it != zap_cache.end())
+        {
+            delete (*it).first;
+            delete (*it).second;
+        }
+        zap_cache[key] = zap_tables_t(new ProgramAssociationTable(*pat),
+                                      new ProgramMapTable(*pmt));
+    }
+
+    if (pmt)
+        sd->ReturnCachedTable(pmt);
+    sd->ReturnCachedPATTables(pats);
+}
+
+/** \brief Feeds the last PAT & PMT seen for this program to the stream
+ *         data, so the signal monitor and the recorder can use them
+ *         right away. Newer versions of the tables replace these as
+ *         usual once they arrive.
+ */
+static bool ApplyZapTables(uint mplexid, int progNum, MPEGStreamData *sd)
+{
+    if (!mplexid || progNum <= 0)
+        return false;
+
+    QMutexLocker locker(&zap_cache_lock);
+
+    QString key = QString("%1_%2").arg(mplexid).arg(progNum);
+    QMap<QString, zap_tables_t>::const_iterator it = zap_cache.find(key);
+    if (it == zap_cache.end())
+        return false;
+
+    uint pmt_pid = (*it).first->FindPID(progNum);
+    if (!pmt_pid)
+        return false;
+
+    sd->HandleTables(MPEG_PAT_PID, *(*it).first);
+    sd->HandleTables(pmt_pid, *(*it).second);
+
+    return true;
+}
+
 /**
  *  \brief Tells DTVSignalMonitor what channel to look for.
  *
@@ -1885,6 +1979,14 @@ bool TVRec::SetupDTVSignalMonitor(bool EITscan)
             sm->GetStreamData()->SetVideoStreamsRequired(0);
             sm->IgnoreEncrypted(true);
         }
+        else if (fastChannelChange &&
+                 ApplyZapTables(get_mplexid(channel), progNum, sd))
+        {
+            // The SDT only confirms what the cached tables already told us
+            sm->RemoveFlags(SignalMonitor::kDTVSigMon_WaitForSDT);
+            LOG(VB_RECORD, LOG_INFO, LOC +
+                "Using cached PAT/PMT for fast channel change.");
+        }
 
         LOG(VB_RECORD, LOG_INFO, LOC +
             "Successfully set up DVB table monitoring.");
@@ -1922,6 +2024,12 @@ bool TVRec::SetupDTVSignalMonitor(bool EITscan)
             sm->GetStreamData()->SetVideoStreamsRequired(0);
             sm->IgnoreEncrypted(true);
         }
+        else if (fastChannelChange &&
+                 ApplyZapTables(get_mplexid(channel), progNum, sd))
+        {
+            LOG(VB_RECORD, LOG_INFO, LOC +
+                "Using cached PAT/PMT for fast channel change.");
+        }
 
         LOG(VB_RECORD, LOG_INFO, LOC +
             "Successfully set up MPEG table monitoring.");
@@ -3485,6 +3593,11 @@ void TVRec::HandleTuning(void)
         // release the stateChangeLock to teardown a recorder
         tuningRequests.dequeue();
 
+        if (request.flags & (kFlagRecording|kFlagLiveTV))
+            tuningTimer.start();
+        else
+            tuningTimer.stop();
+
         // Now we start new stuff
         if (request.flags & (kFlagRecording|kFlagLiveTV|
                              kFlagEITScan|kFlagAntennaAdjust))
@@ -3526,12 +3639,47 @@ void TVRec::HandleTuning(void)
         else
             TuningNewRecorder(streamData);
 
+        if (tuningTimer.isRunning() && !HasFlags(kFlagNeedToStartRecorder))
+        {
+            UpdateTuningStats(tuningTimer.elapsed());
+            tuningTimer.stop();
+        }
+
         // If we got this far it is safe to set a new starting channel...
         if (channel)
             channel->StoreInputChannels();
     }
 }
 
+static const int kTuningStatBounds[] = { 250, 500, 1000, 2000, 4000, INT_MAX };
+static const uint kTuningStatLogInterval = 10;
+
+/** \fn TVRec::UpdateTuningStats(int)
+ *  \brief Records how long a channel change took, and periodically logs
+ *         the distribution of channel change latencies.
+ */
+void TVRec::UpdateTuningStats(int elapsed_ms)
+{
+    uint i = 0;
+    while (elapsed_ms > kTuningStatBounds[i])
+        i++;
+    tuningLatency[i]++;
+    tuningCount++;
+
+    LOG(VB_RECORD, LOG_INFO, LOC +
+        QString("Tuning took %1 ms").arg(elapsed_ms));
+
+    if (tuningCount % kTuningStatLogInterval)
+        return;
+
+    LOG(VB_RECORD, LOG_INFO, LOC +
+        QString("Tuning latency after %1 tunes: <=250ms %2, <=500ms %3, "
+                "<=1s %4, <=2s %5, <=4s %6, >4s %7")
+            .arg(tuningCount).arg(tuningLatency[0]).arg(tuningLatency[1])
+            .arg(tuningLatency[2]).arg(tuningLatency[3])
+            .arg(tuningLatency[4]).arg(tuningLatency[5]));
+}
+
 /** \fn TVRec::TuningCheckForHWChange(const TuningRequest&,QString&,QString&)
  *  \brief Returns cardid for device info row in capturecard if it changes.
  */
@@ -3911,6 +4059,12 @@ MPEGStreamData *TVRec::TuningSignalCheck(void)
     }
     ClearFlags(kFlagWaitingForSignal);
 
+    if (streamData && fastChannelChange && (rsRecording == newRecStatus) &&
+        !HasFlags(kFlagEITScannerRunning))
+    {
+        CacheZapTables(get_mplexid(channel), streamData);
+    }
+
     if (streamData)
     {
         DVBStreamData *dsd = dynamic_cast<DVBStreamData*>(streamData);
@@ -17,6 +17,7 @@
 #include "recordinginfo.h"
 #include "tv.h"
 #include "signalmonitorlistener.h"
+#include "mythtimer.h"
 
 #include "mythconfig.h"
 
@@ -289,6 +290,7 @@ class MTV_PUBLIC TVRec : public SignalMonitorListener, public QRunnable
                                 QString &channum,
                                 QString &inputname);
     bool TuningOnSameMultiplex(TuningRequest &request);
+    void UpdateTuningStats(int elapsed_ms);
 
     void HandleStateChange(void);
     void ChangeState(TVState nextState);
@@ -339,6 +341,7 @@ class MTV_PUBLIC TVRec : public SignalMonitorListener, public QRunnable
     int     eitCrawlIdleStart;
     int     eitTransportTimeout;
     int     audioSampleRateDB;
+    bool    fastChannelChange;
     int     overRecordSecNrml;
     int     overRecordSecCat;
     QString overRecordCategory;
@@ -365,6 +368,11 @@ class MTV_PUBLIC TVRec : public SignalMonitorListener, public QRunnable
     TuningQueue    tuningRequests;
     TuningRequest  lastTuningRequest;
     QDateTime      eitScanStartTime;
+    /// Times tuning requests from dequeue until the recorder is running
+    MythTimer      tuningTimer;
+    /// Tuning latency histogram, bucket upper bounds in kTuningStatBounds
+    uint           tuningLatency[6];
+    uint           tuningCount;
     mutable QMutex triggerEventLoopLock;
     QWaitCondition triggerEventLoopWait;
     bool           triggerEventLoopSignal;
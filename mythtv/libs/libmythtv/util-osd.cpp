@@ -1,3 +1,6 @@
+#include <algorithm>
+using std::min;
+
 #include "util-osd.h"
 #include "dithertable.h"
 
@@ -42,6 +45,74 @@ void yuv888_to_yv12(VideoFrame *frame, MythImage *osd_image,
     }
 }
 
+/** \fn osd_coverage(MythImage*,const QRegion&)
+ *  \brief Returns the OSD_TILE sized tiles touching area that hold any
+ *         pixel which is not fully transparent.
+ *
+ *   Tiles are aligned to the image, so the result keeps the alignment the
+ *   blending functions need and can be intersected with the visible OSD.
+ */
+QRegion osd_coverage(MythImage *osd_image, const QRegion &area)
+{
+    QRegion covered;
+    if (!osd_image)
+        return covered;
+
+    QRect bounds = area.boundingRect().intersected(osd_image->rect());
+    if (bounds.isEmpty())
+        return covered;
+
+    int first_row = bounds.top() / OSD_TILE;
+    int last_row  = bounds.bottom() / OSD_TILE;
+    int first_col = bounds.left() / OSD_TILE;
+    int last_col  = bounds.right() / OSD_TILE;
+
+    for (int row = first_row; row <= last_row; row++)
+    {
+        int top    = row * OSD_TILE;
+        int bottom = min(top + OSD_TILE, osd_image->height());
+        int start  = -1;
+
+        for (int col = first_col; col <= last_col + 1; col++)
+        {
+            QRect tile(col * OSD_TILE, top, OSD_TILE, OSD_TILE);
+            bool opaque = false;
+
+            if (col <= last_col && area.intersects(tile))
+            {
+                int left  = col * OSD_TILE;
+                int right = min(left + OSD_TILE, osd_image->width());
+                for (int y = top; y < bottom && !opaque; y++)
+                {
+                    const QRgb *line = (const QRgb*)osd_image->scanLine(y);
+                    for (int x = left; x < right; x++)
+                    {
+                        if (qAlpha(line[x]))
+                        {
+                            opaque = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            // merge runs of covered tiles into one rectangle per row
+            if (opaque && start < 0)
+            {
+                start = col;
+            }
+            else if (!opaque && start >= 0)
+            {
+                covered += QRect(start * OSD_TILE, top,
+                                 (col - start) * OSD_TILE, OSD_TILE);
+                start = -1;
+            }
+        }
+    }
+
+    return covered;
+}
+
 #define ASM(code) __asm__ __volatile__(code);
 void inline mmx_yuv888_to_yv12(VideoFrame *frame, MythImage *osd_image,
                                int left, int top, int right, int bottom)
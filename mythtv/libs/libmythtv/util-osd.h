@@ -1,6 +1,8 @@
 #ifndef UTIL_OSD_H
 #define UTIL_OSD_H
 
+#include <QRegion>
+
 #include "mythlogging.h"
 #include "mythimage.h"
 #include "frame.h"
@@ -12,12 +14,16 @@
 #define ALIGN_X_MMX 2
 #endif
 
+/// Size of the tiles osd_coverage tracks, a multiple of both alignments
+#define OSD_TILE 16
+
 void yuv888_to_yv12(VideoFrame *frame, MythImage *osd_image,
                     int left, int top, int right, int bottom);
 void inline mmx_yuv888_to_yv12(VideoFrame *frame, MythImage *osd_image,
                                int left, int top, int right, int bottom);
 void inline c_yuv888_to_yv12(VideoFrame *frame, MythImage *osd_image,
                              int left, int top, int right, int bottom);
+QRegion osd_coverage(MythImage *osd_image, const QRegion &area);
 void yuv888_to_i44(unsigned char *dest, MythImage *osd_image, QSize dst_size,
                    int left, int top, int right, int bottom, bool ifirst);
 #endif
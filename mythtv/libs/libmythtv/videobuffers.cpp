@@ -2,6 +2,7 @@
 // based on earlier work in MythTV's videout_xvmc.cpp
 
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "mythconfig.h"
 
@@ -20,6 +21,32 @@ extern "C" {
 
 int next_dbg_str = 0;
 
+static const char *queue_names[kVideoBuffer_count] =
+    { "avail", "limbo", "used", "pause", "displayed", "finished", "decode" };
+
+/// Index of a single BufferType in the per queue arrays, -1 for a mask
+static inline int queue_index(BufferType type)
+{
+    switch (type)
+    {
+        case kVideoBuffer_avail:     return 0;
+        case kVideoBuffer_limbo:     return 1;
+        case kVideoBuffer_used:      return 2;
+        case kVideoBuffer_pause:     return 3;
+        case kVideoBuffer_displayed: return 4;
+        case kVideoBuffer_finished:  return 5;
+        case kVideoBuffer_decode:    return 6;
+        default:                     return -1;
+    }
+}
+
+static inline int64_t now_usecs(void)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
 YUVInfo::YUVInfo(uint w, uint h, uint sz, const int *p, const int *o)
     : width(w), height(h), size(sz)
 {
@@ -115,6 +142,15 @@ YUVInfo::YUVInfo(uint w, uint h, uint sz, const int *p, const int *o)
  *        decoder (in the decode queue) then it is placed in the finished queue
  *        until the decoder is no longer using it (not in the decode queue).
  *
+ *  Besides the queues, which keep the order of the frames, every frame has
+ *  an atomic bitmap of the queues it is in, and every queue an atomic size.
+ *  So size(BufferType) and contains(BufferType,VideoFrame*), and with them
+ *  the EnoughFreeFrames() style checks made by the decoder and the player,
+ *  do not take the lock, and moving a frame only walks the queues it is
+ *  actually in. The queues themselves are still only changed, and walked
+ *  by begin_lock() users, with the lock held. The time frames spend in each
+ *  queue is accumulated for GetWaitStatus().
+ *
  * \see VideoOutput
  */
 
@@ -124,6 +160,8 @@ VideoBuffers::VideoBuffers()
       keepprebufferframes(0), createdpauseframe(false), rpos(0), vpos(0),
       global_lock(QMutex::Recursive)
 {
+    memset(wait_usecs, 0, sizeof(wait_usecs));
+    memset(wait_count, 0, sizeof(wait_count));
 }
 
 VideoBuffers::~VideoBuffers()
@@ -165,17 +203,21 @@ void VideoBuffers::Init(uint numdecode, bool extra_for_pause,
     // make a big reservation, so that things that depend on
     // pointer to VideoFrames work even after a few push_backs
     buffers.reserve(max(numcreate, (uint)128));
+    frame_states.reserve(buffers.capacity());
 
     buffers.resize(numcreate);
+    frame_states.resize(numcreate);
     for (uint i = 0; i < numcreate; i++)
     {
         memset(at(i), 0, sizeof(VideoFrame));
         at(i)->codec            = FMT_NONE;
         at(i)->interlaced_frame = -1;
         at(i)->top_field_first  = +1;
-        vbufferMap[at(i)]       = i;
     }
 
+    memset(wait_usecs, 0, sizeof(wait_usecs));
+    memset(wait_count, 0, sizeof(wait_count));
+
     needfreeframes              = need_free;
     needprebufferframes         = needprebuffer_normal;
     needprebufferframes_normal  = needprebuffer_normal;
@@ -184,10 +226,10 @@ void VideoBuffers::Init(uint numdecode, bool extra_for_pause,
     createdpauseframe           = extra_for_pause;
 
     if (createdpauseframe)
-        enqueue(kVideoBuffer_pause, at(numcreate - 1));
+        Push(kVideoBuffer_pause, at(numcreate - 1));
 
     for (uint i = 0; i < numdecode; i++)
-        enqueue(kVideoBuffer_avail, at(i));
+        Push(kVideoBuffer_avail, at(i));
 }
 
 /**
@@ -210,14 +252,15 @@ void VideoBuffers::Reset()
         }
     }
 
-    available.clear();
-    used.clear();
-    limbo.clear();
-    finished.clear();
-    decode.clear();
-    pause.clear();
-    displayed.clear();
-    vbufferMap.clear();
+    if (!buffers.empty())
+    {
+        LOG(VB_PLAYBACK, LOG_INFO,
+            QString("VideoBuffers::Reset() frame wait times: %1")
+                .arg(GetWaitStatus()));
+    }
+
+    for (uint i = 0; i < kVideoBuffer_count; i++)
+        DropAll((BufferType)(1 << i));
 }
 
 /**
@@ -239,19 +282,19 @@ VideoFrame *VideoBuffers::GetNextFreeFrameInternal(BufferType enqueue_to)
     // Try to get a frame not being used by the decoder
     for (uint i = 0; i < available.size(); i++)
     {
-        frame = available.dequeue();
-        if (decode.contains(frame))
-            available.enqueue(frame);
+        frame = Pop(kVideoBuffer_avail);
+        if (contains(kVideoBuffer_decode, frame))
+            Push(kVideoBuffer_avail, frame);
         else
             break;
     }
 
-    while (frame && used.contains(frame))
+    while (frame && contains(kVideoBuffer_used, frame))
     {
         LOG(VB_PLAYBACK, LOG_NOTICE,
             QString("GetNextFreeFrame() served a busy frame %1. Dropping. %2")
                 .arg(DebugString(frame, true)).arg(GetStatus()));
-        frame = available.dequeue();
+        frame = Pop(kVideoBuffer_avail);
     }
 
     if (frame)
@@ -307,10 +350,10 @@ void VideoBuffers::ReleaseFrame(VideoFrame *frame)
 {
     QMutexLocker locker(&global_lock);
 
-    vpos = vbufferMap[frame];
-    limbo.remove(frame);
-    decode.enqueue(frame);
-    used.enqueue(frame);
+    vpos = max(Index(frame), 0);
+    Drop(kVideoBuffer_limbo, frame);
+    Push(kVideoBuffer_decode, frame, false);
+    Push(kVideoBuffer_used, frame);
 }
 
 /**
@@ -321,17 +364,16 @@ void VideoBuffers::ReleaseFrame(VideoFrame *frame)
 void VideoBuffers::DeLimboFrame(VideoFrame *frame)
 {
     QMutexLocker locker(&global_lock);
-    if (limbo.contains(frame))
-        limbo.remove(frame);
+    Drop(kVideoBuffer_limbo, frame);
 
     // if decoder didn't release frame and the buffer is getting released by
     // the decoder assume that the frame is lost and return to available
-    if (!decode.contains(frame))
+    if (!contains(kVideoBuffer_decode, frame))
         safeEnqueue(kVideoBuffer_avail, frame);
 
     // remove from decode queue since the decoder is finished
-    while (decode.contains(frame))
-        decode.remove(frame);
+    while (contains(kVideoBuffer_decode, frame))
+        Drop(kVideoBuffer_decode, frame);
 }
 
 /**
@@ -341,7 +383,7 @@ void VideoBuffers::DeLimboFrame(VideoFrame *frame)
 void VideoBuffers::StartDisplayingFrame(void)
 {
     QMutexLocker locker(&global_lock);
-    rpos = vbufferMap[used.head()];
+    rpos = max(Index(used.empty() ? NULL : used.head()), 0);
 }
 
 /**
@@ -352,8 +394,7 @@ void VideoBuffers::DoneDisplayingFrame(VideoFrame *frame)
 {
     QMutexLocker locker(&global_lock);
 
-    if(used.contains(frame))
-        remove(kVideoBuffer_used, frame);
+    Drop(kVideoBuffer_used, frame);
 
     enqueue(kVideoBuffer_finished, frame);
 
@@ -362,10 +403,10 @@ void VideoBuffers::DoneDisplayingFrame(VideoFrame *frame)
     frame_queue_t::iterator it = ula.begin();
     for (; it != ula.end(); ++it)
     {
-        if (!decode.contains(*it))
+        if (!contains(kVideoBuffer_decode, *it))
         {
-            remove(kVideoBuffer_finished, *it);
-            enqueue(kVideoBuffer_avail, *it);
+            Drop(kVideoBuffer_finished, *it);
+            Push(kVideoBuffer_avail, *it);
         }
     }
 }
@@ -432,13 +473,7 @@ const frame_queue_t *VideoBuffers::queue(BufferType type) const
 VideoFrame *VideoBuffers::dequeue(BufferType type)
 {
     QMutexLocker locker(&global_lock);
-
-    frame_queue_t *q = queue(type);
-
-    if (!q)
-        return NULL;
-
-    return q->dequeue();
+    return Pop(type);
 }
 
 VideoFrame *VideoBuffers::head(BufferType type)
@@ -476,16 +511,8 @@ void VideoBuffers::enqueue(BufferType type, VideoFrame *frame)
     if (!frame)
         return;
 
-    frame_queue_t *q = queue(type);
-    if (!q)
-        return;
-
-    global_lock.lock();
-    q->remove(frame);
-    q->enqueue(frame);
-    global_lock.unlock();
-
-    return;
+    QMutexLocker locker(&global_lock);
+    Push(type, frame);
 }
 
 void VideoBuffers::remove(BufferType type, VideoFrame *frame)
@@ -495,20 +522,11 @@ void VideoBuffers::remove(BufferType type, VideoFrame *frame)
 
     QMutexLocker locker(&global_lock);
 
-    if ((type & kVideoBuffer_avail) == kVideoBuffer_avail)
-        available.remove(frame);
-    if ((type & kVideoBuffer_used) == kVideoBuffer_used)
-        used.remove(frame);
-    if ((type & kVideoBuffer_displayed) == kVideoBuffer_displayed)
-        displayed.remove(frame);
-    if ((type & kVideoBuffer_limbo) == kVideoBuffer_limbo)
-        limbo.remove(frame);
-    if ((type & kVideoBuffer_pause) == kVideoBuffer_pause)
-        pause.remove(frame);
-    if ((type & kVideoBuffer_decode) == kVideoBuffer_decode)
-        decode.remove(frame);
-    if ((type & kVideoBuffer_finished) == kVideoBuffer_finished)
-        finished.remove(frame);
+    for (uint i = 0; i < kVideoBuffer_count; i++)
+    {
+        if (type & (1 << i))
+            Drop((BufferType)(1 << i), frame);
+    }
 }
 
 void VideoBuffers::requeue(BufferType dst, BufferType src, int num)
@@ -559,26 +577,198 @@ frame_queue_t::iterator VideoBuffers::end(BufferType type)
     return it;
 }
 
+/**
+ * \fn VideoBuffers::size(BufferType) const
+ *  Returns the number of frames in a queue, without taking the lock.
+ */
 uint VideoBuffers::size(BufferType type) const
 {
-    QMutexLocker locker(&global_lock);
-
-    const frame_queue_t *q = queue(type);
-    if (q)
-        return q->size();
+    int i = queue_index(type);
+    if (i < 0)
+        return 0;
 
-    return 0;
+    return const_cast<QAtomicInt&>(queue_sizes[i]).fetchAndAddOrdered(0);
 }
 
+/**
+ * \fn VideoBuffers::contains(BufferType, VideoFrame*) const
+ *  Returns true if the frame is in a queue, without taking the lock.
+ */
 bool VideoBuffers::contains(BufferType type, VideoFrame *frame) const
 {
-    QMutexLocker locker(&global_lock);
+    if (queue_index(type) < 0)
+        return false;
 
-    const frame_queue_t *q = queue(type);
-    if (q)
-        return q->contains(frame);
+    int i = Index(frame);
+    if (i < 0)
+    {
+        QMutexLocker locker(&global_lock);
+        return queue(type)->contains(frame);
+    }
+
+    QAtomicInt &queues = const_cast<QAtomicInt&>(frame_states[i].queues);
+    return queues.fetchAndAddOrdered(0) & type;
+}
+
+/**
+ * \fn VideoBuffers::Index(const VideoFrame*) const
+ *  Returns the index of one of our frames, or -1 for any other pointer.
+ */
+int VideoBuffers::Index(const VideoFrame *frame) const
+{
+    if (!frame || buffers.empty() || frame < &buffers[0])
+        return -1;
+
+    uint i = frame - &buffers[0];
+    return (i < buffers.size() && i < frame_states.size()) ? (int)i : -1;
+}
+
+/**
+ * \fn VideoBuffers::Push(BufferType, VideoFrame*, bool)
+ *  Adds a frame to the end of a queue, call with global_lock held.
+ *
+ * \param unique If true a frame already in the queue is moved to the end,
+ *               otherwise it is added again, as the decode queue expects.
+ */
+void VideoBuffers::Push(BufferType type, VideoFrame *frame, bool unique)
+{
+    frame_queue_t *q = queue(type);
+    int qi = queue_index(type);
+    if (!q || !frame)
+        return;
+
+    int i = Index(frame);
+    bool was_in = (i >= 0) ?
+        (frame_states[i].queues.fetchAndAddOrdered(0) & type) :
+        q->contains(frame);
+
+    if (unique && was_in)
+        q->remove(frame);
+    q->enqueue(frame);
+    queue_sizes[qi].fetchAndStoreRelease(q->size());
 
-    return false;
+    if (i < 0)
+        return;
+
+    FrameState &fs = frame_states[i];
+    if (type == kVideoBuffer_decode && (!unique || !was_in))
+        fs.decode_refs++;
+
+    if (!was_in)
+    {
+        // only changed with the lock held, so a plain store is enough
+        fs.entered[qi] = now_usecs();
+        fs.queues.fetchAndStoreRelease(fs.queues.fetchAndAddOrdered(0) | type);
+    }
+}
+
+/**
+ * \fn VideoBuffers::Pop(BufferType)
+ *  Removes the frame at the head of a queue, call with global_lock held.
+ */
+VideoFrame *VideoBuffers::Pop(BufferType type)
+{
+    frame_queue_t *q = queue(type);
+    if (!q || q->empty())
+        return NULL;
+
+    VideoFrame *frame = q->dequeue();
+    queue_sizes[queue_index(type)].fetchAndStoreRelease(q->size());
+
+    int i = Index(frame);
+    if (i >= 0)
+        Left(type, frame_states[i], now_usecs());
+
+    return frame;
+}
+
+/**
+ * \fn VideoBuffers::Drop(BufferType, VideoFrame*)
+ *  Removes a frame from a queue, call with global_lock held.
+ *
+ *  Queues the frame is not in are not walked.
+ */
+void VideoBuffers::Drop(BufferType type, VideoFrame *frame)
+{
+    frame_queue_t *q = queue(type);
+    if (!q || !frame)
+        return;
+
+    int i = Index(frame);
+    if (i >= 0 && !(frame_states[i].queues.fetchAndAddOrdered(0) & type))
+        return;
+
+    q->remove(frame);
+    queue_sizes[queue_index(type)].fetchAndStoreRelease(q->size());
+
+    if (i >= 0)
+        Left(type, frame_states[i], now_usecs());
+}
+
+/**
+ * \fn VideoBuffers::DropAll(BufferType)
+ *  Empties a queue, call with global_lock held.
+ */
+void VideoBuffers::DropAll(BufferType type)
+{
+    frame_queue_t *q = queue(type);
+    if (!q)
+        return;
+
+    int64_t now = now_usecs();
+    frame_queue_t::iterator it = q->begin();
+    for (; it != q->end(); ++it)
+    {
+        int i = Index(*it);
+        if (i >= 0)
+            Left(type, frame_states[i], now);
+    }
+
+    q->clear();
+    queue_sizes[queue_index(type)].fetchAndStoreRelease(0);
+}
+
+/**
+ * \fn VideoBuffers::Left(BufferType, FrameState&, int64_t)
+ *  Updates the state of a frame removed once from a queue, and accounts
+ *  for the time it spent there when it is no longer in it.
+ */
+void VideoBuffers::Left(BufferType type, FrameState &fs, int64_t now)
+{
+    if (type == kVideoBuffer_decode && fs.decode_refs && --fs.decode_refs)
+        return;
+
+    int queues = fs.queues.fetchAndAddOrdered(0);
+    if (!(queues & type))
+        return;
+
+    fs.queues.fetchAndStoreRelease(queues & ~type);
+
+    int qi = queue_index(type);
+    wait_usecs[qi] += max(now - fs.entered[qi], (int64_t)0);
+    wait_count[qi]++;
+}
+
+/**
+ * \fn VideoBuffers::GetWaitStatus(void) const
+ *  Returns the average time frames have spent in each queue since Init(),
+ *  in milliseconds.
+ */
+QString VideoBuffers::GetWaitStatus(void) const
+{
+    QMutexLocker locker(&global_lock);
+
+    QString str;
+    for (uint i = 0; i < kVideoBuffer_count; i++)
+    {
+        if (!wait_count[i])
+            continue;
+        if (!str.isEmpty())
+            str += ", ";
+        str += QString("%1 %2ms").arg(queue_names[i])
+            .arg(wait_usecs[i] * 0.001 / wait_count[i], 0, 'f', 1);
+    }
+    return str;
 }
 
 VideoFrame *VideoBuffers::GetScratchFrame(void)
@@ -602,7 +792,7 @@ void VideoBuffers::SetLastShownFrameToScratch(void)
     }
 
     VideoFrame *pause = head(kVideoBuffer_pause);
-    rpos = vbufferMap[pause];
+    rpos = max(Index(pause), 0);
 }
 
 /**
@@ -662,11 +852,12 @@ void VideoBuffers::DiscardFrames(bool next_frame_keyframe)
 
     // Make sure frames used by decoder are last...
     // This is for libmpeg2 which still uses the frames after a reset.
-    for (it = decode.begin(); it != decode.end(); ++it)
+    frame_queue_t decoding(decode);
+    for (it = decoding.begin(); it != decoding.end(); ++it)
         remove(kVideoBuffer_all, *it);
-    for (it = decode.begin(); it != decode.end(); ++it)
-        available.enqueue(*it);
-    decode.clear();
+    DropAll(kVideoBuffer_decode);
+    for (it = decoding.begin(); it != decoding.end(); ++it)
+        Push(kVideoBuffer_avail, *it);
 
     LOG(VB_PLAYBACK, LOG_INFO,
         QString("VideoBuffers::DiscardFrames(%1): %2 -- done")
@@ -683,15 +874,15 @@ void VideoBuffers::ClearAfterSeek(void)
 
         while (used.count() > 1)
         {
-            VideoFrame *buffer = used.dequeue();
-            available.enqueue(buffer);
+            VideoFrame *buffer = Pop(kVideoBuffer_used);
+            Push(kVideoBuffer_avail, buffer);
         }
 
         if (used.count() > 0)
         {
-            VideoFrame *buffer = used.dequeue();
-            available.enqueue(buffer);
-            vpos = vbufferMap[buffer];
+            VideoFrame *buffer = Pop(kVideoBuffer_used);
+            Push(kVideoBuffer_avail, buffer);
+            vpos = max(Index(buffer), 0);
             rpos = vpos;
         }
         else
@@ -769,10 +960,10 @@ uint VideoBuffers::AddBuffer(int width, int height, void* data,
 
     uint num = Size();
     buffers.resize(num + 1);
+    frame_states.resize(num + 1);
     memset(&buffers[num], 0, sizeof(VideoFrame));
     buffers[num].interlaced_frame = -1;
     buffers[num].top_field_first  = 1;
-    vbufferMap[at(num)] = num;
     init(&buffers[num], fmt, (unsigned char*)data, width, height, 0);
     buffers[num].priv[0] = ffmpeg_hack;
     buffers[num].priv[1] = ffmpeg_hack;
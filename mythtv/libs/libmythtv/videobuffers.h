@@ -6,10 +6,12 @@
 extern "C" {
 #include "frame.h"
 }
+#include <stdint.h>
 #include <vector>
 #include <map>
 using namespace std;
 
+#include <QAtomicInt>
 #include <QMutex>
 #include <QString>
 #include <QWaitCondition>
@@ -23,8 +25,6 @@ class MythXDisplay;
 typedef MythDeque<VideoFrame*>                frame_queue_t;
 typedef vector<VideoFrame>                    frame_vector_t;
 typedef map<const unsigned char*, void*>      buffer_map_t;
-typedef map<const VideoFrame*, uint>          vbuffer_map_t;
-typedef map<const VideoFrame*, QMutex*>       frame_lock_map_t;
 typedef vector<unsigned char*>                uchar_vector_t;
 
 
@@ -45,6 +45,9 @@ enum BufferType
     kVideoBuffer_all       = 0x0000003F,
 };
 
+/// Number of BufferType queues, decode included
+static const uint kVideoBuffer_count = 7;
+
 class YUVInfo
 {
   public:
@@ -129,14 +132,39 @@ class VideoBuffers
                    VideoFrameType fmt);
 
     QString GetStatus(int n=-1) const; // debugging method
+    QString GetWaitStatus(void) const; // debugging method
+
   private:
+    /// Which queues a frame is in, and since when
+    class FrameState
+    {
+      public:
+        FrameState() : queues(0), decode_refs(0)
+            { memset(entered, 0, sizeof(entered)); }
+
+        QAtomicInt queues;       ///< BufferType bits, read without the lock
+        uint       decode_refs;  ///< times the frame is in the decode queue
+        int64_t    entered[kVideoBuffer_count]; ///< usecs, per queue
+    };
+
     frame_queue_t         *queue(BufferType type);
     const frame_queue_t   *queue(BufferType type) const;
     VideoFrame            *GetNextFreeFrameInternal(BufferType enqueue_to);
 
+    int                    Index(const VideoFrame *frame) const;
+    void                   Push(BufferType type, VideoFrame *frame,
+                                bool unique = true);
+    VideoFrame            *Pop(BufferType type);
+    void                   Drop(BufferType type, VideoFrame *frame);
+    void                   DropAll(BufferType type);
+    void                   Left(BufferType type, FrameState &fs, int64_t now);
+
     frame_queue_t          available, used, limbo, pause, displayed, decode, finished;
-    vbuffer_map_t          vbufferMap; // videobuffers to buffer's index
     frame_vector_t         buffers;
+    vector<FrameState>     frame_states; // parallel to buffers
+    QAtomicInt             queue_sizes[kVideoBuffer_count];
+    uint64_t               wait_usecs[kVideoBuffer_count];
+    uint                   wait_count[kVideoBuffer_count];
     uchar_vector_t         allocated_arrays;  // for DeleteBuffers
 
     uint                   needfreeframes;
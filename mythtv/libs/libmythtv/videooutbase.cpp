@@ -2,6 +2,7 @@
 #include <cstdlib>
 
 #include <QDesktopWidget>
+#include <QRunnable>
 
 #include "osd.h"
 #include "mythplayer.h"
@@ -52,11 +53,170 @@ extern "C" {
 }
 
 #include "filtermanager.h"
+#include "mthreadpool.h"
 
 #include "videooutbase.h"
 
 #define LOC QString("VideoOutput: ")
 
+/** \class PIPScaler
+ *  \brief Scales the frames of one PiP player on the VideoOutput's PiP pool.
+ *
+ *   The scaled frame is written into the back one of two buffers while the
+ *   display thread blits the front one, so a PiP is shown one frame late.
+ *   Each PiP keeps its own scaling context, so PiPs of different sizes no
+ *   longer tear down and rebuild a shared one on every frame.
+ */
+class PIPScaler : public QRunnable
+{
+  public:
+    PIPScaler(VideoOutput &parent, MythPlayer *player) :
+        m_parent(parent), m_player(player), m_context(NULL),
+        m_tmp_buf(NULL), m_active(false), m_back(0), m_scaled(false)
+    {
+        setAutoDelete(false);
+        m_buf[0] = m_buf[1] = NULL;
+        memset(&m_image, 0, sizeof(m_image));
+    }
+
+    ~PIPScaler()
+    {
+        if (m_context)
+            sws_freeContext(m_context);
+        delete [] m_tmp_buf;
+        delete [] m_buf[0];
+        delete [] m_buf[1];
+    }
+
+    /// Called on the display thread before the job is started
+    void Set(const QSize &size, bool active)
+    {
+        m_size   = size;
+        m_active = active;
+        m_scaled = false;
+    }
+
+    /// Called on the display thread once the job has finished, makes the
+    /// frame it scaled the one to blit, or clears it if there wasn't one.
+    void Swap(void)
+    {
+        if (!m_scaled)
+        {
+            memset(&m_image, 0, sizeof(m_image));
+            return;
+        }
+
+        init(&m_image, FMT_YV12, m_buf[m_back], m_size.width(),
+             m_size.height(), m_size.width() * m_size.height() * 3 / 2);
+        m_back ^= 1;
+    }
+
+    /// The last scaled frame, buf is NULL until there is one
+    const VideoFrame &Image(void) const { return m_image; }
+
+    void run(void)
+    {
+        int pipw, piph;
+        VideoFrame *pipimage = m_player->GetCurrentFrame(pipw, piph);
+
+        if (pipimage && pipimage->buf && pipimage->codec == FMT_YV12 &&
+            pipw > 0 && piph > 0 && !m_size.isEmpty())
+        {
+            m_scaled = Scale(pipimage->buf, pipw, piph);
+        }
+
+        // GetCurrentFrame() locks a mutex, so release it on this thread
+        m_player->ReleaseCurrentFrame(pipimage);
+        m_parent.PIPDone();
+    }
+
+  private:
+    bool Scale(unsigned char *src, int pipw, int piph)
+    {
+        int sz = m_size.width() * m_size.height() * 3 / 2;
+
+        // Only the back buffer may be reallocated, the front one may be
+        // being blitted while this runs.
+        if (m_buf_size[m_back] != m_size)
+        {
+            delete [] m_buf[m_back];
+            m_buf[m_back]      = new unsigned char[sz];
+            m_buf_size[m_back] = m_size;
+        }
+
+        unsigned char *out = m_buf[m_back];
+
+        if (pipw != m_size.width() || piph != m_size.height())
+        {
+            m_context = sws_getCachedContext(m_context, pipw, piph,
+                                             PIX_FMT_YUV420P, m_size.width(),
+                                             m_size.height(), PIX_FMT_YUV420P,
+                                             SWS_FAST_BILINEAR,
+                                             NULL, NULL, NULL);
+            if (!m_context)
+                return false;
+
+            if (m_active)
+            {
+                if (m_tmp_size != m_size)
+                {
+                    delete [] m_tmp_buf;
+                    m_tmp_buf  = new unsigned char[sz];
+                    m_tmp_size = m_size;
+                }
+                out = m_tmp_buf;
+            }
+
+            AVPicture img_in, img_out;
+            avpicture_fill(&img_out, (uint8_t *)out, PIX_FMT_YUV420P,
+                           m_size.width(), m_size.height());
+            avpicture_fill(&img_in, (uint8_t *)src, PIX_FMT_YUV420P,
+                           pipw, piph);
+
+            sws_scale(m_context, img_in.data, img_in.linesize, 0,
+                      piph, img_out.data, img_out.linesize);
+        }
+        else if (m_active)
+        {
+            out = src;
+        }
+        else
+        {
+            memcpy(out, src, sz);
+            return true;
+        }
+
+        if (m_active)
+        {
+            AVPicture img_in, img_padded;
+            avpicture_fill(&img_in, (uint8_t *)out, PIX_FMT_YUV420P,
+                           m_size.width(), m_size.height());
+            avpicture_fill(&img_padded, (uint8_t *)m_buf[m_back],
+                           PIX_FMT_YUV420P, m_size.width(), m_size.height());
+
+            int color[3] = { 20, 0, 200 }; //deep red YUV format
+            av_picture_pad(&img_padded, &img_in,
+                           m_size.height(), m_size.width(),
+                           PIX_FMT_YUV420P, 10, 10, 10, 10, color);
+        }
+
+        return true;
+    }
+
+    VideoOutput        &m_parent;
+    MythPlayer         *m_player;
+    struct SwsContext  *m_context;
+    unsigned char      *m_tmp_buf;
+    QSize               m_tmp_size;
+    unsigned char      *m_buf[2];
+    QSize               m_buf_size[2];
+    QSize               m_size;
+    bool                m_active;
+    int                 m_back;
+    bool                m_scaled;
+    VideoFrame          m_image;
+};
+
 static QString to_comma_list(const QStringList &list);
 
 void VideoOutput::GetRenderOptions(render_opts &opts)
@@ -387,10 +547,7 @@ VideoOutput::VideoOutput() :
     video_codec_id(kCodec_NONE),        db_vdisp_profile(NULL),
 
     // Picture-in-Picture stuff
-    pip_desired_display_size(160,128),  pip_display_size(0,0),
-    pip_video_size(0,0),
-    pip_tmp_buf(NULL),                  pip_tmp_buf2(NULL),
-    pip_scaling_context(NULL),
+    pip_pool(NULL),                     pip_jobs(0),
 
     // Video resizing (for ITV)
     vsz_enabled(false),
@@ -421,7 +578,6 @@ VideoOutput::VideoOutput() :
     // 3D TV
     m_stereo(kStereoscopicModeNone)
 {
-    memset(&pip_tmp_image, 0, sizeof(pip_tmp_image));
     db_display_dim = QSize(gCoreContext->GetNumSetting("DisplaySizeWidth",  0),
                            gCoreContext->GetNumSetting("DisplaySizeHeight", 0));
 
@@ -966,68 +1122,72 @@ QRect VideoOutput::GetPIPRect(
 }
 
 /**
- * \fn VideoOutput::DoPipResize(int,int)
- * \brief Sets up Picture in Picture image resampler.
- * \param pipwidth  input width
- * \param pipheight input height
- * \sa ShutdownPipResize(), ShowPIPs(VideoFrame*,const PIPMap&)
+ * \fn VideoOutput::RemovePIP(MythPlayer*)
+ * \brief Drops the scaler of a PiP player which is going away.
  */
-void VideoOutput::DoPipResize(int pipwidth, int pipheight)
+void VideoOutput::RemovePIP(MythPlayer *pipplayer)
 {
-    QSize vid_size = QSize(pipwidth, pipheight);
-    if (vid_size == pip_desired_display_size)
-        return;
-
-    ShutdownPipResize();
+    WaitForPIPs();
 
-    pip_video_size   = vid_size;
-    pip_display_size = pip_desired_display_size;
+    QMap<MythPlayer*,PIPScaler*>::iterator it = pip_scalers.find(pipplayer);
+    if (it != pip_scalers.end())
+    {
+        delete *it;
+        pip_scalers.erase(it);
+    }
+}
 
-    int sz = pip_display_size.height() * pip_display_size.width() * 3 / 2;
-    pip_tmp_buf = new unsigned char[sz];
-    pip_tmp_buf2 = new unsigned char[sz];
+/**
+ * \fn VideoOutput::WaitForPIPs()
+ * \brief Waits for the PiP frames being scaled on the PiP pool.
+ */
+void VideoOutput::WaitForPIPs(void)
+{
+    QMutexLocker locker(&pip_lock);
+    while (pip_jobs > 0)
+        pip_wait.wait(&pip_lock);
+}
 
-    pip_scaling_context = sws_getCachedContext(pip_scaling_context,
-                              pip_video_size.width(), pip_video_size.height(),
-                              PIX_FMT_YUV420P,
-                              pip_display_size.width(),
-                              pip_display_size.height(),
-                              PIX_FMT_YUV420P, SWS_FAST_BILINEAR,
-                              NULL, NULL, NULL);
+void VideoOutput::PIPDone(void)
+{
+    QMutexLocker locker(&pip_lock);
+    if (--pip_jobs <= 0)
+        pip_wait.wakeAll();
 }
 
 /**
  * \fn VideoOutput::ShutdownPipResize()
- * \brief Shuts down Picture in Picture image resampler.
- * \sa VideoOutput::DoPipResize(int,int),
- *     ShowPIPs(VideoFrame*,const PIPMap&)
+ * \brief Shuts down the Picture in Picture image resamplers.
+ * \sa ShowPIPs(VideoFrame*,const PIPMap&)
  */
 void VideoOutput::ShutdownPipResize(void)
 {
-    if (pip_tmp_buf)
-    {
-        delete [] pip_tmp_buf;
-        pip_tmp_buf   = NULL;
-    }
+    WaitForPIPs();
 
-    if (pip_tmp_buf2)
+    if (pip_pool)
     {
-        delete [] pip_tmp_buf2;
-        pip_tmp_buf2 = NULL;
+        pip_pool->waitForDone();
+        delete pip_pool;
+        pip_pool = NULL;
     }
 
-    if (pip_scaling_context)
-    {
-        sws_freeContext(pip_scaling_context);
-        pip_scaling_context = NULL;
-    }
-
-    pip_video_size   = QSize(0,0);
-    pip_display_size = QSize(0,0);
+    QMap<MythPlayer*,PIPScaler*>::iterator it = pip_scalers.begin();
+    for (; it != pip_scalers.end(); ++it)
+        delete *it;
+    pip_scalers.clear();
 }
 
+/**
+ * \fn VideoOutput::ShowPIPs(VideoFrame*,const PIPMap&)
+ * \brief Composites the PiP images onto a video frame.
+ *
+ *  The frames scaled for the previous video frame are waited for first,
+ *  ShowPIP() then starts scaling the next ones before it blits them.
+ */
 void VideoOutput::ShowPIPs(VideoFrame *frame, const PIPMap &pipPlayers)
 {
+    WaitForPIPs();
+
     PIPMap::const_iterator it = pipPlayers.begin();
     for (; it != pipPlayers.end(); ++it)
         ShowPIP(frame, it.key(), *it);
@@ -1037,6 +1197,9 @@ void VideoOutput::ShowPIPs(VideoFrame *frame, const PIPMap &pipPlayers)
  * \fn VideoOutput::ShowPIP(VideoFrame*,MythPlayer*,PIPLocation)
  * \brief Composites PiP image onto a video frame.
  *
+ *  The PiP frame is scaled on the PiP pool while the previously scaled
+ *  one is blitted, so only the copy is done on the display thread.
+ *
  *  Note: This only works with memory backed VideoFrames.
  *
  * \param frame     Frame to composite PiP onto.
@@ -1051,84 +1214,48 @@ void VideoOutput::ShowPIP(VideoFrame  *frame,
         return;
 
     const float video_aspect           = window.GetVideoAspect();
-//     const QRect display_video_rect     = window.GetDisplayVideoRect();
-//     const QRect video_rect             = window.GetVideoRect();
-//     const QRect display_visible_rect   = window.GetDisplayVisibleRect();
-//     const QSize video_disp_dim         = window.GetVideoDispDim();
-
-    int pipw, piph;
-    VideoFrame *pipimage       = pipplayer->GetCurrentFrame(pipw, piph);
     const bool  pipActive      = pipplayer->IsPIPActive();
     const bool  pipVisible     = pipplayer->IsPIPVisible();
     const float pipVideoAspect = pipplayer->GetVideoAspect();
-//     const QSize pipVideoDim    = pipplayer->GetVideoBufferSize();
 
     // If PiP is not initialized to values we like, silently ignore the frame.
     if ((video_aspect <= 0) || (pipVideoAspect <= 0) ||
-        (frame->height <= 0) || (frame->width <= 0) ||
-        !pipimage || !pipimage->buf || pipimage->codec != FMT_YV12)
+        (frame->height <= 0) || (frame->width <= 0) || !pipVisible)
     {
-        pipplayer->ReleaseCurrentFrame(pipimage);
-        return;
-    }
-
-    if (!pipVisible)
-    {
-        pipplayer->ReleaseCurrentFrame(pipimage);
         return;
     }
 
     QRect position = GetPIPRect(loc, pipplayer);
-    pip_desired_display_size = position.size();
 
-    // Scale the image if we have to...
-    unsigned char *pipbuf = pipimage->buf;
-    if (pipw != pip_desired_display_size.width() ||
-        piph != pip_desired_display_size.height())
+    if (!pip_pool)
     {
-        DoPipResize(pipw, piph);
-
-        memset(&pip_tmp_image, 0, sizeof(pip_tmp_image));
+        pip_pool = new MThreadPool("PIPScaler");
+        pip_pool->setMaxThreadCount(kPIP_END);
+    }
 
-        if (pip_tmp_buf && pip_scaling_context)
-        {
-            AVPicture img_in, img_out;
+    PIPScaler *scaler = pip_scalers.value(pipplayer);
+    if (!scaler)
+    {
+        scaler = new PIPScaler(*this, pipplayer);
+        pip_scalers[pipplayer] = scaler;
+    }
 
-            avpicture_fill(
-                &img_out, (uint8_t *)pip_tmp_buf, PIX_FMT_YUV420P,
-                pip_display_size.width(), pip_display_size.height());
+    // Show the frame scaled last time, and start scaling the next one
+    scaler->Swap();
+    VideoFrame pip_image = scaler->Image();
 
-            avpicture_fill(&img_in, (uint8_t *)pipimage->buf, PIX_FMT_YUV420P,
-                           pipw, piph);
+    pip_lock.lock();
+    pip_jobs++;
+    pip_lock.unlock();
 
-            sws_scale(pip_scaling_context, img_in.data, img_in.linesize, 0,
-                      piph, img_out.data, img_out.linesize);
+    scaler->Set(position.size(), pipActive);
+    pip_pool->start(scaler, "PIPScaler");
 
-            if (pipActive)
-            {
-                AVPicture img_padded;
-                avpicture_fill(
-                    &img_padded, (uint8_t *)pip_tmp_buf2, PIX_FMT_YUV420P,
-                    pip_display_size.width(), pip_display_size.height());
-
-                int color[3] = { 20, 0, 200 }; //deep red YUV format
-                av_picture_pad(&img_padded, &img_out,
-                               pip_display_size.height(),
-                               pip_display_size.width(),
-                               PIX_FMT_YUV420P, 10, 10, 10, 10, color);
-
-                pipbuf = pip_tmp_buf2;
-            }
-            else
-            {
-                pipbuf = pip_tmp_buf;
-            }
-
-            pipw = pip_display_size.width();
-            piph = pip_display_size.height();
-
-            init(&pip_tmp_image, FMT_YV12, pipbuf, pipw, piph, sizeof(*pipbuf));
-        }
+    // Skip a frame scaled for a PiP of another size, it may not fit
+    if (!pip_image.buf || pip_image.width != position.width() ||
+        pip_image.height != position.height())
+    {
+        return;
     }
 
     int xoff = position.left();
@@ -1136,7 +1263,7 @@ void VideoOutput::ShowPIP(VideoFrame  *frame,
     uint xoff2[3]  = { xoff, xoff>>1, xoff>>1 };
     uint yoff2[3]  = { yoff, yoff>>1, yoff>>1 };
 
-    uint pip_height = pip_tmp_image.height;
+    uint pip_height = pip_image.height;
     uint height[3] = { pip_height, pip_height>>1, pip_height>>1 };
 
     for (int p = 0; p < 3; p++)
@@ -1145,13 +1272,10 @@ void VideoOutput::ShowPIP(VideoFrame  *frame,
         {
             memcpy((frame->buf + frame->offsets[p]) + (h + yoff2[p]) *
                    frame->pitches[p] + xoff2[p],
-                   (pip_tmp_image.buf + pip_tmp_image.offsets[p]) + h *
-                   pip_tmp_image.pitches[p], pip_tmp_image.pitches[p]);
+                   (pip_image.buf + pip_image.offsets[p]) + h *
+                   pip_image.pitches[p], pip_image.pitches[p]);
         }
     }
-
-    // we're done with the frame, release it
-    pipplayer->ReleaseCurrentFrame(pipimage);
 }
 
 /**
@@ -1357,6 +1481,7 @@ bool VideoOutput::DisplayOSD(VideoFrame *frame, OSD *osd)
         LOG(VB_PLAYBACK, LOG_INFO, LOC + QString("OSD size changed."));
         osd_image->DecrRef();
         osd_image = NULL;
+        osd_opaque = QRegion();
     }
 
     if (!osd_image)
@@ -1390,6 +1515,24 @@ bool VideoOutput::DisplayOSD(VideoFrame *frame, OSD *osd)
     bool changed    = !dirty.isEmpty();
     bool show       = !visible.isEmpty();
 
+    // Only the parts of the OSD that were redrawn can have changed
+    // their transparency, so rescan just the tiles touching those.
+    if (changed)
+    {
+        QRegion rescan;
+        QVector<QRect> rects = dirty.rects();
+        for (int i = 0; i < rects.size(); i++)
+        {
+            int left   = rects[i].left() & ~(OSD_TILE - 1);
+            int top    = rects[i].top()  & ~(OSD_TILE - 1);
+            int right  = (rects[i].right()  + OSD_TILE) & ~(OSD_TILE - 1);
+            int bottom = (rects[i].bottom() + OSD_TILE) & ~(OSD_TILE - 1);
+            rescan += QRect(left, top, right - left, bottom - top);
+        }
+        osd_opaque = osd_opaque.subtracted(rescan);
+        osd_opaque = osd_opaque.united(osd_coverage(osd_image, rescan));
+    }
+
     if (!show)
         return show;
 
@@ -1398,6 +1541,13 @@ bool VideoOutput::DisplayOSD(VideoFrame *frame, OSD *osd)
 
     QSize video_dim = window.GetVideoDim();
 
+    // Skip the parts of the visible OSD that hold nothing. Besides the
+    // work this saves, blending a clear pixel is not a no-op: it scales
+    // the frame by 255/256 and darkens it by one. The IA44/AI44 surfaces
+    // are cleared and redrawn on change, so they still need every rect.
+    if (FMT_YV12 == frame->codec)
+        visible = visible.intersected(osd_opaque);
+
     QVector<QRect> vis = visible.rects();
     for (int i = 0; i < vis.size(); i++)
     {
@@ -13,6 +13,9 @@ extern "C" {
 #include <QString>
 #include <QPoint>
 #include <QMap>
+#include <QRegion>
+#include <QMutex>
+#include <QWaitCondition>
 #include <qwindowdefs.h>
 
 #include "videobuffers.h"
@@ -36,6 +39,8 @@ class FilterChain;
 class FilterManager;
 class AudioPlayer;
 class MythRender;
+class MThreadPool;
+class PIPScaler;
 
 typedef QMap<MythPlayer*,PIPLocation> PIPMap;
 
@@ -46,6 +51,8 @@ struct SwsContext;
 
 class VideoOutput
 {
+    friend class PIPScaler;
+
   public:
     static void GetRenderOptions(render_opts &opts);
     static VideoOutput *Create(
@@ -218,6 +225,9 @@ class VideoOutput
 
     /// \brief Returns string with status of each frame for debugging.
     QString GetFrameStatus(void) const { return vbuffers.GetStatus(); }
+    /// \brief Returns the average time frames spent in each state.
+    QString GetFrameWaitStatus(void) const
+        { return vbuffers.GetWaitStatus(); }
 
     /// \brief Updates frame displayed when video is paused.
     virtual void UpdatePauseFrame(int64_t &disp_timecode) = 0;
@@ -237,7 +247,7 @@ class VideoOutput
     virtual QRect GetPIPRect(PIPLocation location,
                              MythPlayer *pipplayer = NULL,
                              bool do_pixel_adj = true) const;
-    virtual void RemovePIP(MythPlayer *pipplayer) { }
+    virtual void RemovePIP(MythPlayer *pipplayer);
 
     virtual void SetPIPState(PIPState setting);
 
@@ -288,7 +298,8 @@ class VideoOutput
 
     static void CopyFrame(VideoFrame* to, const VideoFrame* from);
 
-    void DoPipResize(int pipwidth, int pipheight);
+    void WaitForPIPs(void);
+    void PIPDone(void);
     void ShutdownPipResize(void);
 
     void ResizeVideo(VideoFrame *frame);
@@ -308,13 +319,11 @@ class VideoOutput
     VideoDisplayProfile *db_vdisp_profile;
 
     // Picture-in-Picture
-    QSize   pip_desired_display_size;
-    QSize   pip_display_size;
-    QSize   pip_video_size;
-    unsigned char      *pip_tmp_buf;
-    unsigned char      *pip_tmp_buf2;
-    struct SwsContext  *pip_scaling_context;
-    VideoFrame pip_tmp_image;
+    MThreadPool        *pip_pool;
+    QMap<MythPlayer*,PIPScaler*> pip_scalers;
+    QMutex              pip_lock;
+    QWaitCondition      pip_wait;
+    int                 pip_jobs;
 
     // Video resizing (for ITV)
     bool    vsz_enabled;
@@ -348,6 +357,7 @@ class VideoOutput
     // OSD painter and surface
     MythYUVAPainter *osd_painter;
     MythImage       *osd_image;
+    QRegion          osd_opaque; ///< tiles of osd_image that are not clear
 
     // Visualisation
     VideoVisual     *m_visual;
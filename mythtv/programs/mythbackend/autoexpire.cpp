@@ -40,6 +40,7 @@ using namespace std;
 #include "mainserver.h"
 #include "compat.h"
 #include "mythlogging.h"
+#include "mythtimer.h"
 
 #define LOC     QString("AutoExpire: ")
 #define LOC_ERR QString("AutoExpire Error: ")
@@ -51,6 +52,11 @@ extern AutoExpire *expirer;
  */
 #define SPACE_TOO_BIG_KB 3*1024*1024
 
+/** The expire queues are reloaded from the database this often (in seconds)
+ *  in case a change to the recorded table was not announced by an event.
+ */
+#define EXPIRE_QUEUE_RELOAD_SECS 60*60
+
 /// \brief This calls AutoExpire::RunExpirer() from within a new thread.
 void ExpireThread::run(void)
 {
@@ -83,7 +89,11 @@ AutoExpire::AutoExpire(QMap<int, EncoderLink *> *tvList) :
     expire_thread_run(true),
     main_server(NULL),
     update_pending(false),
-    update_thread(NULL)
+    update_thread(NULL),
+    expire_method(0),
+    expire_watched_first(false),
+    expire_day_priority(0),
+    queue_reload(false)
 {
     expire_thread->start();
     gCoreContext->addListener(this);
@@ -99,7 +109,11 @@ AutoExpire::AutoExpire() :
     expire_thread_run(false),
     main_server(NULL),
     update_pending(false),
-    update_thread(NULL)
+    update_thread(NULL),
+    expire_method(0),
+    expire_watched_first(false),
+    expire_day_priority(0),
+    queue_reload(false)
 {
 }
 
@@ -406,7 +420,6 @@ void AutoExpire::ExpireQuickDeleted(void)
  */
 void AutoExpire::ExpireRecordings(void)
 {
-    pginfolist_t expireList;
     pginfolist_t deleteList;
     QList<FileSystemInfo> fsInfos;
     QList<FileSystemInfo>::iterator fsit;
@@ -424,7 +437,8 @@ void AutoExpire::ExpireRecordings(void)
         return;
     }
 
-    FillExpireList(expireList);
+    UpdateExpireQueues();
+    bool located = false;
 
     QMap <int, bool> truncateMap;
     MSqlQuery query(MSqlQuery::InitCon());
@@ -532,86 +546,416 @@ void AutoExpire::ExpireRecordings(void)
 
             LOG(VB_FILE, LOG_INFO,
                 "    Searching for files expirable in these directories");
-            QString myHostName = gCoreContext->GetHostName();
-            pginfolist_t::iterator it = expireList.begin();
-            while ((it != expireList.end()) &&
-                   (max((int64_t)0LL, fsit->getFreeSpace()) <
-                    desired_space[fsit->getFSysID()]))
+
+            // Find the directories of recordings not seen before, this is
+            // only done once for each recording.
+            if (!located)
             {
-                ProgramInfo *p = *it;
-                ++it;
+                LocateExpireCandidates();
+                located = true;
+            }
 
-                LOG(VB_FILE, LOG_INFO, QString("        Checking %1 => %2")
-                        .arg(p->toString(ProgramInfo::kRecordingKey))
-                        .arg(p->GetTitle()));
+            // Walk the queues of this filesystem's directories in order
+            vector<expire_queue_t::const_iterator> heads;
+            vector<expire_queue_t::const_iterator> ends;
+            QMap<QString, int>::const_iterator dit = dirList.begin();
+            for (; dit != dirList.end(); ++dit)
+            {
+                QMap<QString, expire_queue_t>::const_iterator qit =
+                    expire_queues.find(dit.key());
+                if (qit == expire_queues.end())
+                    continue;
+                heads.push_back((*qit).begin());
+                ends.push_back((*qit).end());
+            }
+
+            bool expireAll = (expire_method == emOldestFirst) ||
+                             (expire_method == emLowestPriorityFirst) ||
+                             (expire_method == emWeightedTimePriority);
 
-                if (!p->IsLocal())
+            while (max((int64_t)0LL, fsit->getFreeSpace()) <
+                   desired_space[fsit->getFSysID()])
+            {
+                int next = -1;
+                for (uint i = 0; i < heads.size(); ++i)
                 {
-                    bool foundFile = false;
-                    QMap<int, EncoderLink *>::Iterator eit =
-                         encoderList->begin();
-                    while (eit != encoderList->end())
+                    if ((heads[i] != ends[i]) &&
+                        ((next < 0) || (*heads[i] < *heads[next])))
                     {
-                        EncoderLink *el = *eit;
-                        eit++;
-
-                        if ((p->GetHostname() == el->GetHostName()) ||
-                            ((p->GetHostname() == myHostName) &&
-                             (el->IsLocal())))
-                        {
-                            if (el->IsConnected())
-                                foundFile = el->CheckFile(p);
-
-                            eit = encoderList->end();
-                        }
+                        next = i;
                     }
+                }
+                if (next < 0)
+                    break;
 
-                    if (!foundFile && (p->GetHostname() != myHostName))
-                    {
-                        // Wasn't found so check locally
-                        QString file = GetPlaybackURL(p);
-
-                        if (file.left(1) == "/")
-                        {
-                            p->SetPathname(file);
-                            p->SetHostname(myHostName);
-                            foundFile = true;
-                        }
-                    }
+                const ExpireEntry &entry = *heads[next];
+                ++heads[next];
 
-                    if (!foundFile)
-                    {
-                        LOG(VB_FILE, LOG_ERR, LOC +
-                            QString("        ERROR: Can't find file for %1")
-                                .arg(p->toString(ProgramInfo::kRecordingKey)));
-                        continue;
-                    }
+                // Without a valid expire method only deleted programs expire
+                if (!entry.deleted && !expireAll)
+                    continue;
+
+                QMap<QString, ExpireCandidate>::const_iterator cit =
+                    expire_candidates.find(entry.key);
+                if (cit == expire_candidates.end())
+                    continue;
+
+                if (IsInDontExpireSet((*cit).chanid, (*cit).recstartts))
+                {
+                    LOG(VB_FILE, LOG_INFO, LOC +
+                        QString("    Skipping %1 because it is in Don't "
+                                "Expire List").arg(entry.key));
+                    continue;
                 }
 
-                QFileInfo vidFile(p->GetPathname());
-                if (dirList.contains(p->GetHostname() + ':' + vidFile.path()))
+                ProgramInfo *p = new ProgramInfo((*cit).chanid,
+                                                 (*cit).recstartts);
+                if (!p->GetChanID() || p->IsDeletePending() ||
+                    (!p->IsAutoExpirable() &&
+                     (p->GetRecordingGroup() != "Deleted")))
                 {
-                    fsit->setUsedSpace(fsit->getUsedSpace()
-                                                - (p->GetFilesize() / 1024));
-                    deleteList.push_back(p);
-
-                    LOG(VB_FILE, LOG_INFO,
-                        QString("        FOUND file expirable. "
-                                "%1 is located at %2 which is on fsID #%3. "
-                                "Adding to deleteList.  After deleting we "
-                                "should have %4 MB free on this filesystem.")
-                            .arg(p->toString(ProgramInfo::kRecordingKey))
-                            .arg(p->GetPathname()).arg(fsit->getFSysID())
-                            .arg(fsit->getFreeSpace() / 1024));
+                    LOG(VB_FILE, LOG_INFO, LOC +
+                        QString("    Skipping %1 because it is no longer "
+                                "expirable").arg(entry.key));
+                    delete p;
+
+                    QMutexLocker qlocker(&queue_lock);
+                    queue_changed.insert(entry.key);
+                    continue;
                 }
+
+                LOG(VB_FILE, LOG_INFO, QString("        Checking %1 => %2")
+                        .arg(p->toString(ProgramInfo::kRecordingKey))
+                        .arg(p->GetTitle()));
+
+                fsit->setUsedSpace(fsit->getUsedSpace()
+                                            - (p->GetFilesize() / 1024));
+                deleteList.push_back(p);
+
+                LOG(VB_FILE, LOG_INFO,
+                    QString("        FOUND file expirable. "
+                            "%1 is located at %2 which is on fsID #%3. "
+                            "Adding to deleteList.  After deleting we "
+                            "should have %4 MB free on this filesystem.")
+                        .arg(p->toString(ProgramInfo::kRecordingKey))
+                        .arg((*cit).location).arg(fsit->getFSysID())
+                        .arg(fsit->getFreeSpace() / 1024));
             }
         }
     }
 
     SendDeleteMessages(deleteList);
 
-    ClearExpireList(deleteList, false);
-    ClearExpireList(expireList);
+    ClearExpireList(deleteList);
+}
+
+/** \fn AutoExpire::FindRecordingFile(ProgramInfo*)
+ *  \brief Sets the full path of the recording's file, asking the backend
+ *         holding it when it is not local.
+ *  \return true if the file was found
+ */
+bool AutoExpire::FindRecordingFile(ProgramInfo *p)
+{
+    if (p->IsLocal())
+        return true;
+
+    QString myHostName = gCoreContext->GetHostName();
+    bool foundFile = false;
+    QMap<int, EncoderLink *>::Iterator eit = encoderList->begin();
+    while (eit != encoderList->end())
+    {
+        EncoderLink *el = *eit;
+        eit++;
+
+        if ((p->GetHostname() == el->GetHostName()) ||
+            ((p->GetHostname() == myHostName) &&
+             (el->IsLocal())))
+        {
+            if (el->IsConnected())
+                foundFile = el->CheckFile(p);
+
+            eit = encoderList->end();
+        }
+    }
+
+    if (!foundFile && (p->GetHostname() != myHostName))
+    {
+        // Wasn't found so check locally
+        QString file = GetPlaybackURL(p);
+
+        if (file.left(1) == "/")
+        {
+            p->SetPathname(file);
+            p->SetHostname(myHostName);
+            foundFile = true;
+        }
+    }
+
+    if (!foundFile)
+    {
+        LOG(VB_FILE, LOG_ERR, LOC +
+            QString("        ERROR: Can't find file for %1")
+                .arg(p->toString(ProgramInfo::kRecordingKey)));
+    }
+
+    return foundFile;
+}
+
+/** \fn AutoExpire::UpdateExpireQueues(void)
+ *  \brief Brings the expire queues up to date with the recorded table.
+ *
+ *   The queues are loaded once and afterwards only the recordings named
+ *   by RECORDING_LIST_CHANGE and MASTER_UPDATE_PROG_INFO events are loaded
+ *   again. Everything is reloaded when the expire method settings change,
+ *   on a RECORDING_LIST_CHANGE naming no recording, and once an hour.
+ */
+void AutoExpire::UpdateExpireQueues(void)
+{
+    int method  = gCoreContext->GetNumSetting("AutoExpireMethod", 1);
+    bool watchedFirst =
+        gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0);
+    int dayPriority = gCoreContext->GetNumSetting("AutoExpireDayPriority", 3);
+
+    QSet<QString> changed;
+    bool reload;
+    {
+        QMutexLocker locker(&queue_lock);
+        changed = queue_changed;
+        queue_changed.clear();
+        reload = queue_reload;
+        queue_reload = false;
+    }
+
+    QDateTime now = MythDate::current();
+    if (!expire_loaded.isValid() ||
+        (expire_loaded.secsTo(now) > EXPIRE_QUEUE_RELOAD_SECS) ||
+        (method != expire_method) ||
+        (watchedFirst != expire_watched_first) ||
+        (dayPriority != expire_day_priority))
+    {
+        reload = true;
+    }
+
+    expire_method        = method;
+    expire_watched_first = watchedFirst;
+    expire_day_priority  = dayPriority;
+
+    if (reload)
+    {
+        MythTimer t;
+        t.start();
+
+        LoadExpireCandidates();
+        expire_loaded = now;
+
+        LOG(VB_FILE, LOG_INFO, LOC +
+            QString("Loaded %1 expirable recordings in %2 ms")
+                .arg(expire_candidates.size()).arg(t.elapsed()));
+        return;
+    }
+
+    QSet<QString>::const_iterator it = changed.begin();
+    for (; it != changed.end(); ++it)
+        LoadExpireCandidates(*it);
+}
+
+/** \fn AutoExpire::LoadExpireCandidates(const QString&)
+ *  \brief Loads one recording, or all when key is empty, into the expire
+ *         queues. The file locations already found are kept.
+ */
+void AutoExpire::LoadExpireCandidates(const QString &key)
+{
+    QMap<QString, QString> locations;
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    QString querystr =
+        "SELECT chanid, starttime, recgroup, autoexpire, watched, "
+        "       recpriority, lastmodified "
+        "FROM recorded "
+        "WHERE (autoexpire > 0 OR recgroup = 'Deleted') AND "
+        "      deletepending = 0 ";
+
+    if (key.isEmpty())
+    {
+        QMap<QString, ExpireCandidate>::const_iterator it;
+        for (it = expire_candidates.begin();
+             it != expire_candidates.end(); ++it)
+        {
+            if (!(*it).location.isEmpty())
+                locations[it.key()] = (*it).location;
+        }
+        expire_candidates.clear();
+        expire_queues.clear();
+
+        query.prepare(querystr);
+    }
+    else
+    {
+        QMap<QString, ExpireCandidate>::const_iterator it =
+            expire_candidates.find(key);
+        if (it != expire_candidates.end() && !(*it).location.isEmpty())
+            locations[key] = (*it).location;
+        RemoveFromExpireQueue(key);
+
+        query.prepare(querystr + "AND chanid = :CHANID AND "
+                      "starttime = :STARTTIME");
+        query.bindValue(":CHANID", key.section('_', 0, 0).toUInt());
+        query.bindValue(":STARTTIME",
+                        MythDate::fromString(key.section('_', 1)));
+    }
+
+    if (!query.exec())
+    {
+        MythDB::DBError(LOC + "LoadExpireCandidates", query);
+        return;
+    }
+
+    while (query.next())
+    {
+        ExpireCandidate candidate;
+        candidate.chanid     = query.value(0).toUInt();
+        candidate.recstartts = MythDate::as_utc(query.value(1).toDateTime());
+
+        ExpireEntry &entry = candidate.entry;
+        entry.key = ProgramInfo::MakeUniqueKey(candidate.chanid,
+                                               candidate.recstartts);
+        entry.autoexpire = query.value(3).toInt();
+        candidate.location = locations.value(entry.key);
+
+        if (query.value(2).toString() == "Deleted")
+        {
+            entry.deleted = 1;
+            entry.primary =
+                MythDate::as_utc(query.value(6).toDateTime()).toTime_t();
+        }
+        else
+        {
+            int64_t starttime = candidate.recstartts.toTime_t();
+            int priority = query.value(5).toInt();
+
+            if (expire_watched_first)
+                entry.watched = query.value(4).toInt();
+
+            switch (expire_method)
+            {
+                case emLowestPriorityFirst:
+                    entry.primary   = priority;
+                    entry.secondary = starttime;
+                    break;
+                case emWeightedTimePriority:
+                    entry.primary = starttime +
+                        (int64_t)expire_day_priority * priority * 24 * 60 * 60;
+                    break;
+                default:
+                    entry.primary = starttime;
+                    break;
+            }
+        }
+
+        AddToExpireQueue(candidate);
+    }
+}
+
+void AutoExpire::AddToExpireQueue(const ExpireCandidate &candidate)
+{
+    expire_candidates[candidate.entry.key] = candidate;
+    expire_queues[candidate.location].insert(candidate.entry);
+}
+
+void AutoExpire::RemoveFromExpireQueue(const QString &key)
+{
+    QMap<QString, ExpireCandidate>::iterator it = expire_candidates.find(key);
+    if (it == expire_candidates.end())
+        return;
+
+    QMap<QString, expire_queue_t>::iterator qit =
+        expire_queues.find((*it).location);
+    if (qit != expire_queues.end())
+    {
+        (*qit).erase((*it).entry);
+        if ((*qit).empty())
+            expire_queues.erase(qit);
+    }
+
+    expire_candidates.erase(it);
+}
+
+/** \fn AutoExpire::LocateExpireCandidates(void)
+ *  \brief Finds the directory of each queued recording whose file has not
+ *         been looked for yet and moves it to the queue of that directory.
+ */
+void AutoExpire::LocateExpireCandidates(void)
+{
+    QMap<QString, expire_queue_t>::const_iterator qit = expire_queues.find("");
+    if (qit == expire_queues.end())
+        return;
+
+    MythTimer t;
+    t.start();
+
+    // copied since the candidates found are moved out of this queue
+    expire_queue_t unlocated = *qit;
+    uint found = 0;
+
+    expire_queue_t::const_iterator it = unlocated.begin();
+    for (; it != unlocated.end(); ++it)
+    {
+        ExpireCandidate candidate = expire_candidates.value((*it).key);
+
+        ProgramInfo pginfo(candidate.chanid, candidate.recstartts);
+        if (!pginfo.GetChanID() || !FindRecordingFile(&pginfo))
+            continue;
+
+        RemoveFromExpireQueue((*it).key);
+        candidate.location = pginfo.GetHostname() + ':' +
+            QFileInfo(pginfo.GetPathname()).path();
+        AddToExpireQueue(candidate);
+        found++;
+    }
+
+    LOG(VB_FILE, LOG_INFO, LOC +
+        QString("Found the files of %1 of %2 recordings in %3 ms")
+            .arg(found).arg(unlocated.size()).arg(t.elapsed()));
+}
+
+/** \fn AutoExpire::customEvent(QEvent*)
+ *  \brief Notes the recordings that changed so the expire queues can be
+ *         updated on the next expire run.
+ */
+void AutoExpire::customEvent(QEvent *event)
+{
+    if ((MythEvent::Type)(event->type()) != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = (MythEvent *)event;
+    QStringList tokens = me->Message().simplified().split(" ");
+
+    if (tokens[0] == "RECORDING_LIST_CHANGE")
+    {
+        QMutexLocker locker(&queue_lock);
+        if ((tokens.size() >= 4) &&
+            ((tokens[1] == "ADD") || (tokens[1] == "DELETE")))
+        {
+            queue_changed.insert(ProgramInfo::MakeUniqueKey(
+                tokens[2].toUInt(), MythDate::fromString(tokens[3])));
+        }
+        else if ((tokens.size() >= 2) && (tokens[1] == "UPDATE"))
+        {
+            ProgramInfo pginfo(me->ExtraDataList());
+            if (pginfo.GetChanID())
+                queue_changed.insert(pginfo.MakeUniqueKey());
+        }
+        else
+        {
+            queue_reload = true;
+        }
+    }
+    else if ((tokens[0] == "MASTER_UPDATE_PROG_INFO") && (tokens.size() >= 3))
+    {
+        QMutexLocker locker(&queue_lock);
+        queue_changed.insert(ProgramInfo::MakeUniqueKey(
+            tokens[1].toUInt(), MythDate::fromString(tokens[2])));
+    }
 }
 
 /**
@@ -989,6 +1333,12 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
     if (!query.exec())
         return;
 
+    // lets the programs already in the list be skipped without a search
+    QSet<QString> listed;
+    pginfolist_t::const_iterator it = expireList.begin();
+    for (; it != expireList.end(); ++it)
+        listed.insert((*it)->MakeUniqueKey());
+
     while (query.next())
     {
         uint chanid = query.value(0).toUInt();
@@ -1001,7 +1351,8 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
                         "List")
                     .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
         }
-        else if (IsInExpireList(expireList, chanid, recstartts))
+        else if (listed.contains(
+                     ProgramInfo::MakeUniqueKey(chanid, recstartts)))
         {
             LOG(VB_FILE, LOG_INFO, LOC +
                 QString("    Skipping %1 at %2 because it is already in Expire "
@@ -1016,6 +1367,7 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
                 LOG(VB_FILE, LOG_INFO, LOC + QString("    Adding   %1 at %2")
                         .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
                 expireList.push_back(pginfo);
+                listed.insert(pginfo->MakeUniqueKey());
             }
             else
             {
@@ -1147,20 +1499,4 @@ bool AutoExpire::IsInDontExpireSet(
     return (dont_expire_set.find(key) != dont_expire_set.end());
 }
 
-bool AutoExpire::IsInExpireList(
-    const pginfolist_t &expireList, uint chanid, const QDateTime &recstartts)
-{
-    pginfolist_t::const_iterator it;
-
-    for (it = expireList.begin(); it != expireList.end(); ++it)
-    {
-        if (((*it)->GetChanID()             == chanid) &&
-            ((*it)->GetRecordingStartTime() == recstartts))
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
 /* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <vector>
+#include <set>
 using namespace std;
 
 #include <QWaitCondition>
@@ -36,6 +37,52 @@ enum ExpireMethodType {
     emQuickDeletedPrograms  = 10004
 };
 
+/** \class ExpireEntry
+ *  \brief Position of a recording in the expire order.
+ *
+ *   Deleted recordings come first, oldest deletion first, then the
+ *   auto-expirable recordings in the order of the expire method.
+ */
+class ExpireEntry
+{
+  public:
+    ExpireEntry() :
+        deleted(0), autoexpire(0), watched(0), primary(0), secondary(0) {}
+
+    bool operator<(const ExpireEntry &other) const
+    {
+        if (deleted != other.deleted)
+            return deleted > other.deleted;
+        if (autoexpire != other.autoexpire)
+            return autoexpire > other.autoexpire;
+        if (watched != other.watched)
+            return watched > other.watched;
+        if (primary != other.primary)
+            return primary < other.primary;
+        if (secondary != other.secondary)
+            return secondary < other.secondary;
+        return key < other.key;
+    }
+
+    int     deleted;
+    int     autoexpire;
+    int     watched;
+    int64_t primary;
+    int64_t secondary;
+    QString key;
+};
+typedef set<ExpireEntry> expire_queue_t;
+
+/// \brief A recording which may be expired, as kept in the expire queues.
+class ExpireCandidate
+{
+  public:
+    uint        chanid;
+    QDateTime   recstartts;
+    QString     location; ///< "host:directory" of the file, empty until found
+    ExpireEntry entry;
+};
+
 class AutoExpire;
 
 class ExpireThread : public MThread
@@ -93,6 +140,7 @@ class AutoExpire : public QObject
   protected:
     void RunExpirer(void);
     void RunUpdate(void);
+    virtual void customEvent(QEvent *event);
 
   private:
     void ExpireLiveTV(int type);
@@ -103,13 +151,17 @@ class AutoExpire : public QObject
 
     void FillExpireList(pginfolist_t &expireList);
     void FillDBOrdered(pginfolist_t &expireList, int expMethod);
+    void UpdateExpireQueues(void);
+    void LoadExpireCandidates(const QString &key = QString());
+    void AddToExpireQueue(const ExpireCandidate &candidate);
+    void RemoveFromExpireQueue(const QString &key);
+    void LocateExpireCandidates(void);
+    bool FindRecordingFile(ProgramInfo *p);
     void SendDeleteMessages(pginfolist_t &deleteList);
     void Sleep(int sleepTime /*ms*/);
 
     void UpdateDontExpireSet(void);
     bool IsInDontExpireSet(uint chanid, const QDateTime &recstartts) const;
-    static bool IsInExpireList(const pginfolist_t &expireList,
-                               uint chanid, const QDateTime &recstartts);
 
     // main expire info
     QSet<QString> dont_expire_set;
@@ -129,6 +181,19 @@ class AutoExpire : public QObject
     // update info
     bool          update_pending; // protected by instance_lock
     UpdateThread *update_thread;
+
+    // expire queues, only used by the expire thread
+    QMap<QString, ExpireCandidate> expire_candidates; // by chanid_recstartts
+    QMap<QString, expire_queue_t>  expire_queues;     // by file location
+    QDateTime     expire_loaded;
+    int           expire_method;
+    bool          expire_watched_first;
+    int           expire_day_priority;
+
+    // changes to apply to the expire queues
+    QMutex        queue_lock;
+    QSet<QString> queue_changed;     // protected by queue_lock
+    bool          queue_reload;      // protected by queue_lock
 };
 
 #endif
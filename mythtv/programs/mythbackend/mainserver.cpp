@@ -51,6 +51,7 @@ using namespace std;
 #include "scheduler.h"
 #include "backendutil.h"
 #include "programinfo.h"
+#include "positionmapfile.h"
 #include "mythtimezone.h"
 #include "recordinginfo.h"
 #include "recordingrule.h"
@@ -307,6 +308,8 @@ MainServer::MainServer(bool master, int port,
         expirer->SetMainServer(this);
 
     metadatafactory = new MetadataFactory(this);
+    if (gCoreContext->GetNumSetting("WatchVideoDirectories", 0))
+        metadatafactory->VideoScanWatch();
 
     autoexpireUpdateTimer = new QTimer(this);
     connect(autoexpireUpdateTimer, SIGNAL(timeout()),
@@ -2036,6 +2039,11 @@ void MainServer::DoDeleteThread(DeleteStruct *ds)
         delete_file_immediately( sFileName, followLinks, true);
     }
 
+    /* Delete the sidecar seek table, if any. */
+    QString seekFile = PositionMapFile::GetFilename(ds->m_filename);
+    if (QFile::exists(seekFile))
+        delete_file_immediately(seekFile, followLinks, true);
+
     DeleteRecordedFiles(ds);
 
     DoDeleteInDB(ds);
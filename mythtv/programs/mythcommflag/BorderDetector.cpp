@@ -5,6 +5,7 @@ extern "C" {
 }
 #include "mythcorecontext.h"    /* gContext */
 #include "compat.h"
+#include "lumascan.h"
 
 #include "CommDetector2.h"
 #include "FrameAnalyzer.h"
@@ -14,6 +15,39 @@ extern "C" {
 using namespace frameAnalyzer;
 using namespace commDetector2;
 
+namespace {
+
+/*
+ * Fast path for the edge scans: if all the pixels of a row or column from
+ * start to end, less those from skipstart to skipend (the logo), fit in
+ * maxrange together with the values seen so far, widen minval/maxval and
+ * return true. The pixel by pixel scan would not have found any outliers
+ * in such a line either; otherwise it has to be run to count them.
+ */
+bool
+lineinrange(const unsigned char *line, int step, int start, int end,
+        int skipstart, int skipend, int maxrange,
+        unsigned char *minval, unsigned char *maxval)
+{
+    unsigned char   lo = *minval, hi = *maxval;
+    int             end1 = min(end, skipstart);
+    int             start2 = max(start, skipend);
+
+    if (start < end1)
+        LumaScan::Range(line + start * step, end1 - start, step, lo, hi);
+    if (start2 < end)
+        LumaScan::Range(line + start2 * step, end - start2, step, lo, hi);
+
+    if (hi - lo + 1 > maxrange)
+        return false;
+
+    *minval = lo;
+    *maxval = hi;
+    return true;
+}
+
+};  /* namespace */
+
 BorderDetector::BorderDetector(void)
     : logoFinder(NULL),
       logo(NULL),
@@ -167,6 +201,13 @@ BorderDetector::getDimensions(const AVPicture *pgm, int pgmheight,
         {
             outliers = 0;
             inrange = true;
+            if (colinrange(pgm, cc, minrow, maxrow1, MAXRANGE,
+                        &minval, &maxval))
+            {
+                saved = cc;
+                lines = 0;
+                continue;
+            }
             for (rr = minrow; rr < maxrow1; rr++)
             {
                 if (logo && rrccinrect(rr, cc, logorow, logocol,
@@ -219,6 +260,13 @@ found_left:
         {
             outliers = 0;
             inrange = true;
+            if (colinrange(pgm, cc, minrow, maxrow1, MAXRANGE,
+                        &minval, &maxval))
+            {
+                saved = cc;
+                lines = 0;
+                continue;
+            }
             for (rr = minrow; rr < maxrow1; rr++)
             {
                 if (logo && rrccinrect(rr, cc, logorow, logocol,
@@ -272,6 +320,13 @@ found_right:
         {
             outliers = 0;
             inrange = true;
+            if (rowinrange(pgm, rr, mincol, maxcol1, MAXRANGE,
+                        &minval, &maxval))
+            {
+                saved = rr;
+                lines = 0;
+                continue;
+            }
             for (cc = mincol; cc < maxcol1; cc++)
             {
                 if (logo && rrccinrect(rr, cc, logorow, logocol,
@@ -321,6 +376,13 @@ found_top:
         {
             outliers = 0;
             inrange = true;
+            if (rowinrange(pgm, rr, mincol, maxcol1, MAXRANGE,
+                        &minval, &maxval))
+            {
+                saved = rr;
+                lines = 0;
+                continue;
+            }
             for (cc = mincol; cc < maxcol1; cc++)
             {
                 if (logo && rrccinrect(rr, cc, logorow, logocol,
@@ -394,6 +456,32 @@ done:
     return ismonochromatic ? -1 : 0;
 }
 
+bool
+BorderDetector::rowinrange(const AVPicture *pgm, int rr, int mincol,
+        int maxcol1, int maxrange, unsigned char *minval,
+        unsigned char *maxval) const
+{
+    const int   pgmwidth = pgm->linesize[0];
+    bool        inlogo = logo && rr >= logorow && rr < logorow + logoheight;
+
+    return lineinrange(pgm->data[0] + rr * pgmwidth, 1, mincol, maxcol1,
+            inlogo ? logocol : 0, inlogo ? logocol + logowidth : 0,
+            maxrange, minval, maxval);
+}
+
+bool
+BorderDetector::colinrange(const AVPicture *pgm, int cc, int minrow,
+        int maxrow1, int maxrange, unsigned char *minval,
+        unsigned char *maxval) const
+{
+    const int   pgmwidth = pgm->linesize[0];
+    bool        inlogo = logo && cc >= logocol && cc < logocol + logowidth;
+
+    return lineinrange(pgm->data[0] + cc, pgmwidth, minrow, maxrow1,
+            inlogo ? logorow : 0, inlogo ? logorow + logoheight : 0,
+            maxrange, minval, maxval);
+}
+
 int
 BorderDetector::reportTime(void)
 {
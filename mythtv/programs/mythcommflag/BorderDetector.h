@@ -32,6 +32,11 @@ public:
     int reportTime(void);
 
 private:
+    bool rowinrange(const AVPicture *pgm, int rr, int mincol, int maxcol1,
+            int maxrange, unsigned char *minval, unsigned char *maxval) const;
+    bool colinrange(const AVPicture *pgm, int cc, int minrow, int maxrow1,
+            int maxrange, unsigned char *minval, unsigned char *maxval) const;
+
     TemplateFinder          *logoFinder;
     const struct AVPicture  *logo;
     int                     logorow, logocol;
@@ -24,6 +24,7 @@ using namespace std;
 #include "tv_rec.h"
 #include "customedit.h"
 #include "mythdate.h"
+#include "mythtimer.h"
 #include "remoteutil.h"
 #include "channelutil.h"
 #include "cardutil.h"
@@ -164,6 +165,311 @@ bool JumpToChannel::Update(void)
     }
 }
 
+GuideDataCache::GuideDataCache() :
+    MThread("GuideDataCache"),
+    m_run(true), m_generation(0), m_useCount(0),
+    m_schedule(new ProgramList())
+{
+}
+
+GuideDataCache::~GuideDataCache()
+{
+    Stop();
+    wait();
+}
+
+void GuideDataCache::Stop(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_pages.clear();
+    m_run = false;
+    m_wait.wakeAll();
+}
+
+/** \fn GuideDataCache::SetSchedule(const ProgramList&)
+ *  \brief Sets the scheduled recordings used to mark up the listings
+ *         and drops all cached listings.
+ */
+void GuideDataCache::SetSchedule(const ProgramList &schedList)
+{
+    // The listings are loaded in other threads, so they get their own copy
+    ScheduleListPtr schedule(new ProgramList());
+    ProgramList::const_iterator it = schedList.begin();
+    for (; it != schedList.end(); ++it)
+        schedule->push_back(new ProgramInfo(**it));
+
+    QMutexLocker locker(&m_lock);
+    m_schedule = schedule;
+    m_blocks.clear();
+    m_pages.clear();
+    m_generation++;
+}
+
+/// Drops all cached listings so they are loaded again when next shown
+void GuideDataCache::Clear(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_blocks.clear();
+    m_pages.clear();
+    m_generation++;
+}
+
+/** \fn GuideDataCache::Load(const vector<uint>&,const QDateTime&,const QDateTime&)
+ *  \brief Loads the blocks covering the time window for the channels that
+ *         are missing any of them with one query, blocking until they are
+ *         available.
+ */
+void GuideDataCache::Load(const vector<uint> &chanids,
+                          const QDateTime &start, const QDateTime &end)
+{
+    Page page(chanids, start, end);
+
+    QMutexLocker locker(&m_lock);
+    page.chanids = Missing(page);
+    if (page.chanids.empty())
+        return;
+    ScheduleListPtr schedule = m_schedule;
+    locker.unlock();
+
+    MythTimer t;
+    t.start();
+
+    block_map_t blocks;
+    bool ok = LoadBlocks(page, *schedule, blocks);
+
+    LOG(VB_GUI, LOG_DEBUG, LOC + QString("Loaded listings of %1 channels "
+                                         "in %2 ms")
+        .arg(page.chanids.size()).arg(t.elapsed()));
+
+    locker.relock();
+    if (ok)
+        Insert(page, blocks);
+}
+
+/** \fn GuideDataCache::Prefetch(const vector<uint>&,const QDateTime&,const QDateTime&)
+ *  \brief Queues a page of listings to be loaded in the background.
+ *
+ *   The most recently queued pages are loaded first.
+ */
+void GuideDataCache::Prefetch(const vector<uint> &chanids,
+                              const QDateTime &start, const QDateTime &end)
+{
+    Page page(chanids, start, end);
+
+    QMutexLocker locker(&m_lock);
+    m_pages.push_back(page);
+    while (m_pages.size() > kMaxPages)
+        m_pages.pop_front();
+    m_wait.wakeAll();
+}
+
+/** \fn GuideDataCache::Get(uint,const QDateTime&,const QDateTime&)
+ *  \brief Returns the listings of a channel in the time window, loading
+ *         the blocks they are cut from if these are not cached.
+ */
+GuideRowPtr GuideDataCache::Get(uint chanid,
+                                const QDateTime &start, const QDateTime &end)
+{
+    Page page(vector<uint>(1, chanid), start, end);
+
+    QMutexLocker locker(&m_lock);
+    if (!Missing(page).empty())
+    {
+        locker.unlock();
+        Load(page.chanids, start, end);
+        locker.relock();
+    }
+
+    // Same bounds as the query in LoadBlocks()
+    QDateTime startts = start.addSecs(0 - start.time().second());
+    QDateTime endts   = end.addSecs(0 - end.time().second());
+
+    GuideRowPtr row(new GuideRowData());
+    for (uint b = page.firstBlock; b <= page.lastBlock; ++b)
+    {
+        QHash<quint64, QPair<uint, GuideBlockPtr> >::iterator it =
+            m_blocks.find(Key(chanid, b));
+        if (it == m_blocks.end())
+            return GuideRowPtr();
+
+        (*it).first = ++m_useCount;
+        GuideBlockPtr block = (*it).second;
+        row->blocks.push_back(block);
+
+        // A program overlapping two blocks is in both, keep the first
+        ProgramList::const_iterator pit = block->programs.begin();
+        for (; pit != block->programs.end(); ++pit)
+        {
+            if ((*pit)->GetScheduledEndTime() < startts ||
+                (*pit)->GetScheduledStartTime() > endts)
+                continue;
+            if (!row->programs.empty() &&
+                (*pit)->GetScheduledStartTime() <=
+                row->programs.back()->GetScheduledStartTime())
+                continue;
+            row->programs.push_back(*pit);
+        }
+    }
+
+    return row;
+}
+
+void GuideDataCache::run(void)
+{
+    RunProlog();
+
+    QMutexLocker locker(&m_lock);
+    while (m_run)
+    {
+        if (m_pages.empty())
+        {
+            m_wait.wait(&m_lock);
+            continue;
+        }
+
+        Page page = m_pages.takeLast();
+        page.chanids = Missing(page);
+        if (page.chanids.empty())
+            continue;
+
+        uint generation = m_generation;
+        ScheduleListPtr schedule = m_schedule;
+        locker.unlock();
+
+        MythTimer t;
+        t.start();
+
+        block_map_t blocks;
+        bool ok = LoadBlocks(page, *schedule, blocks);
+
+        LOG(VB_GUI, LOG_DEBUG, LOC + QString("Prefetched listings of %1 "
+                                             "channels in %2 ms")
+            .arg(page.chanids.size()).arg(t.elapsed()));
+
+        locker.relock();
+        // Don't cache listings loaded with an outdated schedule
+        if (ok && generation == m_generation)
+            Insert(page, blocks);
+    }
+
+    RunEpilog();
+}
+
+/// Returns the channels of the page missing any block, m_lock must be held
+vector<uint> GuideDataCache::Missing(const Page &page) const
+{
+    vector<uint> missing;
+    vector<uint>::const_iterator it = page.chanids.begin();
+    for (; it != page.chanids.end(); ++it)
+    {
+        for (uint b = page.firstBlock; b <= page.lastBlock; ++b)
+        {
+            if (!m_blocks.contains(Key(*it, b)))
+            {
+                missing.push_back(*it);
+                break;
+            }
+        }
+    }
+    return missing;
+}
+
+bool GuideDataCache::LoadBlocks(const Page &page, const ProgramList &schedList,
+                                block_map_t &blocks)
+{
+    QStringList chanids;
+    vector<uint>::const_iterator it = page.chanids.begin();
+    for (; it != page.chanids.end(); ++it)
+        chanids << QString::number(*it);
+
+    QDateTime startts = MythDate::fromTime_t(page.firstBlock * kBlockSecs);
+    QDateTime endts   = MythDate::fromTime_t((page.lastBlock + 1) * kBlockSecs);
+
+    MSqlBindings bindings;
+    QString querystr = QString("WHERE program.chanid IN (%1) "
+                               "  AND program.endtime >= :STARTTS "
+                               "  AND program.starttime <= :ENDTS "
+                               "  AND program.manualid = 0 ")
+        .arg(chanids.join(","));
+    bindings[":STARTTS"] = startts;
+    bindings[":ENDTS"]   = endts;
+
+    // The listings are handed over to the blocks, so don't delete them here
+    ProgramList programs(false);
+    if (!LoadFromProgram(programs, querystr, bindings, schedList))
+        return false;
+
+    ProgramList::iterator pit = programs.begin();
+    for (; pit != programs.end(); ++pit)
+    {
+        uint first = (*pit)->GetScheduledStartTime().toTime_t() / kBlockSecs;
+        uint last  = (*pit)->GetScheduledEndTime().toTime_t() / kBlockSecs;
+        first = max(first, page.firstBlock);
+        last  = min(last, page.lastBlock);
+
+        if (first > last)
+        {
+            delete *pit;
+            continue;
+        }
+
+        // Programs spanning blocks are copied into each of them
+        for (uint b = first; b <= last; ++b)
+        {
+            quint64 key = Key((*pit)->GetChanID(), b);
+            block_map_t::iterator bit = blocks.find(key);
+            if (bit == blocks.end())
+                bit = blocks.insert(key, GuideBlockPtr(new GuideBlockData()));
+            (*bit)->programs.push_back(
+                (b == first) ? *pit : new ProgramInfo(**pit));
+        }
+    }
+
+    return true;
+}
+
+/// Adds the blocks of a loaded page to the cache, m_lock must be held
+void GuideDataCache::Insert(const Page &page, const block_map_t &blocks)
+{
+    vector<uint>::const_iterator it = page.chanids.begin();
+    for (; it != page.chanids.end(); ++it)
+    {
+        for (uint b = page.firstBlock; b <= page.lastBlock; ++b)
+        {
+            quint64 key = Key(*it, b);
+            if (m_blocks.contains(key))
+                continue;
+
+            GuideBlockPtr block = blocks.value(key);
+            if (!block)
+                block = GuideBlockPtr(new GuideBlockData());
+            m_blocks.insert(key, qMakePair(++m_useCount, block));
+        }
+    }
+
+    if (m_blocks.size() <= kMaxBlocks)
+        return;
+
+    // Drop the least recently used quarter of the blocks
+    vector<uint> uses;
+    uses.reserve(m_blocks.size());
+    QHash<quint64, QPair<uint, GuideBlockPtr> >::const_iterator uit;
+    for (uit = m_blocks.begin(); uit != m_blocks.end(); ++uit)
+        uses.push_back((*uit).first);
+    std::nth_element(uses.begin(), uses.begin() + kMaxBlocks / 4, uses.end());
+    uint oldest = uses[kMaxBlocks / 4];
+
+    QHash<quint64, QPair<uint, GuideBlockPtr> >::iterator rit =
+        m_blocks.begin();
+    while (rit != m_blocks.end())
+    {
+        if ((*rit).first < oldest)
+            rit = m_blocks.erase(rit);
+        else
+            ++rit;
+    }
+}
+
 void GuideGrid::RunProgramGuide(uint chanid, const QString &channum,
                     TV *player, bool embedVideo, bool allowFinder, int changrpid)
 {
@@ -223,6 +529,7 @@ GuideGrid::GuideGrid(MythScreenStack *parent,
                      bool allowFinder, int changrpid)
          : ScheduleCommon(parent, "guidegrid"),
     m_allowFinder(allowFinder),
+    m_guideCache(new GuideDataCache()),
     m_player(player),
     m_usingNullVideo(false), m_embedVideo(embedVideo),
     m_previewVideoRefreshTimer(new QTimer(this)),
@@ -245,7 +552,9 @@ GuideGrid::GuideGrid(MythScreenStack *parent,
     m_channelOrdering = gCoreContext->GetSetting("ChannelOrdering", "channum");
 
     for (uint i = 0; i < MAX_DISPLAY_CHANS; i++)
-        m_programs.push_back(NULL);
+        m_programs.push_back(GuideRowPtr());
+
+    m_guideCache->start();
 
     for (int x = 0; x < MAX_DISPLAY_TIMES; ++x)
     {
@@ -310,25 +619,19 @@ bool GuideGrid::Create()
 void GuideGrid::Load(void)
 {
     LoadFromScheduler(m_recList);
+    m_guideCache->SetSchedule(m_recList);
     fillChannelInfos();
 
     int maxchannel = max((int)GetChannelCount() - 1, 0);
     setStartChannel((int)(m_currentStartChannel) - (int)(m_channelCount / 2));
     m_channelCount = min(m_channelCount, maxchannel + 1);
 
-    for (int y = 0; y < m_channelCount; ++y)
+    vector<uint> chanids = GetPageChanIds(m_currentStartChannel);
+    m_guideCache->Load(chanids, m_currentStartTime, m_currentEndTime);
+    for (uint y = 0; y < chanids.size(); ++y)
     {
-        int chanNum = y + m_currentStartChannel;
-        if (chanNum >= (int) m_channelInfos.size())
-            chanNum -= (int) m_channelInfos.size();
-        if (chanNum >= (int) m_channelInfos.size())
-            continue;
-
-        if (chanNum < 0)
-            chanNum = 0;
-
-        delete m_programs[y];
-        m_programs[y] = getProgramListFromProgram(chanNum);
+        m_programs[y] = m_guideCache->Get(chanids[y], m_currentStartTime,
+                                          m_currentEndTime);
     }
 }
 
@@ -362,12 +665,8 @@ GuideGrid::~GuideGrid()
 {
     gCoreContext->removeListener(this);
 
-    while (!m_programs.empty())
-    {
-        if (m_programs.back())
-            delete m_programs.back();
-        m_programs.pop_back();
-    }
+    m_programs.clear();
+    delete m_guideCache;
 
     m_channelInfos.clear();
 
@@ -850,6 +1149,7 @@ DBChanList GuideGrid::GetSelection(void) const
 void GuideGrid::updateTimeout(void)
 {
     m_updateTimer->stop();
+    m_guideCache->Clear();
     fillProgramInfos();
     m_updateTimer->start((int)(60 * 1000));
 }
@@ -1058,35 +1358,67 @@ void GuideGrid::fillTimeInfos()
 
 void GuideGrid::fillProgramInfos(bool useExistingData)
 {
+    MythTimer t;
+    t.start();
+
     m_guideGrid->ResetData();
 
+    // Load the whole page with one query rather than one per row
+    if (!useExistingData)
+    {
+        m_guideCache->Load(GetPageChanIds(m_currentStartChannel),
+                           m_currentStartTime, m_currentEndTime);
+    }
+
     for (int y = 0; y < m_channelCount; ++y)
     {
         fillProgramRowInfos(y, useExistingData);
     }
+
+    PrefetchPages();
+
+    LOG(VB_GUI, LOG_DEBUG, LOC + QString("Filled guide page in %1 ms")
+        .arg(t.elapsed()));
 }
 
-ProgramList *GuideGrid::getProgramListFromProgram(int chanNum)
+/// Returns the chanid shown in each row of a page starting at startChannel
+vector<uint> GuideGrid::GetPageChanIds(int startChannel) const
 {
-    ProgramList *proglist = new ProgramList();
+    vector<uint> chanids;
 
-    if (proglist)
-    {
-        MSqlBindings bindings;
-        QString querystr = "WHERE program.chanid = :CHANID "
-                           "  AND program.endtime >= :STARTTS "
-                           "  AND program.starttime <= :ENDTS "
-                           "  AND program.manualid = 0 ";
-        bindings[":CHANID"]  = GetChannelInfo(chanNum)->chanid;
-        bindings[":STARTTS"] =
-            m_currentStartTime.addSecs(0 - m_currentStartTime.time().second());
-        bindings[":ENDTS"] =
-            m_currentEndTime.addSecs(0 - m_currentEndTime.time().second());
+    int count = GetChannelCount();
+    if (!count)
+        return chanids;
 
-        LoadFromProgram(*proglist, querystr, bindings, m_recList);
+    for (int y = 0; y < m_channelCount; ++y)
+    {
+        int chanNum = ((startChannel + y) % count + count) % count;
+        const DBChannel *chinfo = GetChannelInfo(chanNum);
+        chanids.push_back(chinfo ? chinfo->chanid : 0);
     }
 
-    return proglist;
+    return chanids;
+}
+
+/// Queues the pages the user is likely to move to next for loading
+void GuideGrid::PrefetchPages(void)
+{
+    int pagesecs = 5 * 60 * m_timeCount;
+    vector<uint> chanids = GetPageChanIds(m_currentStartChannel);
+    if (chanids.empty())
+        return;
+
+    // Queued in increasing order of likelihood, the last is loaded first
+    m_guideCache->Prefetch(chanids, m_currentStartTime.addSecs(-pagesecs),
+                           m_currentEndTime.addSecs(-pagesecs));
+    m_guideCache->Prefetch(
+        GetPageChanIds((int)m_currentStartChannel - m_channelCount),
+        m_currentStartTime, m_currentEndTime);
+    m_guideCache->Prefetch(chanids, m_currentStartTime.addSecs(pagesecs),
+                           m_currentEndTime.addSecs(pagesecs));
+    m_guideCache->Prefetch(
+        GetPageChanIds(m_currentStartChannel + m_channelCount),
+        m_currentStartTime, m_currentEndTime);
 }
 
 void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
@@ -1116,12 +1448,13 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
 
     if (!useExistingData)
     {
-        delete m_programs[row];
-        m_programs[row] = getProgramListFromProgram(chanNum);
+        m_programs[row] = m_guideCache->Get(GetChannelInfo(chanNum)->chanid,
+                                            m_currentStartTime,
+                                            m_currentEndTime);
     }
 
-    ProgramList *proglist = m_programs[row];
-    if (!proglist)
+    GuideRowPtr rowdata = m_programs[row];
+    if (!rowdata)
         return;
 
     QDateTime ts = m_currentStartTime;
@@ -1142,61 +1475,68 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
 
     m_guideGrid->SetProgPast(progPast);
 
-    ProgramList::iterator program = proglist->begin();
-    vector<ProgramInfo*> unknownlist;
-    bool unknown = false;
-    ProgramInfo *proginfo = NULL;
-    for (int x = 0; x < m_timeCount; ++x)
+    // Rows keep their cells while the page is redrawn, only lay out new ones
+    if ((int)rowdata->cells.size() != m_timeCount)
     {
-        if (program != proglist->end() &&
-            (ts >= (*program)->GetScheduledEndTime()))
-        {
-            ++program;
-        }
+        rowdata->cells.clear();
+        rowdata->unknowns.clear();
 
-        if ((program == proglist->end()) ||
-            (ts < (*program)->GetScheduledStartTime()))
+        ProgramList &proglist = rowdata->programs;
+        ProgramList::iterator program = proglist.begin();
+        bool unknown = false;
+        ProgramInfo *proginfo = NULL;
+        for (int x = 0; x < m_timeCount; ++x)
         {
-            if (unknown)
+            if (program != proglist.end() &&
+                (ts >= (*program)->GetScheduledEndTime()))
             {
-                proginfo->spread++;
-                proginfo->SetScheduledEndTime(
-                    proginfo->GetScheduledEndTime().addSecs(5 * 60));
+                ++program;
             }
-            else
-            {
-                proginfo = new ProgramInfo(kUnknownTitle, kUnknownCategory,
-                                           ts, ts.addSecs(5*60));
-                unknownlist.push_back(proginfo);
-                proginfo->startCol = x;
-                proginfo->spread = 1;
-                unknown = true;
-            }
-        }
-        else
-        {
-            if (proginfo && proginfo == *program)
+
+            if ((program == proglist.end()) ||
+                (ts < (*program)->GetScheduledStartTime()))
             {
-                proginfo->spread++;
+                if (unknown)
+                {
+                    proginfo->spread++;
+                    proginfo->SetScheduledEndTime(
+                        proginfo->GetScheduledEndTime().addSecs(5 * 60));
+                }
+                else
+                {
+                    proginfo = new ProgramInfo(kUnknownTitle,
+                                               kUnknownCategory,
+                                               ts, ts.addSecs(5*60));
+                    rowdata->unknowns.push_back(proginfo);
+                    proginfo->startCol = x;
+                    proginfo->spread = 1;
+                    unknown = true;
+                }
             }
             else
             {
-                proginfo = *program;
-                if (proginfo)
+                if (proginfo && proginfo == *program)
                 {
-                    proginfo->startCol = x;
-                    proginfo->spread = 1;
-                    unknown = false;
+                    proginfo->spread++;
+                }
+                else
+                {
+                    proginfo = *program;
+                    if (proginfo)
+                    {
+                        proginfo->startCol = x;
+                        proginfo->spread = 1;
+                        unknown = false;
+                    }
                 }
             }
+            rowdata->cells.push_back(proginfo);
+            ts = ts.addSecs(5 * 60);
         }
-        m_programInfos[row][x] = proginfo;
-        ts = ts.addSecs(5 * 60);
     }
 
-    vector<ProgramInfo*>::iterator it = unknownlist.begin();
-    for (; it != unknownlist.end(); ++it)
-        proglist->push_back(*it);
+    for (int x = 0; x < m_timeCount; ++x)
+        m_programInfos[row][x] = rowdata->cells[x];
 
     MythRect programRect = m_guideGrid->GetArea();
 
@@ -1358,6 +1698,7 @@ void GuideGrid::customEvent(QEvent *event)
         if (message == "SCHEDULE_CHANGE")
         {
             LoadFromScheduler(m_recList);
+            m_guideCache->SetSchedule(m_recList);
             fillProgramInfos();
             updateInfo();
         }
@@ -1663,6 +2004,7 @@ void GuideGrid::generateListings()
     m_channelCount = min(m_guideGrid->getChannelCount(), maxchannel + 1);
 
     LoadFromScheduler(m_recList);
+    m_guideCache->SetSchedule(m_recList);
     fillProgramInfos();
 }
 
@@ -1990,6 +2332,7 @@ void GuideGrid::quickRecord()
     *pginfo = ri;
 
     LoadFromScheduler(m_recList);
+    m_guideCache->SetSchedule(m_recList);
     fillProgramInfos();
     updateInfo();
 }
@@ -10,8 +10,13 @@ using namespace std;
 #include <QString>
 #include <QDateTime>
 #include <QEvent>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
 
 // myth
+#include "mthread.h"
 #include "mythscreentype.h"
 #include "programinfo.h"
 #include "channelgroup.h"
@@ -76,6 +81,97 @@ class JumpToChannel : public QObject
     static const uint kJumpToChannelTimeout = 3500; // ms
 };
 
+/** \class GuideBlockData
+ *  \brief The listings of one channel for one fixed block of time, as
+ *         cached by GuideDataCache.
+ */
+class GuideBlockData
+{
+  public:
+    ProgramList programs;
+};
+typedef QSharedPointer<GuideBlockData> GuideBlockPtr;
+
+/** \class GuideRowData
+ *  \brief The listings of one channel for one time window of the guide.
+ */
+class GuideRowData
+{
+  public:
+    GuideRowData() : programs(false) {}
+
+    ProgramList          programs; ///< listings in the window, owned by blocks
+    ProgramList          unknowns; ///< placeholders for gaps in the listings
+    vector<ProgramInfo*> cells;    ///< program in each time slot, once laid out
+    QList<GuideBlockPtr> blocks;   ///< cached blocks the window was cut from
+};
+typedef QSharedPointer<GuideRowData> GuideRowPtr;
+
+/** \class GuideDataCache
+ *  \brief Cache of the listings shown in the program guide.
+ *
+ *   Listings are cached per channel in blocks of kBlockSecs, so scrolling
+ *   through time mostly cuts the new window out of blocks already loaded.
+ *   The blocks a page needs are loaded for all its channels with a single
+ *   query, and the pages next to the one on screen are prefetched in the
+ *   background so scrolling seldom waits on the database.
+ */
+class GuideDataCache : public MThread
+{
+  public:
+    GuideDataCache();
+    virtual ~GuideDataCache();
+
+    void Stop(void);
+
+    void SetSchedule(const ProgramList &schedList);
+    void Clear(void);
+    void Load(const vector<uint> &chanids,
+              const QDateTime &start, const QDateTime &end);
+    void Prefetch(const vector<uint> &chanids,
+                  const QDateTime &start, const QDateTime &end);
+    GuideRowPtr Get(uint chanid, const QDateTime &start, const QDateTime &end);
+
+  protected:
+    virtual void run(void);
+
+  private:
+    class Page
+    {
+      public:
+        Page(const vector<uint> &chans,
+             const QDateTime &start, const QDateTime &end) :
+            chanids(chans),
+            firstBlock(start.toTime_t() / kBlockSecs),
+            lastBlock(end.toTime_t() / kBlockSecs) {}
+        vector<uint> chanids;
+        uint         firstBlock;
+        uint         lastBlock;
+    };
+    typedef QSharedPointer<ProgramList> ScheduleListPtr;
+    typedef QHash<quint64, GuideBlockPtr> block_map_t;
+
+    static quint64 Key(uint chanid, uint block)
+        { return ((quint64)chanid << 32) | block; }
+    vector<uint> Missing(const Page &page) const;
+    static bool LoadBlocks(const Page &page, const ProgramList &schedList,
+                           block_map_t &blocks);
+    void Insert(const Page &page, const block_map_t &blocks);
+
+    mutable QMutex  m_lock; // protects variables below
+    QWaitCondition  m_wait;
+    bool            m_run;
+    uint            m_generation;
+    uint            m_useCount;
+    ScheduleListPtr m_schedule;
+    QList<Page>     m_pages;
+    QHash<quint64, QPair<uint, GuideBlockPtr> > m_blocks;
+
+    static const uint kBlockSecs = 6 * 60 * 60;
+    static const int  kMaxBlocks = 2048;
+    static const int  kMaxPages  = 8;
+};
+
 class GuideGrid : public ScheduleCommon, public JumpToChannelListener
 {
     Q_OBJECT
@@ -176,7 +272,8 @@ class GuideGrid : public ScheduleCommon, public JumpToChannelListener
     void fillTimeInfos(void);
     void fillProgramInfos(bool useExistingData = false);
     void fillProgramRowInfos(unsigned int row, bool useExistingData = false);
-    ProgramList *getProgramListFromProgram(int chanNum);
+    vector<uint> GetPageChanIds(int startChannel) const;
+    void PrefetchPages(void);
 
     void setStartChannel(int newStartChannel);
 
@@ -197,7 +294,8 @@ class GuideGrid : public ScheduleCommon, public JumpToChannelListener
     db_chan_list_list_t m_channelInfos;
     QMap<uint,uint>      m_channelInfoIdx;
 
-    vector<ProgramList*> m_programs;
+    GuideDataCache      *m_guideCache;
+    vector<GuideRowPtr>  m_programs;
     ProgramInfo *m_programInfos[MAX_DISPLAY_CHANS][MAX_DISPLAY_TIMES];
     ProgramList  m_recList;
 
@@ -37,6 +37,7 @@ HEADERS += grabbersettings.h            editvideometadata.h
 HEADERS += videofileassoc.h             videometadatasettings.h
 HEADERS += videoplayercommand.h         videopopups.h
 HEADERS += videofilter.h                videolist.h
+HEADERS += videolistindex.h
 HEADERS += videoplayersettings.h        videodlg.h
 HEADERS += videoglobalsettings.h        upnpscanner.h
 HEADERS += commandlineparser.h          idlescreen.h
@@ -58,6 +59,7 @@ SOURCES += grabbersettings.cpp          editvideometadata.cpp
 SOURCES += videofileassoc.cpp           videometadatasettings.cpp
 SOURCES += videoplayercommand.cpp       videopopups.cpp
 SOURCES += videofilter.cpp              videolist.cpp
+SOURCES += videolistindex.cpp
 SOURCES += videoplayersettings.cpp      videodlg.cpp
 SOURCES += videoglobalsettings.cpp      upnpscanner.cpp
 SOURCES += commandlineparser.cpp        idlescreen.cpp
@@ -13,6 +13,7 @@
 #include "mythdate.h"
 
 #include "videolist.h"
+#include "videolistindex.h"
 #include "videofilter.h"
 
 enum GenreFilter {
@@ -386,6 +387,61 @@ bool VideoFilterSettings::matches_filter(const VideoMetadata &mdata) const
     return matches;
 }
 
+/** \fn VideoFilterSettings::matches_filter(const VideoListIndex&,QBitArray&) const
+ *  \brief Sets the bits of the index rows matching the filter.
+ *
+ *   The genre, country, cast, category, year and parental level filters are
+ *   applied using the index's bitmaps, the remaining ones are only checked
+ *   for the rows left over.
+ */
+void VideoFilterSettings::matches_filter(const VideoListIndex &index,
+                                         QBitArray &matches) const
+{
+    matches = QBitArray(index.size(), true);
+
+    if (genre != kGenreFilterAll)
+        matches &= index.Rows(VideoListIndex::kGenre, genre);
+
+    if (country != kCountryFilterAll)
+        matches &= index.Rows(VideoListIndex::kCountry, country);
+
+    if (cast != kCastFilterAll)
+        matches &= index.Rows(VideoListIndex::kCast, cast);
+
+    if (category != kCategoryFilterAll)
+        matches &= index.Rows(VideoListIndex::kCategory, category);
+
+    if (year != kYearFilterAll)
+        matches &= index.Rows(VideoListIndex::kYear, year);
+
+    if (m_parental_level)
+    {
+        QBitArray allowed(index.size());
+        for (int level = ParentalLevel::plLowest;
+             level <= m_parental_level; ++level)
+        {
+            allowed |= index.Rows(VideoListIndex::kShowLevel, level);
+        }
+        matches &= allowed;
+    }
+
+    bool check_rest = !textfilter.isEmpty() || (season != -1) ||
+        insertdate.isValid() || (runtime != kRuntimeFilterAll) ||
+        (userrating != kUserRatingFilterAll) ||
+        (browse != kBrowseFilterAll) || (watched != kWatchedFilterAll) ||
+        (m_inetref != kInetRefFilterAll) ||
+        (m_coverfile != kCoverFileFilterAll);
+
+    if (!check_rest)
+        return;
+
+    for (uint row = 0; row < index.size(); ++row)
+    {
+        if (matches.testBit(row) && !matches_filter(*index.At(row)))
+            matches.clearBit(row);
+    }
+}
+
 /// Compares two VideoMetadata instances
 bool VideoFilterSettings::meta_less_than(const VideoMetadata &lhs,
                                          const VideoMetadata &rhs,
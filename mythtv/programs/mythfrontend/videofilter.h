@@ -11,6 +11,8 @@ class MythUIText;
 
 class VideoMetadata;
 class VideoList;
+class VideoListIndex;
+class QBitArray;
 
 class VideoFilterSettings
 {
@@ -41,6 +43,7 @@ class VideoFilterSettings
     VideoFilterSettings &operator=(const VideoFilterSettings &rhs);
 
     bool matches_filter(const VideoMetadata &mdata) const;
+    void matches_filter(const VideoListIndex &index, QBitArray &matches) const;
     bool meta_less_than(const VideoMetadata &lhs, const VideoMetadata &rhs,
                         bool sort_ignores_case) const;
 
@@ -18,6 +18,7 @@
 #include "parentalcontrols.h"
 
 #include "videofilter.h"
+#include "videolistindex.h"
 #include "videolist.h"
 #include "videodlg.h"
 
@@ -166,6 +167,30 @@ struct metadata_sort
     bool m_sic;
 };
 
+/// sorts by the position of the videos in the index's cached sort order
+struct metadata_rank_sort
+{
+    metadata_rank_sort(const VideoListIndex &index,
+                       const std::vector<uint> &rank,
+                       const VideoFilterSettings &vfs) :
+            m_index(index), m_rank(rank), m_vfs(vfs) {}
+
+    bool operator()(const smart_meta_node &lhs, const smart_meta_node &rhs)
+    {
+        int lhs_row = m_index.Row(lhs->getData());
+        int rhs_row = m_index.Row(rhs->getData());
+        if (lhs_row < 0 || rhs_row < 0)
+            return m_vfs.meta_less_than(*(lhs->getData()),
+                                        *(rhs->getData()), true);
+        return m_rank[lhs_row] < m_rank[rhs_row];
+    }
+
+      private:
+    const VideoListIndex &m_index;
+    const std::vector<uint> &m_rank;
+    const VideoFilterSettings &m_vfs;
+};
+
 struct metadata_path_sort
 {
     metadata_path_sort(bool ignore_case) : m_ignore_case(ignore_case) {}
@@ -396,13 +421,12 @@ class VideoListImp
 
     int TryFilter(const VideoFilterSettings &filter) const
     {
-        int ret = 0;
-        for (metadata_list::const_iterator p = m_metadata.getList().begin();
-             p != m_metadata.getList().end(); ++p)
-        {
-            if (filter.matches_filter(**p)) ++ret;
-        }
-        return ret;
+        if (!m_index.IsValid())
+            m_index.Build(m_metadata.getList());
+
+        QBitArray matches;
+        filter.matches_filter(m_index, matches);
+        return matches.count(true);
     }
 
     const VideoMetadataListManager &getListCache() const
@@ -424,6 +448,7 @@ class VideoListImp
             ret = mp->DeleteFile();
             if (ret) ret = m_metadata.purgeByID(video_id);
         }
+        m_index.Invalidate();
 
         return ret;
     }
@@ -441,6 +466,7 @@ class VideoListImp
         metadata_list ml;
         VideoMetadataListManager::loadAllFromDatabase(ml);
         m_metadata.setList(ml);
+        m_index.Invalidate();
     }
 
   private:
@@ -465,6 +491,9 @@ class VideoListImp
     VideoMetadataListManager m_metadata;
     meta_dir_node m_metadata_tree; // master list for tree views
 
+    // bitmaps and sort orders over m_metadata, rebuilt when it changes
+    mutable VideoListIndex m_index;
+
     metadata_view_list m_metadata_view_flat;
     meta_dir_node m_metadata_view_tree;
 
@@ -755,8 +784,9 @@ void VideoListImp::sort_view_data(bool flat_list)
     else
     {
         m_metadata_view_tree.sort(metadata_path_sort(true),
-                                  metadata_sort(m_video_filter,
-                                                true));
+                                  metadata_rank_sort(m_index,
+                                      m_index.Rank(m_video_filter),
+                                      m_video_filter));
     }
 }
 
@@ -768,6 +798,7 @@ void VideoListImp::fillMetadata(metadata_list_type whence)
         // flush existing data
         metadata_list ml;
         m_metadata.setList(ml);
+        m_index.Invalidate();
         m_metadata_tree.clear();
 
         switch (whence)
@@ -802,6 +833,7 @@ void VideoListImp::buildGroupList(metadata_list_type whence)
     metadata_list ml;
     VideoMetadataListManager::loadAllFromDatabase(ml);
     m_metadata.setList(ml);
+    m_index.Invalidate();
 
     metadata_view_list mlist;
     mlist.reserve(m_metadata.getList().size());
@@ -935,6 +967,7 @@ void VideoListImp::buildTVList()
     metadata_list ml;
     VideoMetadataListManager::loadAllFromDatabase(ml);
     m_metadata.setList(ml);
+    m_index.Invalidate();
 
     metadata_view_list mlist;
     mlist.reserve(m_metadata.getList().size());
@@ -982,6 +1015,7 @@ void VideoListImp::buildDbList()
     metadata_list ml;
     VideoMetadataListManager::loadAllFromDatabase(ml);
     m_metadata.setList(ml);
+    m_index.Invalidate();
 
     metadata_view_list mlist;
     mlist.reserve(m_metadata.getList().size());
@@ -1082,16 +1116,22 @@ void VideoListImp::buildFsysList()
         }
     }
     m_metadata.setList(ml);
+    m_index.Invalidate();
 }
 
 
 static void copy_entries(meta_dir_node &dst, meta_dir_node &src,
-                         const VideoFilterSettings &filter)
+                         const VideoFilterSettings &filter,
+                         const VideoListIndex &index,
+                         const QBitArray &matches)
 {
     for (meta_dir_node::entry_iterator e = src.entries_begin();
     e != src.entries_end(); ++e)
     {
-        if (filter.matches_filter(*((*e)->getData())))
+        int row = index.Row((*e)->getData());
+        bool match = (row < 0) ? filter.matches_filter(*((*e)->getData()))
+                               : matches.testBit(row);
+        if (match)
         {
             dst.addEntry(
                     smart_meta_node(new meta_data_node((*e)->getData())));
@@ -1100,9 +1140,11 @@ static void copy_entries(meta_dir_node &dst, meta_dir_node &src,
 }
 
 static void copy_filtered_tree(meta_dir_node &dst, meta_dir_node &src,
-                               const VideoFilterSettings &filter)
+                               const VideoFilterSettings &filter,
+                               const VideoListIndex &index,
+                               const QBitArray &matches)
 {
-    copy_entries(dst, src, filter);
+    copy_entries(dst, src, filter, index, matches);
     for (meta_dir_node::dir_iterator dir = src.dirs_begin();
     dir != src.dirs_end(); ++dir)
     {
@@ -1111,7 +1153,7 @@ static void copy_filtered_tree(meta_dir_node &dst, meta_dir_node &src,
                                            (*dir)->GetHost(),
                                            (*dir)->GetPrefix(),
                                            (*dir)->GetData());
-        copy_filtered_tree(*sdn, *(dir->get()), filter);
+        copy_filtered_tree(*sdn, *(dir->get()), filter, index, matches);
     }
 }
 
@@ -1161,19 +1203,22 @@ void VideoListImp::update_meta_view(bool flat_list)
         }
     }
 
+    if (!m_index.IsValid())
+        m_index.Build(m_metadata.getList());
+
+    QBitArray matches;
+    m_video_filter.matches_filter(m_index, matches);
+
     if (flat_list)
     {
-        for (metadata_list::const_iterator p = m_metadata.getList().begin();
-             p != m_metadata.getList().end(); ++p)
+        // the cached order is already sorted, just pick the matches
+        const std::vector<uint> &order = m_index.Order(m_video_filter);
+        for (uint i = 0; i < order.size(); ++i)
         {
-            if (m_video_filter.matches_filter(*(*p)))
-            {
-                m_metadata_view_flat.push_back(p->get());
-            }
+            if (matches.testBit(order[i]))
+                m_metadata_view_flat.push_back(m_index.At(order[i]));
         }
 
-        sort_view_data(flat_list);
-
         for (metadata_view_list::iterator p = m_metadata_view_flat.begin();
              p != m_metadata_view_flat.end(); ++p)
         {
@@ -1185,7 +1230,7 @@ void VideoListImp::update_meta_view(bool flat_list)
         m_metadata_view_tree.setPath(m_metadata_tree.getPath());
         m_metadata_view_tree.setName(m_metadata_tree.getName());
         copy_filtered_tree(m_metadata_view_tree, m_metadata_tree,
-                           m_video_filter);
+                           m_video_filter, m_index, matches);
 
         sort_view_data(flat_list);
 
@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include "mythlogging.h"
+#include "mythtimer.h"
+#include "videometadata.h"
+
+#include "videofilter.h"
+#include "videolistindex.h"
+
+namespace
+{
+    /// Orders row numbers the way VideoFilterSettings orders the videos
+    struct row_sort
+    {
+        row_sort(const std::vector<VideoMetadata *> &rows,
+                 const VideoFilterSettings &vfs) : m_rows(rows), m_vfs(vfs) {}
+
+        bool operator()(uint lhs, uint rhs) const
+        {
+            return m_vfs.meta_less_than(*m_rows[lhs], *m_rows[rhs], true);
+        }
+
+      private:
+        const std::vector<VideoMetadata *> &m_rows;
+        const VideoFilterSettings &m_vfs;
+    };
+}
+
+VideoListIndex::VideoListIndex() : m_valid(false), m_change_count(0)
+{
+}
+
+/// Returns false if the index needs to be built again
+bool VideoListIndex::IsValid(void) const
+{
+    return m_valid &&
+        (m_change_count == VideoMetadata::GetDatabaseChangeCount());
+}
+
+void VideoListIndex::AddBit(BitmapColumn column, int value, uint row)
+{
+    bitmap_map::iterator it = m_bitmaps[column].find(value);
+    if (it == m_bitmaps[column].end())
+        it = m_bitmaps[column].insert(value, QBitArray(m_rows.size()));
+    it->setBit(row);
+}
+
+void VideoListIndex::Build(const VideoMetadataListManager::metadata_list &list)
+{
+    MythTimer t;
+    t.start();
+
+    m_change_count = VideoMetadata::GetDatabaseChangeCount();
+
+    m_rows.clear();
+    m_rows.reserve(list.size());
+    m_row_of.clear();
+    m_row_of.reserve(list.size());
+    for (uint i = 0; i < kColumnCount; ++i)
+        m_bitmaps[i].clear();
+    m_order.clear();
+    m_rank.clear();
+
+    VideoMetadataListManager::metadata_list::const_iterator p = list.begin();
+    for (; p != list.end(); ++p)
+    {
+        m_row_of.insert(p->get(), m_rows.size());
+        m_rows.push_back(p->get());
+    }
+
+    for (uint row = 0; row < m_rows.size(); ++row)
+    {
+        const VideoMetadata *mdata = m_rows[row];
+
+        const VideoMetadata::genre_list &gl = mdata->GetGenres();
+        VideoMetadata::genre_list::const_iterator g = gl.begin();
+        for (; g != gl.end(); ++g)
+            AddBit(kGenre, g->first, row);
+
+        const VideoMetadata::country_list &cl = mdata->GetCountries();
+        VideoMetadata::country_list::const_iterator c = cl.begin();
+        for (; c != cl.end(); ++c)
+            AddBit(kCountry, c->first, row);
+
+        // The "unknown" cast filter (0) also matches videos without cast
+        const VideoMetadata::cast_list &cast = mdata->GetCast();
+        if (cast.empty())
+            AddBit(kCast, 0, row);
+        VideoMetadata::cast_list::const_iterator a = cast.begin();
+        for (; a != cast.end(); ++a)
+            AddBit(kCast, a->first, row);
+
+        AddBit(kCategory, mdata->GetCategoryID(), row);
+
+        // The "unknown" year filter (0) also matches the default year
+        AddBit(kYear, mdata->GetYear(), row);
+        if (mdata->GetYear() == VIDEO_YEAR_DEFAULT)
+            AddBit(kYear, 0, row);
+
+        AddBit(kShowLevel, mdata->GetShowLevel(), row);
+    }
+
+    m_valid = true;
+
+    LOG(VB_GENERAL, LOG_DEBUG, QString("Indexed %1 videos in %2 ms")
+        .arg(m_rows.size()).arg(t.elapsed()));
+}
+
+/// Returns the row of the video, or -1 if it is not in the index
+int VideoListIndex::Row(const VideoMetadata *metadata) const
+{
+    QHash<const VideoMetadata *, uint>::const_iterator it =
+        m_row_of.find(metadata);
+    return (it == m_row_of.end()) ? -1 : (int) *it;
+}
+
+/// Returns the rows whose column holds value
+QBitArray VideoListIndex::Rows(BitmapColumn column, int value) const
+{
+    bitmap_map::const_iterator it = m_bitmaps[column].find(value);
+    if (it == m_bitmaps[column].end())
+        return QBitArray(m_rows.size());
+    return *it;
+}
+
+void VideoListIndex::Sort(const VideoFilterSettings &filter)
+{
+    int key = filter.getOrderby();
+
+    MythTimer t;
+    t.start();
+
+    std::vector<uint> &order = m_order[key];
+    order.resize(m_rows.size());
+    for (uint i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), row_sort(m_rows, filter));
+
+    std::vector<uint> &rank = m_rank[key];
+    rank.resize(order.size());
+    for (uint i = 0; i < order.size(); ++i)
+        rank[order[i]] = i;
+
+    LOG(VB_GENERAL, LOG_DEBUG, QString("Sorted %1 videos in %2 ms")
+        .arg(order.size()).arg(t.elapsed()));
+}
+
+/// Returns the rows in the filter's sort order
+const std::vector<uint> &VideoListIndex::Order(
+    const VideoFilterSettings &filter)
+{
+    if (m_order.find(filter.getOrderby()) == m_order.end())
+        Sort(filter);
+    return m_order[filter.getOrderby()];
+}
+
+/// Returns the position of each row in the filter's sort order
+const std::vector<uint> &VideoListIndex::Rank(
+    const VideoFilterSettings &filter)
+{
+    if (m_rank.find(filter.getOrderby()) == m_rank.end())
+        Sort(filter);
+    return m_rank[filter.getOrderby()];
+}
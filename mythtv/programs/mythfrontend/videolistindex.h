@@ -0,0 +1,72 @@
+#ifndef VIDEOLISTINDEX_H_
+#define VIDEOLISTINDEX_H_
+
+#include <vector>
+#include <map>
+
+#include <QBitArray>
+#include <QHash>
+#include <QMap>
+
+#include "videometadatalistmanager.h"
+
+class VideoFilterSettings;
+
+/** \class VideoListIndex
+ *  \brief Column oriented index of the videos known to VideoList.
+ *
+ *   The index holds a row per video with bitmaps of the rows having each
+ *   genre, country, cast member, category, year and parental level, so most
+ *   filters are evaluated with a few bitmap operations. It also caches the
+ *   sorted order of the rows for each sort order so a filter change does not
+ *   need the list sorted again.
+ *
+ *   The index holds plain pointers into the VideoMetadataListManager it was
+ *   built from and must be invalidated whenever that list changes.
+ */
+class VideoListIndex
+{
+  public:
+    enum BitmapColumn
+    {
+        kGenre = 0,
+        kCountry,
+        kCast,
+        kCategory,
+        kYear,
+        kShowLevel,
+        kColumnCount
+    };
+
+    VideoListIndex();
+
+    void Build(const VideoMetadataListManager::metadata_list &list);
+    void Invalidate(void) { m_valid = false; }
+    bool IsValid(void) const;
+
+    uint size(void) const { return m_rows.size(); }
+    VideoMetadata *At(uint row) const { return m_rows[row]; }
+    int Row(const VideoMetadata *metadata) const;
+
+    QBitArray Rows(BitmapColumn column, int value) const;
+
+    const std::vector<uint> &Order(const VideoFilterSettings &filter);
+    const std::vector<uint> &Rank(const VideoFilterSettings &filter);
+
+  private:
+    void AddBit(BitmapColumn column, int value, uint row);
+    void Sort(const VideoFilterSettings &filter);
+
+    typedef QMap<int, QBitArray> bitmap_map;
+
+    bool                                m_valid;
+    int                                 m_change_count;
+    std::vector<VideoMetadata *>        m_rows;
+    QHash<const VideoMetadata *, uint>  m_row_of;
+    bitmap_map                          m_bitmaps[kColumnCount];
+
+    std::map<int, std::vector<uint> >   m_order;
+    std::map<int, std::vector<uint> >   m_rank;
+};
+
+#endif // VIDEOLISTINDEX_H_
@@ -27,6 +27,7 @@ using namespace std;
 #include "mythlogging.h"
 #include "commandlineparser.h"
 #include "recordinginfo.h"
+#include "positionmapfile.h"
 #include "signalhandling.h"
 
 static void CompleteJob(int jobID, ProgramInfo *pginfo, bool useCutlist,
@@ -888,6 +889,18 @@ static void CompleteJob(int jobID, ProgramInfo *pginfo, bool useCutlist,
                     .arg(tmpfile).arg(newfile) + ENO);
         }
 
+        /* The new seek table was saved to the sidecar of the old name. */
+        const QString oldseek = PositionMapFile::GetFilename(filename);
+        const QString newseek = PositionMapFile::GetFilename(newfile);
+        if ((oldseek != newseek) && QFile::exists(oldseek) &&
+            (rename(oldseek.toLocal8Bit().constData(),
+                    newseek.toLocal8Bit().constData()) == -1))
+        {
+            LOG(VB_GENERAL, LOG_ERR,
+                QString("mythtranscode: Error Renaming '%1' to '%2'")
+                    .arg(oldseek).arg(newseek) + ENO);
+        }
+
         if (!gCoreContext->GetNumSetting("SaveTranscoding", 0))
         {
             int err;
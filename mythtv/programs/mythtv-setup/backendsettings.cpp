@@ -204,6 +204,47 @@ static GlobalCheckBox *DeletesFollowLinks()
     return gc;
 };
 
+static GlobalCheckBox *PositionMapSidecar()
+{
+    GlobalCheckBox *gc = new GlobalCheckBox("PositionMapSidecar");
+    gc->setLabel(QObject::tr("Store seek tables next to recordings"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, the seek table of new "
+                    "recordings is written to a small file next to the "
+                    "recording instead of the database, which greatly "
+                    "reduces database load with many concurrent recordings. "
+                    "Use 'mythutil --seektabletofile' to convert the seek "
+                    "tables of existing recordings. Keep this enabled while "
+                    "any recording uses such a file, frontends on other "
+                    "hosts only look for them when it is."));
+    return gc;
+};
+
+static HostCheckBox *WatchVideoDirectories()
+{
+    HostCheckBox *hc = new HostCheckBox("WatchVideoDirectories");
+    hc->setLabel(QObject::tr("Watch video directories for changes"));
+    hc->setValue(false);
+    hc->setHelpText(QObject::tr("If enabled, this backend watches its "
+                    "Videos storage group directories and adds or removes "
+                    "videos as files are added or removed, instead of "
+                    "relying on a full scan of all video directories."));
+    return hc;
+};
+
+static GlobalCheckBox *FastChannelChange()
+{
+    GlobalCheckBox *gc = new GlobalCheckBox("FastChannelChange");
+    gc->setLabel(QObject::tr("Fast channel change"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, the last PAT and PMT seen on "
+                    "each digital channel are remembered and used to start "
+                    "recording as soon as the tuner has a lock, instead of "
+                    "waiting for the tables to be sent again. Tables that "
+                    "have changed since are picked up as they arrive."));
+    return gc;
+};
+
 static GlobalSpinBox *HDRingbufferSize()
 {
     GlobalSpinBox *bs = new GlobalSpinBox(
@@ -603,6 +644,42 @@ static HostComboBox *JobQueueCPU()
     return gc;
 };
 
+static HostSpinBox *JobQueueMaxLoad()
+{
+    HostSpinBox *gc = new HostSpinBox("JobQueueMaxLoad", 0, 400, 10);
+    gc->setLabel(QObject::tr("Maximum system load (%)"));
+    gc->setHelpText(QObject::tr("New jobs will not be started on this "
+                    "backend while the system load average is above this "
+                    "percentage of its CPU cores. Set to 0 to ignore the "
+                    "system load."));
+    gc->setValue(100);
+    return gc;
+};
+
+static HostSpinBox *JobQueueMaxStreams()
+{
+    HostSpinBox *gc = new HostSpinBox("JobQueueMaxStreams", 0, 20, 1);
+    gc->setLabel(QObject::tr("Maximum disk streams"));
+    gc->setHelpText(QObject::tr("Each recording in progress on this backend "
+                    "counts as one stream, commercial flagging as one and "
+                    "transcoding as two. New jobs will not be started if "
+                    "they would take the total above this limit. Set to 0 "
+                    "for no limit."));
+    gc->setValue(6);
+    return gc;
+};
+
+static HostCheckBox *JobQueuePreemptForRecording()
+{
+    HostCheckBox *gc = new HostCheckBox("JobQueuePreemptForRecording");
+    gc->setLabel(QObject::tr("Pause jobs for recordings"));
+    gc->setValue(true);
+    gc->setHelpText(QObject::tr("If enabled, commercial flagging jobs are "
+                    "paused while recordings take the disk streams above "
+                    "the limit, and resumed when they finish."));
+    return gc;
+};
+
 static HostTimeBox *JobQueueWindowStart()
 {
     HostTimeBox *gc = new HostTimeBox("JobQueueWindowStart", "00:00");
@@ -932,6 +1009,8 @@ BackendSettings::BackendSettings() {
     fmh1->addChild(DeletesFollowLinks());
     fmh1->addChild(TruncateDeletes());
     fm->addChild(fmh1);
+    fm->addChild(PositionMapSidecar());
+    fm->addChild(WatchVideoDirectories());
     fm->addChild(HDRingbufferSize());
     fm->addChild(StorageScheduler());
     group2->addChild(fm);
@@ -943,6 +1022,7 @@ BackendSettings::BackendSettings() {
     group2->addChild(MiscStatusScript());
     group2->addChild(DisableAutomaticBackup());
     group2->addChild(DisableFirewireReset());
+    group2->addChild(FastChannelChange());
     addChild(group2);
 
     VerticalConfigurationGroup* group2a1 = new VerticalConfigurationGroup(false);
@@ -992,6 +1072,9 @@ BackendSettings::BackendSettings() {
     group5->setLabel(QObject::tr("Job Queue (Backend-Specific)"));
     group5->addChild(JobQueueMaxSimultaneousJobs());
     group5->addChild(JobQueueCheckFrequency());
+    group5->addChild(JobQueueMaxLoad());
+    group5->addChild(JobQueueMaxStreams());
+    group5->addChild(JobQueuePreemptForRecording());
 
     HorizontalConfigurationGroup* group5a =
               new HorizontalConfigurationGroup(false, false);
@@ -0,0 +1,73 @@
+// C++ headers
+#include <iostream>
+using namespace std;
+
+// libmyth* headers
+#include "exitcodes.h"
+#include "mythlogging.h"
+#include "audiodspbench.h"
+
+// local headers
+#include "audioutils.h"
+
+static void PrintRate(const QString &stage, int samplerate, double rate)
+{
+    if (rate < 0)
+    {
+        cout << QString("%1: failed").arg(stage)
+                    .toLocal8Bit().constData() << endl;
+        return;
+    }
+
+    cout << QString("%1: %2 frames/s, %3x realtime")
+                .arg(stage).arg(rate, 0, 'f', 0)
+                .arg(rate / samplerate, 0, 'f', 1)
+                .toLocal8Bit().constData() << endl;
+}
+
+static int BenchAudio(const MythUtilCommandLineParser &cmdline)
+{
+    int samplerate = cmdline.toInt("samplerate");
+    int outrate    = cmdline.toInt("outrate");
+    float tempo    = cmdline.toDouble("tempo");
+    int frames     = cmdline.toInt("seconds") * samplerate;
+
+    if ((samplerate <= 0) || (outrate <= 0) || (frames <= 0) ||
+        (tempo < 0.5f) || (tempo > 2.0f))
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            "--samplerate, --outrate and --seconds must be positive and "
+            "--tempo between 0.5 and 2");
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Processing %1 frames of %2Hz stereo audio")
+            .arg(frames).arg(samplerate));
+
+    PrintRate("Upmix (simple)", samplerate,
+              AudioDSPBench::Upmix(samplerate, frames, false));
+    PrintRate("Upmix (linear)", samplerate,
+              AudioDSPBench::Upmix(samplerate, frames, true));
+
+    // Same order as the SRCQuality setting: low, medium, high
+    static const char *quality[] = { "low", "medium", "high" };
+    for (int i = 0; i < 3; i++)
+    {
+        PrintRate(QString("Resample to %1Hz (%2)").arg(outrate)
+                      .arg(quality[i]), samplerate,
+                  AudioDSPBench::Resample(samplerate, outrate, frames, i));
+    }
+
+    PrintRate(QString("Timestretch x%1").arg(tempo), samplerate,
+              AudioDSPBench::Timestretch(samplerate, tempo, frames));
+
+    return GENERIC_EXIT_OK;
+}
+
+void registerAudioUtils(UtilMap &utilMap)
+{
+    utilMap["benchaudio"]           = &BenchAudio;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,8 @@
+#ifndef _AUDIO_UTILS_H_
+#define _AUDIO_UTILS_H_
+
+#include "mythutil.h"
+
+void registerAudioUtils(UtilMap &utilMap);
+
+#endif // _AUDIO_UTILS_H_
@@ -11,13 +11,50 @@ MythUtilCommandLineParser::MythUtilCommandLineParser() :
 void MythUtilCommandLineParser::LoadArguments(void)
 {
     CommandLineArg::AllowOneOf( QList<CommandLineArg*>()
+        // audioutils.cpp
+        << add("--benchaudio", "benchaudio", false,
+                "Measure the speed of the audio processing.",
+                "Upmixes, resamples and timestretches generated stereo "
+                "audio and prints the number of frames processed per "
+                "second by each stage.")
+                ->SetGroup("Audio")
+
         // fileutils.cpp
         << add("--copyfile", "copyfile", false,
                 "Copy a MythTV Storage Group file", "")
                 ->SetGroup("File")
                 ->SetRequiredChild(QStringList("infile") << "outfile")
 
+        // filterutils.cpp
+        << add("--benchborders", "benchborders", false,
+                "Measure the speed of the black border scans.",
+                "Runs the luma kernels used by letterbox detection and by "
+                "the commercial flagger's border detector over the frames "
+                "of a raw YUV 4:2:0 file, with and without SIMD, and prints "
+                "the number of frames scanned per second.")
+                ->SetGroup("Video Filters")
+                ->SetRequiredChild(QStringList("infile") << "width"
+                                   << "height")
+        << add("--benchfilter", "benchfilter", "",
+                "Measure the speed of a video filter chain.",
+                "Runs the given filter string, for example "
+                "'yadifdoubleprocessdeint' or 'kerneldeint,denoise3d', "
+                "over the frames of a raw YUV 4:2:0 file and prints the "
+                "number of frames filtered per second.")
+                ->SetGroup("Video Filters")
+                ->SetRequiredChild(QStringList("infile") << "width"
+                                   << "height")
+
         // mpegutils.cpp
+        << add("--benchstartcodes", "benchstartcodes", false,
+                "Measure the speed of the MPEG start code scan.",
+                "Replays the packets of a transport stream file from memory "
+                "through the per packet start code scan DTVRecorder uses and "
+                "through the batch scan over blocks of packets, and prints "
+                "the MB/s of each. The busiest pid is scanned unless --pids "
+                "is given.")
+                ->SetGroup("MPEG-TS")
+                ->SetRequiredChild("infile")
         << add("--pidcounter", "pidcounter", false,
                 "Count pids in a MythTV Storage Group file", "")
                 ->SetGroup("MPEG-TS")
@@ -63,6 +100,15 @@ void MythUtilCommandLineParser::LoadArguments(void)
                 "Clear the commercial skip list.", "")
                 ->SetGroup("Recording Markup")
                 ->SetRequiredChild(QStringList("chanid") << "starttime")
+        << add("--seektabletofile", "seektabletofile", false,
+                "Move the seek table from the database to a file next "
+                "to the recording.",
+                "Moves the recordedseek rows of the recording into a "
+                "sidecar file, as written for new recordings when "
+                "'Store seek tables next to recordings' is enabled. Must "
+                "be run on the host storing the recording.")
+                ->SetGroup("Recording Markup")
+                ->SetRequiredChild(QStringList("chanid") << "starttime")
 
         // backendutils.cpp
         << add("--resched", "resched", false,
@@ -124,7 +170,8 @@ void MythUtilCommandLineParser::LoadArguments(void)
     // mpegutils.cpp
     add("--pids", "pids", "", "Pids to process", "")
         ->SetRequiredChildOf("pidfilter")
-        ->SetRequiredChildOf("pidprinter");
+        ->SetRequiredChildOf("pidprinter")
+        ->SetChildOf("benchstartcodes");
     add("--ptspids", "ptspids", "", "Pids to extract PTS from", "")
         ->SetGroup("MPEG-TS");
     add("--packetsize", "packetsize", 188, "TS Packet Size", "")
@@ -134,6 +181,37 @@ void MythUtilCommandLineParser::LoadArguments(void)
         ->SetChildOf("pidprinter");
     add("--xml", "xml", false, "Enables XML output of PSIP", "")
         ->SetChildOf("pidprinter");
+    add("--passes", "passes", 10, "Times to replay the file", "")
+        ->SetChildOf("benchstartcodes");
+
+    // audioutils.cpp
+    add("--samplerate", "samplerate", 48000,
+            "Sample rate of the generated audio", "")
+        ->SetChildOf("benchaudio");
+    add("--outrate", "outrate", 44100, "Sample rate to resample to", "")
+        ->SetChildOf("benchaudio");
+    add("--tempo", "tempo", 1.5, "Tempo to timestretch to", "")
+        ->SetChildOf("benchaudio");
+    add("--seconds", "seconds", 60, "Seconds of audio to process", "")
+        ->SetChildOf("benchaudio");
+
+    // filterutils.cpp
+    add("--width", "width", 0, "Width of the video in the input file", "")
+        ->SetChildOf(QStringList("benchfilter") << "benchborders");
+    add("--height", "height", 0, "Height of the video in the input file", "")
+        ->SetChildOf(QStringList("benchfilter") << "benchborders");
+    add("--threads", "threads", 1, "Number of threads filters may use", "")
+        ->SetChildOf("benchfilter");
+    add("--frames", "frames", 500, "Number of frames to filter or scan", "")
+        ->SetChildOf(QStringList("benchfilter") << "benchborders");
+    add("--doublerate", "doublerate", false,
+            "Filter both fields of every frame, as for double rate "
+            "deinterlacers", "")
+        ->SetChildOf("benchfilter");
+    add("--compare", "compare", false,
+            "Check that the filters give the same output with and without "
+            "their CPU specific code, instead of timing them", "")
+        ->SetChildOf("benchfilter");
 
     // messageutils.cpp
     add("--udpport", "udpport", 6948, "(optional) UDP Port to send to", "")
@@ -0,0 +1,385 @@
+// C++ headers
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+// Qt headers
+#include <QFile>
+
+extern "C" {
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+}
+
+// libmyth* headers
+#include "exitcodes.h"
+#include "mythlogging.h"
+#include "mythtimer.h"
+#include "filtermanager.h"
+#include "lumascan.h"
+
+// local headers
+#include "filterutils.h"
+
+/// Most frames held in memory, the benchmark loops over them as needed
+static const int kMaxFramesInMemory = 100;
+
+/** \fn LoadFrames(const QString&, int, int, vector<unsigned char*>&)
+ *  \brief Reads up to kMaxFramesInMemory frames of raw YV12 video.
+ *
+ *  Returns GENERIC_EXIT_OK with at least one frame in buffers, which the
+ *  caller frees with av_free(), or the exit code to return.
+ */
+static int LoadFrames(const QString &infile, int width, int height,
+                      vector<unsigned char*> &buffers)
+{
+    if (infile.isEmpty())
+    {
+        LOG(VB_GENERAL, LOG_ERR, "Missing --infile option");
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+
+    if ((width <= 0) || (height <= 0) || (width & 1) || (height & 1))
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            "--width and --height must give the even size of the video");
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+
+    QFile file(infile);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Unable to open %1").arg(infile));
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    // The input is raw planar YUV 4:2:0, as written by
+    // ffmpeg -i <video> -f rawvideo -pix_fmt yuv420p <file>
+    int size = buffersize(FMT_YV12, width, height);
+    int framesize = width * height * 3 / 2;
+    while ((int)buffers.size() < kMaxFramesInMemory)
+    {
+        unsigned char *buf = (unsigned char*)av_malloc(size);
+        if (file.read((char*)buf, framesize) != framesize)
+        {
+            av_free(buf);
+            break;
+        }
+        buffers.push_back(buf);
+    }
+    file.close();
+
+    if (buffers.empty())
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("%1 does not hold a single %2x%3 frame")
+                .arg(infile).arg(width).arg(height));
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    return GENERIC_EXIT_OK;
+}
+
+static void PrintFPS(const QString &stage, int frames, int elapsed)
+{
+    elapsed = max(elapsed, 1);
+    cout << QString("%1: %2 frames in %3 ms, %4 fps")
+                .arg(stage).arg(frames).arg(elapsed)
+                .arg(frames * 1000.0 / elapsed, 0, 'f', 1)
+                .toLocal8Bit().constData() << endl;
+}
+
+/// Loads a filter chain which keeps the frame size, or logs why it can't
+static FilterChain *LoadChain(FilterManager &manager, const QString &filters,
+                              int width, int height, int threads)
+{
+    VideoFrameType inpixfmt = FMT_YV12;
+    VideoFrameType outpixfmt = FMT_YV12;
+    int outwidth = width;
+    int outheight = height;
+    int bufsize = 0;
+    FilterChain *chain = manager.LoadFilters(filters, inpixfmt, outpixfmt,
+                                             outwidth, outheight, bufsize,
+                                             threads);
+    if (!chain)
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("Unable to load filters '%1'").arg(filters));
+        return NULL;
+    }
+
+    if ((outwidth != width) || (outheight != height))
+    {
+        LOG(VB_GENERAL, LOG_ERR, "Filters which change the frame size "
+                                 "can not be benchmarked");
+        delete chain;
+        return NULL;
+    }
+
+    return chain;
+}
+
+static void FilterFrame(FilterChain *chain, VideoFrame *frame, bool doubleRate)
+{
+    chain->ProcessFrame(frame, kScan_Interlaced);
+    if (doubleRate)
+        chain->ProcessFrame(frame, kScan_Intr2ndField);
+}
+
+/** \fn CompareFilter(const QString&, const vector<unsigned char*>&,
+ *                    int, int, int, int, bool)
+ *  \brief Runs the filters twice over copies of the same frames, once
+ *         with the C code and once with the code picked for this CPU,
+ *         and reports the first pixel where the outputs differ.
+ *
+ *  Filters pick their code when they are loaded, from av_get_cpu_flags(),
+ *  so the reference chain is loaded with all CPU flags forced off.
+ */
+static int CompareFilter(const QString &filters,
+                         const vector<unsigned char*> &buffers,
+                         int width, int height, int threads, int frames,
+                         bool doubleRate)
+{
+    FilterManager manager;
+
+    av_force_cpu_flags(0);
+    FilterChain *ref = LoadChain(manager, filters, width, height, threads);
+    av_force_cpu_flags(-1);
+    if (!ref)
+        return GENERIC_EXIT_NOT_OK;
+
+    FilterChain *chain = LoadChain(manager, filters, width, height, threads);
+    if (!chain)
+    {
+        delete ref;
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Comparing '%1' with and without CPU flags 0x%2 over %3 "
+                "frame(s) of %4x%5").arg(filters)
+            .arg(av_get_cpu_flags(), 0, 16).arg(frames)
+            .arg(width).arg(height));
+
+    int size = buffersize(FMT_YV12, width, height);
+    int framesize = width * height * 3 / 2;
+    unsigned char *refbuf = (unsigned char*)av_malloc(size);
+    unsigned char *buf = (unsigned char*)av_malloc(size);
+    int ret = GENERIC_EXIT_OK;
+
+    VideoFrame refframe, frame;
+    for (int i = 0; i < frames && ret == GENERIC_EXIT_OK; i++)
+    {
+        memcpy(refbuf, buffers[i % buffers.size()], framesize);
+        memcpy(buf, buffers[i % buffers.size()], framesize);
+        init(&refframe, FMT_YV12, refbuf, width, height, size);
+        init(&frame, FMT_YV12, buf, width, height, size);
+        refframe.frameNumber = frame.frameNumber = i;
+
+        FilterFrame(ref, &refframe, doubleRate);
+        FilterFrame(chain, &frame, doubleRate);
+
+        const unsigned char *diff =
+            mismatch(refbuf, refbuf + framesize, buf).first;
+        if (diff == refbuf + framesize)
+            continue;
+
+        int offset = diff - refbuf;
+        int plane = 0;
+        int pwidth = width;
+        if (offset >= width * height)
+        {
+            offset -= width * height;
+            plane = 1 + offset / (width * height / 4);
+            offset %= width * height / 4;
+            pwidth = width / 2;
+        }
+        cout << QString("Frame %1 differs first in plane %2 at %3x%4: "
+                        "%5 instead of %6")
+                    .arg(i).arg(plane).arg(offset % pwidth)
+                    .arg(offset / pwidth).arg(buf[diff - refbuf])
+                    .arg(*diff).toLocal8Bit().constData() << endl;
+        ret = GENERIC_EXIT_NOT_OK;
+    }
+
+    if (ret == GENERIC_EXIT_OK)
+    {
+        cout << QString("%1: %2 frames identical")
+                    .arg(filters).arg(frames).toLocal8Bit().constData()
+             << endl;
+    }
+
+    av_free(refbuf);
+    av_free(buf);
+    delete chain;
+    delete ref;
+
+    return ret;
+}
+
+static int BenchFilter(const MythUtilCommandLineParser &cmdline)
+{
+    QString filters = cmdline.toString("benchfilter");
+    QString infile  = cmdline.toString("infile");
+    int width       = cmdline.toInt("width");
+    int height      = cmdline.toInt("height");
+    int threads     = cmdline.toInt("threads");
+    int frames      = cmdline.toInt("frames");
+    bool doubleRate = cmdline.toBool("doublerate");
+
+    vector<unsigned char*> buffers;
+    int ret = LoadFrames(infile, width, height, buffers);
+    if (ret != GENERIC_EXIT_OK)
+        return ret;
+
+    if (cmdline.toBool("compare"))
+    {
+        ret = CompareFilter(filters, buffers, width, height, threads,
+                            frames, doubleRate);
+        for (uint i = 0; i < buffers.size(); i++)
+            av_free(buffers[i]);
+        return ret;
+    }
+
+    int size = buffersize(FMT_YV12, width, height);
+    FilterManager manager;
+    FilterChain *chain = LoadChain(manager, filters, width, height, threads);
+    if (!chain)
+    {
+        for (uint i = 0; i < buffers.size(); i++)
+            av_free(buffers[i]);
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Running '%1' over %2 frame(s) of %3x%4 with %5 thread(s)")
+            .arg(filters).arg(frames).arg(width).arg(height).arg(threads));
+
+    VideoFrame frame;
+    MythTimer timer;
+    timer.start();
+
+    // Frames are filtered in place, so after the first pass over the
+    // buffers each frame has been filtered before. That makes no
+    // difference to the speed of the filters, which is all this measures.
+    for (int i = 0; i < frames; i++)
+    {
+        init(&frame, FMT_YV12, buffers[i % buffers.size()], width, height,
+             size);
+        frame.frameNumber = i;
+        FilterFrame(chain, &frame, doubleRate);
+    }
+
+    PrintFPS(filters, frames, timer.elapsed());
+
+    delete chain;
+    for (uint i = 0; i < buffers.size(); i++)
+        av_free(buffers[i]);
+
+    return GENERIC_EXIT_OK;
+}
+
+/// Luma range of every row and column, as BorderDetector scans them
+static void ScanBorders(const unsigned char *luma, int width, int height)
+{
+    unsigned char minval, maxval;
+    for (int y = 0; y < height; y++)
+    {
+        minval = UCHAR_MAX;
+        maxval = 0;
+        LumaScan::Range(luma + y * width, width, 1, minval, maxval);
+    }
+    for (int x = 0; x < width; x++)
+    {
+        minval = UCHAR_MAX;
+        maxval = 0;
+        LumaScan::Range(luma + x, height, width, minval, maxval);
+    }
+}
+
+/// Luma averages of the lines DetectLetterbox samples, over the whole
+/// top and bottom quarters of the frame
+static uint SampleLetterbox(const unsigned char *luma, int width, int height)
+{
+    static const int kRun = 16;
+    const int xRun[] = { width / 4 - kRun / 2, width / 2 - kRun / 2,
+                         width * 3 / 4 - kRun / 2 };
+    uint total = 0;
+    for (int y = 5; y < height / 4; y++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            total += LumaScan::Sum(luma + y * width + xRun[i], kRun);
+            total += LumaScan::Sum(luma + (height - y - 1) * width + xRun[i],
+                                   kRun);
+        }
+    }
+    return total;
+}
+
+static int BenchBorders(const MythUtilCommandLineParser &cmdline)
+{
+    QString infile  = cmdline.toString("infile");
+    int width       = cmdline.toInt("width");
+    int height      = cmdline.toInt("height");
+    int frames      = cmdline.toInt("frames");
+
+    vector<unsigned char*> buffers;
+    int ret = LoadFrames(infile, width, height, buffers);
+    if (ret != GENERIC_EXIT_OK)
+        return ret;
+
+    if (width < 64 || height < 64)
+    {
+        LOG(VB_GENERAL, LOG_ERR, "Frames must be at least 64x64");
+        for (uint i = 0; i < buffers.size(); i++)
+            av_free(buffers[i]);
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Scanning the borders of %1 frame(s) of %2x%3")
+            .arg(frames).arg(width).arg(height));
+
+    // Each kernel is timed with the SSE2 code, if the CPU has it, and
+    // without, so the two can be compared on the same frames.
+    uint total = 0;
+    for (int simd = 1; simd >= 0; simd--)
+    {
+        QString kind = simd ? "SIMD" : "C";
+        LumaScan::SetSIMD(simd);
+
+        MythTimer timer;
+        timer.start();
+        for (int i = 0; i < frames; i++)
+            ScanBorders(buffers[i % buffers.size()], width, height);
+        PrintFPS(QString("BorderDetector rows and columns (%1)").arg(kind),
+                 frames, timer.elapsed());
+
+        timer.start();
+        for (int i = 0; i < frames; i++)
+            total += SampleLetterbox(buffers[i % buffers.size()],
+                                     width, height);
+        PrintFPS(QString("DetectLetterbox lines (%1)").arg(kind),
+                 frames, timer.elapsed());
+    }
+    LumaScan::SetSIMD(true);
+
+    LOG(VB_GENERAL, LOG_DEBUG, QString("Luma total %1").arg(total));
+
+    for (uint i = 0; i < buffers.size(); i++)
+        av_free(buffers[i]);
+
+    return GENERIC_EXIT_OK;
+}
+
+void registerFilterUtils(UtilMap &utilMap)
+{
+    utilMap["benchborders"]         = &BenchBorders;
+    utilMap["benchfilter"]          = &BenchFilter;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,8 @@
+#ifndef _FILTER_UTILS_H_
+#define _FILTER_UTILS_H_
+
+#include "mythutil.h"
+
+void registerFilterUtils(UtilMap &utilMap);
+
+#endif // _FILTER_UTILS_H_
@@ -15,8 +15,10 @@
 // Local includes
 #include "mythutil.h"
 #include "commandlineparser.h"
+#include "audioutils.h"
 #include "backendutils.h"
 #include "fileutils.h"
+#include "filterutils.h"
 #include "mpegutils.h"
 #include "jobutils.h"
 #include "markuputils.h"
@@ -99,8 +101,10 @@ int main(int argc, char *argv[])
 
     UtilMap utilMap;
 
+    registerAudioUtils(utilMap);
     registerBackendUtils(utilMap);
     registerFileUtils(utilMap);
+    registerFilterUtils(utilMap);
     registerMPEGUtils(utilMap);
     registerJobUtils(utilMap);
     registerMarkupUtils(utilMap);
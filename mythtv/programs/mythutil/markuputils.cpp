@@ -2,6 +2,7 @@
 #include <iostream>
 
 // libmyth* includes
+#include "positionmapfile.h"
 #include "exitcodes.h"
 #include "mythlogging.h"
 
@@ -166,6 +167,53 @@ static int ClearSkipList(const MythUtilCommandLineParser &cmdline)
     return SetMarkupList(cmdline, QString("skiplist"), QString(""));
 }
 
+static int SeekTableToFile(const MythUtilCommandLineParser &cmdline)
+{
+    ProgramInfo pginfo;
+    if (!GetProgramInfo(cmdline, pginfo))
+        return GENERIC_EXIT_NO_RECORDING_DATA;
+
+    QString filename = pginfo.GetPlaybackURL(false, true);
+    if (!filename.startsWith("/"))
+    {
+        cerr << "The recording must be stored on this host\n";
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+
+    static const MarkTypes kSeekTypes[] =
+        { MARK_GOP_BYFRAME, MARK_GOP_START, MARK_KEYFRAME, MARK_DURATION_MS };
+
+    uint total = 0;
+    for (uint i = 0; i < sizeof(kSeekTypes) / sizeof(MarkTypes); i++)
+    {
+        frm_pos_map_t posMap;
+        pginfo.QueryPositionMap(posMap, kSeekTypes[i]);
+        if (posMap.empty())
+            continue;
+
+        frm_pos_map_t saved;
+        if (!PositionMapFile::Save(filename, kSeekTypes[i], posMap) ||
+            !PositionMapFile::Load(filename, kSeekTypes[i], saved) ||
+            saved != posMap)
+        {
+            cerr << "Failed to write seek table file\n";
+            return GENERIC_EXIT_NOT_OK;
+        }
+
+        // The pathname is not local, so this only clears the database rows
+        pginfo.ClearPositionMap(kSeekTypes[i]);
+        total += posMap.size();
+    }
+
+    cout << QString("Moved %1 seek table entries to %2\n")
+        .arg(total).arg(PositionMapFile::GetFilename(filename))
+        .toLocal8Bit().constData();
+    LOG(VB_GENERAL, LOG_NOTICE, QString("Moved %1 seek table entries to %2")
+        .arg(total).arg(PositionMapFile::GetFilename(filename)));
+
+    return GENERIC_EXIT_OK;
+}
+
 void registerMarkupUtils(UtilMap &utilMap)
 {
     utilMap["gencutlist"]             = &CopySkipListToCutList;
@@ -175,6 +223,7 @@ void registerMarkupUtils(UtilMap &utilMap)
     utilMap["getskiplist"]            = &GetSkipList;
     utilMap["setskiplist"]            = &SetSkipList;
     utilMap["clearskiplist"]          = &ClearSkipList;
+    utilMap["seektabletofile"]        = &SeekTableToFile;
 }
 
 /* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -30,6 +30,8 @@
 #include "ringbuffer.h"
 #include "dvbtables.h"
 #include "exitcodes.h"
+#include "mythtimer.h"
+#include "startcode.h"
 
 // Application local headers
 #include "mpegutils.h"
@@ -842,8 +844,176 @@ static int pid_printer(const MythUtilCommandLineParser &cmdline)
     return GENERIC_EXIT_OK;
 }
 
+/// Scans one TS packet's payload the way DTVRecorder does for each
+/// video packet it is handed by MPEGStreamData.
+static uint scan_start_codes(const TSPacket &tspacket, uint pid,
+                             uint32_t &start_code)
+{
+    if (tspacket.PID() != pid || tspacket.TransportError() ||
+        tspacket.Scrambled() || !tspacket.HasPayload() ||
+        tspacket.AFCOffset() >= TSPacket::kSize)
+    {
+        return 0;
+    }
+
+    if (tspacket.PayloadStart())
+        start_code = 0xffffffff;
+
+    uint found = 0;
+    const uint8_t *bufptr = tspacket.data() + tspacket.AFCOffset();
+    const uint8_t *bufend = tspacket.data() + TSPacket::kSize;
+    while (bufptr < bufend)
+    {
+        bufptr = find_start_code(bufptr, bufend, &start_code);
+        if ((start_code & 0xffffff00) == 0x00000100)
+            found++;
+    }
+    return found;
+}
+
+static void print_scan_speed(const QString &stage, uint codes,
+                             long long bytes, int elapsed)
+{
+    elapsed = max(elapsed, 1);
+    LOG(VB_STDIO|VB_FLUSH, LOG_CRIT,
+        QString("%1: %2 start codes in %3 ms, %4 MB/s\n")
+        .arg(stage).arg(codes).arg(elapsed)
+        .arg(bytes * 1000.0 / elapsed / (1024 * 1024), 0, 'f', 1));
+}
+
+static int bench_start_codes(const MythUtilCommandLineParser &cmdline)
+{
+    if (cmdline.toString("infile").isEmpty())
+    {
+        LOG(VB_STDIO|VB_FLUSH, LOG_ERR, "Missing --infile option\n");
+        return GENERIC_EXIT_INVALID_CMDLINE;
+    }
+    QString src = cmdline.toString("infile");
+
+    RingBuffer *srcRB = RingBuffer::Create(src, false);
+    if (!srcRB)
+    {
+        LOG(VB_STDIO|VB_FLUSH, LOG_ERR, "Couldn't open input URL\n");
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    // Load the synced packets of the file into one contiguous block, so
+    // both scans below replay exactly the same packets from memory.
+    const int kBufSize = 2 * 1024 * 1024;
+    const long long kMaxBytes = 512 * 1024 * 1024;
+    long long pid_count[0x2000];
+    memset(pid_count, 0, sizeof(pid_count));
+    char *buffer = new char[kBufSize];
+    QByteArray packets;
+    int offset = 0;
+
+    while (packets.size() + kBufSize <= kMaxBytes)
+    {
+        int r = srcRB->Read(&buffer[offset], kBufSize - offset);
+        if (r <= 0)
+            break;
+        int pos = 0;
+        int len = offset + r;
+        while (pos + 187 < len) // while we have a whole packet left
+        {
+            if (buffer[pos] != SYNC_BYTE)
+            {
+                pos = resync_stream(buffer, pos+1, len, TSPacket::kSize);
+                if (pos < 0)
+                {
+                    pos = len;
+                    break;
+                }
+            }
+            int pid = ((buffer[pos+1]<<8) | buffer[pos+2]) & 0x1fff;
+            pid_count[pid]++;
+            packets.append(buffer + pos, TSPacket::kSize);
+            pos += TSPacket::kSize;
+        }
+
+        offset = len - pos;
+        if (offset > 0)
+            memmove(buffer, buffer + pos, offset);
+    }
+
+    delete[] buffer;
+    delete srcRB;
+
+    // Scan the given pid, or the busiest one which is normally the video
+    QHash<uint,bool> use_pid = extract_pids(cmdline.toString("pids"), false);
+    uint pid = 0;
+    if (!use_pid.empty())
+    {
+        pid = use_pid.begin().key();
+    }
+    else
+    {
+        for (uint i = 1; i < 0x1fff; i++)
+            pid = (pid_count[i] > pid_count[pid]) ? i : pid;
+    }
+
+    const uint count = packets.size() / TSPacket::kSize;
+    if (!count)
+    {
+        LOG(VB_STDIO|VB_FLUSH, LOG_ERR, "No TS packets found\n");
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(packets.data());
+    const uint kBlockPackets = 512;
+    const uint passes = max(cmdline.toUInt("passes"), 1U);
+    const long long bytes = (long long)count * TSPacket::kSize * passes;
+
+    LOG(VB_STDIO|VB_FLUSH, LOG_CRIT,
+        QString("Scanning PID 0x%1, %2 of %3 packets, %4 pass(es)\n")
+        .arg(pid,4,16,QChar('0')).arg(pid_count[pid]).arg(count)
+        .arg(passes));
+
+    MythTimer timer;
+    timer.start();
+    uint per_packet = 0;
+    for (uint i = 0; i < passes; i++)
+    {
+        uint32_t start_code = 0xffffffff;
+        for (uint j = 0; j < count; j++)
+        {
+            const TSPacket *pkt = reinterpret_cast<const TSPacket*>(
+                data + j * TSPacket::kSize);
+            per_packet += scan_start_codes(*pkt, pid, start_code);
+        }
+    }
+    print_scan_speed("Per packet", per_packet, bytes, timer.elapsed());
+
+    timer.start();
+    uint batch = 0;
+    vector<TSStartCode> codes;
+    codes.reserve(kBlockPackets);
+    for (uint i = 0; i < passes; i++)
+    {
+        uint32_t start_code = 0xffffffff;
+        for (uint j = 0; j < count; j += kBlockPackets)
+        {
+            codes.clear();
+            batch += find_ts_start_codes(
+                data + j * TSPacket::kSize, min(kBlockPackets, count - j),
+                pid, &start_code, codes);
+        }
+    }
+    print_scan_speed("Batch", batch, bytes, timer.elapsed());
+
+    if (batch != per_packet)
+    {
+        LOG(VB_STDIO|VB_FLUSH, LOG_ERR,
+            "The batch scan found a different number of start codes\n");
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    return GENERIC_EXIT_OK;
+}
+
 void registerMPEGUtils(UtilMap &utilMap)
 {
+    utilMap["benchstartcodes"] = &bench_start_codes;
     utilMap["pidcounter"] = &pid_counter;
     utilMap["pidfilter"]  = &pid_filter;
     utilMap["pidprinter"] = &pid_printer;